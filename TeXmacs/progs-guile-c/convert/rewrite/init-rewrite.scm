@@ -47,6 +47,25 @@
 (converter texmacs-tree texmacs-snippet
   (:function serialize-texmacs-snippet))
 
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;; Binary format for TeXmacs (no information loss)
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+
+(define (tmb-recognizes? s)
+  (and (string? s) (>= (string-length s) 4)
+       (string=? (substring s 1 4) "TMB")))
+
+(define-format tmb
+  (:name "TeXmacs Binary")
+  (:suffix "tmb")
+  (:must-recognize tmb-recognizes?))
+
+(converter tmb-document texmacs-tree
+  (:function parse-texmacs-binary))
+
+(converter texmacs-tree tmb-document
+  (:function serialize-texmacs-binary))
+
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 ;; Scheme format for TeXmacs (no information loss)
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
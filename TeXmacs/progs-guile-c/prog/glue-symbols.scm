@@ -598,6 +598,8 @@
 "tmdb-inspect-history"
 "tmdb-get-completions"
 "tmdb-get-name-completions"
+"tmdb-get-fuzzy-completions"
+"tmdb-get-fuzzy-name-completions"
 "supports-sql?"
 "sql-exec"
 "sql-quote"
@@ -613,12 +615,14 @@
 "enter-secure-mode"
 "connection-start"
 "connection-status"
+"connection-statistics"
 "connection-write-string"
 "connection-write"
 "connection-cmd"
 "connection-eval"
 "connection-interrupt"
 "connection-stop"
+"set-plugin-grace-period"
 "widget-printer"
 "widget-color-picker"
 "widget-extend"
@@ -699,6 +703,9 @@
 "buffer-import"
 "buffer-load"
 "buffer-export"
+"buffer-autosave"
+"buffer-autosave-cancel"
+"buffer-autosave-failed?"
 "buffer-save"
 "tree-import-loaded"
 "tree-import"
@@ -1093,6 +1100,7 @@
 "cpp-nr-pages"
 "print-to-file"
 "print-pages-to-file"
+"print-part-to-file"
 "print"
 "print-pages"
 "print-snippet"
@@ -354,14 +354,16 @@
        (== (most-recent-suffix name) "#")))
 
 (define (autosave-remove name)
+  (buffer-autosave-cancel (url-glue name "~"))
   (when (url-exists? (url-glue name "~"))
     (url-remove (url-glue name "~")))
   (when (url-exists? (url-glue name "#"))
     (url-remove (url-glue name "#"))))
 
 (tm-define (autosave-buffer name)
-  (when (and (buffer-modified-since-autosave? name)
-             (url-autosave name "~"))
+  (when (and (url-autosave name "~")
+             (or (buffer-modified-since-autosave? name)
+                 (buffer-autosave-failed? (url-autosave name "~"))))
     ;;(display* "Autosave " name "\n")
     ;; FIXME: incorrectly autosaves after cursor movements only
     (let* ((vname `(verbatim ,(url->system name)))
@@ -373,7 +375,7 @@
              (when (not (rescue-mode?))
                (set-message `(concat "Warning: " ,vname " not auto-saved")
                             "Auto-save file")))
-            ((buffer-export name aname fm)
+            ((buffer-autosave name aname fm)
              (when (not (rescue-mode?))
                (set-message `(concat "Failed to auto-save " ,vname)
                             "Auto-save file")))
@@ -162,5 +162,11 @@
 (tm-define (index-get-name-completions prefix)
   (tmdb-get-name-completions (db-get-db) prefix))
 
+(tm-define (index-get-fuzzy-completions prefix)
+  (tmdb-get-fuzzy-completions (db-get-db) prefix))
+
+(tm-define (index-get-fuzzy-name-completions prefix)
+  (tmdb-get-fuzzy-name-completions (db-get-db) prefix))
+
 (tm-define (prefix->queries q)
   (list (list :completes q)))
@@ -596,6 +596,8 @@
 "tmdb-inspect-history"
 "tmdb-get-completions"
 "tmdb-get-name-completions"
+"tmdb-get-fuzzy-completions"
+"tmdb-get-fuzzy-name-completions"
 "supports-sql?"
 "sql-exec"
 "sql-quote"
@@ -611,12 +613,14 @@
 "enter-secure-mode"
 "connection-start"
 "connection-status"
+"connection-statistics"
 "connection-write-string"
 "connection-write"
 "connection-cmd"
 "connection-eval"
 "connection-interrupt"
 "connection-stop"
+"set-plugin-grace-period"
 "widget-printer"
 "widget-color-picker"
 "widget-extend"
@@ -697,6 +701,9 @@
 "buffer-import"
 "buffer-load"
 "buffer-export"
+"buffer-autosave"
+"buffer-autosave-cancel"
+"buffer-autosave-failed?"
 "buffer-save"
 "tree-import-loaded"
 "tree-import"
@@ -1090,6 +1097,7 @@
 "cpp-nr-pages"
 "print-to-file"
 "print-pages-to-file"
+"print-part-to-file"
 "print"
 "print-pages"
 "print-snippet"
@@ -61,6 +61,11 @@
 (define (notify-bibtex-command var val)
   (set-bibtex-command val))
 
+(define (notify-plugin-grace-period var val)
+  (let ((ms (string->number val)))
+    (if (and (integer? ms) (exact? ms))
+        (set-plugin-grace-period ms))))
+
 (define (notify-tool var val)
   ;; FIXME: the menus sometimes don't get updated,
   ;; but the fix below does not work
@@ -111,6 +116,7 @@
   ("security" "prompt on scripts" notify-security)
   ("latex command" "pdflatex" notify-latex-command)
   ("bibtex command" "bibtex" notify-bibtex-command)
+  ("plugin grace period" "2000" notify-plugin-grace-period)
   ("scripting language" "none" notify-scripting-language)
   ("database tool" "off" notify-tool)
   ("debugging tool" "off" notify-tool)
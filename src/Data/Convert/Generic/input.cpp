@@ -155,6 +155,30 @@ texmacs_input_rep::put (char c) { // returns true when expecting input
   return block_done;
 }
 
+static inline bool
+is_plain (char c) {
+  // characters which neither change the state of the parser
+  // nor complete a line or a tag for an incremental flush
+  return c != DATA_ESCAPE && c != DATA_BEGIN && c != DATA_ABORT &&
+         c != DATA_END && c != '\n' && c != '>';
+}
+
+bool
+texmacs_input_rep::put (string s) { // returns true when expecting input
+  bool block_done= false;
+  int i= 0, n= N(s);
+  while (i < n) {
+    if (status == STATUS_NORMAL && is_plain (s[i])) {
+      // runs of plain characters are appended at once, without flushing
+      int start= i;
+      while (i < n && is_plain (s[i])) i++;
+      buf << s (start, i);
+    }
+    else if (put (s[i++])) block_done= true;
+  }
+  return block_done;
+}
+
 void
 texmacs_input_rep::bof () {
   format = "verbatim";
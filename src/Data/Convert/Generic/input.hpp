@@ -31,6 +31,7 @@ struct texmacs_input_rep: concrete_struct {
   void begin_channel (string s);
   void end ();
   bool put (char c);
+  bool put (string s);
   void bof ();
   void eof ();
   void write (tree t);
@@ -14,9 +14,14 @@
 #include "path.hpp"
 #include "vars.hpp"
 #include "drd_std.hpp"
+#include "file.hpp"
+#include <string.h>
 
 /******************************************************************************
-* Conversion of TeXmacs strings of the present format to TeXmacs trees
+* Conversion of TeXmacs strings of the present format to TeXmacs trees.
+* The reader works directly on the bytes of a (possibly memory mapped)
+* buffer; atoms are copied in one piece from the buffer whenever they
+* contain no line continuations.
 ******************************************************************************/
 
 struct tm_reader {
@@ -25,29 +30,34 @@ struct tm_reader {
   tree_label EXPAND_APPLY;    // APPLY (version < 0.3.3.22) or EXPAND (otherw)
   bool    backslash_ok;       // true for versions >= 1.0.1.23
   bool    with_extensions;    // true for versions >= 1.0.2.4
-  string  buf;                // the string being read from
+  mapped_file mf;             // the data being read from
+  const char* buf;            // the bytes of the data
+  int     n;                  // the number of bytes
   int     pos;                // the current position of the reader
   string  last;               // last read string
 
-  tm_reader (string buf2):
+  tm_reader (mapped_file mf2):
     version (TEXMACS_VERSION),
     codes (STD_CODE),
     EXPAND_APPLY (EXPAND),
     backslash_ok (true),
     with_extensions (true),
-    buf (buf2), pos (0), last ("") {}
-  tm_reader (string buf2, string version2):
+    mf (mf2), buf (mf->data), n (mf->size), pos (0), last ("") {}
+  tm_reader (mapped_file mf2, string version2):
     version (version2),
     codes (get_codes (version)),
     EXPAND_APPLY (version_inf (version, "0.3.3.22")? APPLY: EXPAND),
     backslash_ok (version_inf (version, "1.0.1.23")? false: true),
     with_extensions (version_inf (version, "1.0.2.4")? false: true),
-    buf (buf2), pos (0), last ("") {}
+    mf (mf2), buf (mf->data), n (mf->size), pos (0), last ("") {}
 
   int    skip_blank ();
   string decode (string s);
-  string read_char ();
+  int    read_char ();
+  string read_slice ();
+  string read_text ();
   string read_next ();
+  string read_raw_data ();
   string read_function_name ();
   tree   read_apply (string s, bool skip_flag);
   tree   read (bool skip_flag);
@@ -55,20 +65,23 @@ struct tm_reader {
 
 int
 tm_reader::skip_blank () {
-  int n=0;
-  for (; pos < N(buf); pos++) {
+  int nr=0;
+  for (; pos < n; pos++) {
     if (buf[pos]==' ') continue;
     if (buf[pos]=='\t') continue;
     if (buf[pos]=='\r') continue;
-    if (buf[pos]=='\n') { n++; continue; }
+    if (buf[pos]=='\n') { nr++; continue; }
     break;
   }
-  return n;
+  return nr;
 }
 
 string
 tm_reader::decode (string s) {
   int i, n=N(s);
+  for (i=0; i<n; i++)
+    if (s[i] == '\\') break;
+  if (i == n) return s;
   string r;
   for (i=0; i<n; i++)
     if (((i+1)<n) && (s[i]=='\\')) {
@@ -86,23 +99,70 @@ tm_reader::decode (string s) {
   return r;
 }
 
-string
+int
 tm_reader::read_char () {
-  while (((pos+1) < N(buf)) && (buf[pos] == '\\') && (buf[pos+1] == '\n')) {
+  // the next character, or -1 at the end of the buffer
+  while (((pos+1) < n) && (buf[pos] == '\\') && (buf[pos+1] == '\n')) {
     pos += 2;
-    skip_spaces (buf, pos);
+    while ((pos < n) && ((buf[pos] == ' ') || (buf[pos] == '\t'))) pos++;
+  }
+  if (pos >= n) return -1;
+  return (unsigned char) buf[pos++];
+}
+
+static inline bool
+is_separator (char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n' ||
+         c == '<' || c == '|' || c == '>';
+}
+
+string
+tm_reader::read_slice () {
+  // atoms without line continuations are taken from the buffer in one piece
+  int i= pos;
+  while (i < n && !is_separator (buf[i])) {
+    if (buf[i] != '\\') { i++; continue; }
+    if (i+1 < n && buf[i+1] == '\n') return read_text ();
+    if (i+2 < n && buf[i+1] == '\\' && buf[i+2] == '\n') return read_text ();
+    i= std::min (i+2, n);
+  }
+  string r (buf + pos, i - pos);
+  pos= i;
+  return r;
+}
+
+string
+tm_reader::read_text () {
+  string r;
+  while (true) {
+    int old_pos= pos;
+    int c= read_char ();
+    if (c < 0) return r;
+    else if (c == '\\') {
+      if ((pos < n) && (buf[pos] == '\\') && backslash_ok) {
+        r << "\\\\";
+        pos++;
+      }
+      else {
+        r << '\\';
+        c= read_char ();
+        if (c >= 0) r << (char) c;
+      }
+    }
+    else if (is_separator ((char) c)) {
+      pos= old_pos;
+      return r;
+    }
+    else r << (char) c;
   }
-  if (pos >= N(buf)) return "";
-  pos++;
-  return buf (pos-1, pos);
 }
 
 string
 tm_reader::read_next () {
   int old_pos= pos;
-  string c= read_char ();
-  if (c == "") return c;
-  switch (c[0]) {
+  int c= read_char ();
+  if (c < 0) return "";
+  switch (c) {
   case '\t':
   case '\n':
   case '\r':
@@ -114,50 +174,41 @@ tm_reader::read_next () {
     {
       old_pos= pos;
       c= read_char ();
-      if (c == "") return "";
-      if (c == "#") return "<#";
-      if ((c == "\\") || (c == "|") || (c == "/")) return "<" * c;
-      if (is_iso_alpha (c[0]) || (c == ">")) {
-        pos= old_pos;
-        return "<";
-      }
+      if (c < 0) return "";
+      if (c == '#') return "<#";
+      if (c == '\\') return "<\\";
+      if (c == '|') return "<|";
+      if (c == '/') return "</";
       pos= old_pos;
       return "<";
-      /*
-      string d= read_char ();
-      if ((d == "\\") || (d == "|") || (d == "/")) return "<" * c * d;
-      pos= old_pos;
-      return "<" * c;
-      */
     }
   case '|':
+    return "|";
   case '>':
-    return c;
+    return ">";
   }
 
-  string r;
-  pos= old_pos;
-  while (true) {
-    old_pos= pos;
-    c= read_char ();
-    if (c == "") return r;
-    else if (c == "\\") {
-      if ((pos < N(buf)) && (buf[pos] == '\\') && backslash_ok) {
-        r << c << "\\";
-        pos++;
-      }
-      else r << c << read_char ();
-    }
-    else if (c == "\t") break;
-    else if (c == "\r") break;
-    else if (c == "\n") break;
-    else if (c == " ") break;
-    else if (c == "<") break;
-    else if (c == "|") break;
-    else if (c == ">") break;
-    else r << c;
-  }
   pos= old_pos;
+  return read_slice ();
+}
+
+static inline int
+hex_value (char c) {
+  if ((c >= '0') && (c <= '9')) return (int) (c - '0');
+  if ((c >= 'A') && (c <= 'F')) return (int) (c + 10 - 'A');
+  if ((c >= 'a') && (c <= 'f')) return (int) (c + 10 - 'a');
+  return 0;
+}
+
+string
+tm_reader::read_raw_data () {
+  int end= pos;
+  while ((end+2 < n) && (buf[end] != '>')) end += 2;
+  string r ((end - pos) >> 1);
+  for (int i=0; pos < end; i++, pos += 2)
+    if (buf[pos] == '-') r[i]= (char) (-hex_value (buf[pos+1]));
+    else r[i]= (char) ((hex_value (buf[pos]) << 4) + hex_value (buf[pos+1]));
+  if ((pos < n) && (buf[pos] == '>')) pos++;
   return r;
 }
 
@@ -197,7 +248,7 @@ tm_reader::read_apply (string name, bool skip_flag) {
   }
 
   bool closed= !skip_flag;
-  while (pos < N(buf)) {
+  while (pos < n) {
     // cout << "last= " << last << LF;
     bool sub_flag= (skip_flag) && ((last == "") || (last[N(last)-1] != '|'));
     if (sub_flag) (void) skip_blank ();
@@ -271,12 +322,7 @@ tm_reader::read (bool skip_flag) {
         break;
       }
       else if (last[N(last)-1] == '#') {
-        string r;
-        while ((buf[pos] != '>') && (pos+2<N(buf))) {
-          r << ((char) from_hexadecimal (buf (pos, pos+2)));
-          pos += 2;
-        }
-        if (buf[pos] == '>') pos++;
+        string r= read_raw_data ();
         flush (D, C, S, spc_flag, ret_flag);
         C << tree (RAW_DATA, r);
         last= read_next ();
@@ -333,13 +379,13 @@ tm_reader::read (bool skip_flag) {
 
 tree
 texmacs_to_tree (string s) {
-  tm_reader tmr (s);
+  tm_reader tmr ((mapped_file (s)));
   return tmr.read (true);
 }
 
 tree
 texmacs_to_tree (string s, string version) {
-  tm_reader tmr (s, version);
+  tm_reader tmr (mapped_file (s), version);
   return tmr.read (true);
 }
 
@@ -355,6 +401,8 @@ is_expand (tree t, string s, int n) {
   return (L(t) == EXPAND) && (N(t) == n+1) && (t[0] == s);
 }
 
+static tree texmacs_document_to_tree (mapped_file mf);
+
 tree
 texmacs_document_to_tree (string s) {
   tree error (LABEL_ERROR, "bad format or data");
@@ -387,31 +435,57 @@ texmacs_document_to_tree (string s) {
           << compound ("final", t[4])
           << compound ("references", t[5])
           << compound ("auxiliary", t[6]);
-    return upgrade (doc, version);
+    tree r= upgrade (doc, version);
+    intern_atoms (r);
+    return r;
   }
 
-  if (starts (s, "<TeXmacs|")) {
-    int i;
-    for (i=9; i<N(s); i++)
-      if (s[i] == '>') break;
-    string version= s (9, i);
-    tree doc= texmacs_to_tree (s, version);
-    if (is_compound (doc, "TeXmacs", 1) ||
-        is_expand (doc, "TeXmacs", 1) ||
-        is_apply (doc, "TeXmacs", 1))
-      doc= tree (DOCUMENT, doc);
-    if (!is_document (doc)) return error;
-    if (N(doc) == 0 || !is_compound (doc[0], "TeXmacs", 1)) {
-      tree d (DOCUMENT);
-      d << compound ("TeXmacs", version);
-      d << A(doc);
-      doc= d;
-    }
-    return upgrade (doc, version);
-  }
+  if (starts (s, "<TeXmacs|"))
+    return texmacs_document_to_tree (mapped_file (s));
   return error;
 }
 
+static bool
+starts (mapped_file mf, const char* s) {
+  int n= strlen (s);
+  return mf->size >= n && memcmp (mf->data, s, n) == 0;
+}
+
+static tree
+texmacs_document_to_tree (mapped_file mf) {
+  tree error (LABEL_ERROR, "bad format or data");
+  if (mf->error || !starts (mf, "<TeXmacs|")) return error;
+  int i;
+  for (i=9; i<mf->size; i++)
+    if (mf->data[i] == '>') break;
+  string version (mf->data + 9, i - 9);
+  tm_reader tmr (mf, version);
+  tree doc= tmr.read (true);
+  if (is_compound (doc, "TeXmacs", 1) ||
+      is_expand (doc, "TeXmacs", 1) ||
+      is_apply (doc, "TeXmacs", 1))
+    doc= tree (DOCUMENT, doc);
+  if (!is_document (doc)) return error;
+  if (N(doc) == 0 || !is_compound (doc[0], "TeXmacs", 1)) {
+    tree d (DOCUMENT);
+    d << compound ("TeXmacs", version);
+    d << A(doc);
+    doc= d;
+  }
+  tree r= upgrade (doc, version);
+  intern_atoms (r);
+  return r;
+}
+
+tree
+texmacs_document_to_tree (url u) {
+  // documents in the present format are read straight from the mapped file
+  mapped_file mf (u);
+  if (mf->error) return tree (LABEL_ERROR, "bad format or data");
+  if (starts (mf, "<TeXmacs|")) return texmacs_document_to_tree (mf);
+  return texmacs_document_to_tree (string (mf->data, mf->size));
+}
+
 /******************************************************************************
 * Extracting attributes from a TeXmacs document tree
 ******************************************************************************/
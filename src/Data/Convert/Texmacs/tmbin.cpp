@@ -0,0 +1,322 @@
+
+/******************************************************************************
+* MODULE     : tmbin.cpp
+* DESCRIPTION: compact binary format for TeXmacs documents
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "Texmacs/tmbin.hpp"
+#include "convert.hpp"
+
+#define TMB_MAGIC "\211TMB\r\n\032\n"
+#define TMB_MAGIC_LEN 8
+#define TMB_FORMAT 2
+#define TMB_SHARE 32 // atoms up to this length are shared when decoded
+
+bool
+is_texmacs_binary (string s) {
+  return N(s) > TMB_MAGIC_LEN && starts (s, string (TMB_MAGIC, TMB_MAGIC_LEN));
+}
+
+/******************************************************************************
+* Conversion of TeXmacs trees to the binary format
+******************************************************************************/
+
+static void
+write_int (string& buf, int x) {
+  unsigned int u= (unsigned int) x;
+  while (u >= 128) {
+    buf << ((char) ((u & 127) | 128));
+    u >>= 7;
+  }
+  buf << ((char) u);
+}
+
+static void
+write_string (string& buf, string s) {
+  write_int (buf, N(s));
+  buf << s;
+}
+
+struct tmb_writer {
+  hashmap<int,int>    label_code;  // index of a label in the table
+  array<string>       label_names; // the table of labels
+  hashmap<string,int> atom_code;   // index of an atom in the pool
+  array<string>       atom_list;   // the pool of atoms
+  string              buf;         // the encoded tree
+
+  tmb_writer (): label_code (-1), atom_code (-1) {}
+  void collect (tree t);
+  void write (tree t);
+};
+
+void
+tmb_writer::collect (tree t) {
+  if (is_atomic (t)) {
+    if (!atom_code->contains (t->label)) {
+      atom_code (t->label)= N(atom_list);
+      atom_list << t->label;
+    }
+  }
+  else {
+    int l= (int) L(t);
+    if (!label_code->contains (l)) {
+      label_code (l)= N(label_names);
+      label_names << as_string (L(t));
+    }
+    int i, n= N(t);
+    for (i=0; i<n; i++) collect (t[i]);
+  }
+}
+
+void
+tmb_writer::write (tree t) {
+  if (is_atomic (t)) write_int (buf, atom_code[t->label] << 1);
+  else {
+    int i, n= N(t);
+    write_int (buf, (label_code[(int) L(t)] << 1) + 1);
+    write_int (buf, n);
+    int start= N(buf);
+    buf << string ('\0', 4);
+    for (i=0; i<n; i++) write (t[i]);
+    unsigned int size= (unsigned int) (N(buf) - start - 4);
+    for (i=0; i<4; i++, size >>= 8)
+      buf[start+i]= (char) (size & 255);
+  }
+}
+
+static string
+document_version (tree t) {
+  if (is_document (t) && N(t) > 0 && is_compound (t[0], "TeXmacs", 1) &&
+      is_atomic (t[0][0])) return t[0][0]->label;
+  return TEXMACS_VERSION;
+}
+
+string
+tree_to_texmacs_binary (tree t) {
+  tmb_writer tmw;
+  tmw.collect (t);
+  tmw.write (t);
+
+  int i;
+  string r (TMB_MAGIC, TMB_MAGIC_LEN);
+  r << ((char) TMB_FORMAT);
+  write_string (r, document_version (t));
+  write_int (r, N(tmw.label_names));
+  for (i=0; i<N(tmw.label_names); i++)
+    write_string (r, tmw.label_names[i]);
+  write_int (r, N(tmw.atom_list));
+  for (i=0; i<N(tmw.atom_list); i++)
+    write_string (r, tmw.atom_list[i]);
+  r << tmw.buf;
+  return r;
+}
+
+/******************************************************************************
+* Reading the binary format
+******************************************************************************/
+
+texmacs_binary_rep::texmacs_binary_rep (url u): mf (u) { open (); }
+texmacs_binary_rep::texmacs_binary_rep (string s): mf (s) { open (); }
+
+bool
+texmacs_binary_rep::read_int (int& pos, int& x) {
+  unsigned int u= 0;
+  int shift;
+  for (shift=0; shift<32 && pos<size; shift+=7) {
+    unsigned char c= (unsigned char) data[pos++];
+    u |= ((unsigned int) (c & 127)) << shift;
+    if (c < 128) {
+      x= (int) u;
+      if (x >= 0) return true;
+      break;
+    }
+  }
+  error= true;
+  return false;
+}
+
+bool
+texmacs_binary_rep::read_node (int& pos, int& tag, int& arity, int& end) {
+  // Reads the header of the node at pos; arity is -1 for atoms and
+  // end is set to the position after the node
+  if (!read_int (pos, tag)) return false;
+  if ((tag & 1) == 0) {
+    if ((tag >> 1) >= N(atom_pos)) { error= true; return false; }
+    arity= -1;
+    end  = pos;
+    return true;
+  }
+  if ((tag >> 1) >= N(labels) || !read_int (pos, arity) || pos+4 > size) {
+    error= true;
+    return false;
+  }
+  const unsigned char* p= (const unsigned char*) (data + pos);
+  unsigned int sz= ((unsigned int) p[0]) | (((unsigned int) p[1]) << 8) |
+                   (((unsigned int) p[2]) << 16) | (((unsigned int) p[3]) << 24);
+  pos += 4;
+  if (sz > (unsigned int) (size - pos)) { error= true; return false; }
+  end= pos + (int) sz;
+  return true;
+}
+
+void
+texmacs_binary_rep::open () {
+  data = mf->data;
+  size = mf->size;
+  error= mf->error;
+  root = -1;
+  body = -1;
+  if (error) return;
+  if (size <= TMB_MAGIC_LEN ||
+      string (data, TMB_MAGIC_LEN) != string (TMB_MAGIC, TMB_MAGIC_LEN) ||
+      data[TMB_MAGIC_LEN] != TMB_FORMAT) {
+    error= true;
+    return;
+  }
+
+  int i, n, len, pos= TMB_MAGIC_LEN + 1;
+  if (!read_int (pos, len)) return;
+  if (len > size - pos) { error= true; return; }
+  version= string (data + pos, len);
+  pos += len;
+  if (!read_int (pos, n)) return;
+  for (i=0; i<n; i++) {
+    if (!read_int (pos, len)) return;
+    if (len > size - pos) { error= true; return; }
+    labels << make_tree_label (string (data + pos, len));
+    pos += len;
+  }
+  if (!read_int (pos, n)) return;
+  for (i=0; i<n; i++) {
+    if (!read_int (pos, len)) return;
+    if (len > size - pos) { error= true; return; }
+    atom_pos << pos;
+    atom_len << len;
+    atoms    << string ();
+    pos += len;
+  }
+  root= pos;
+
+  // Locate the paragraphs of the body, without decoding them
+  int tag, arity, end;
+  if (!read_node (pos, tag, arity, end)) return;
+  if (arity < 0 || labels[tag >> 1] != DOCUMENT) return;
+  for (i=0; i<arity; i++) {
+    int sub_tag, sub_arity, sub_end;
+    if (!read_node (pos, sub_tag, sub_arity, sub_end)) return;
+    if (sub_arity == 1 && as_string (labels[sub_tag >> 1]) == "body") {
+      int start= pos, par_tag, m, j;
+      if (!read_node (pos, par_tag, m, end)) return;
+      if (m < 0 || labels[par_tag >> 1] != DOCUMENT) return;
+      for (j=0; j<m; j++) {
+        par_pos << pos;
+        pars    << tree ();
+        done    << false;
+        if (!read_node (pos, tag, arity, end)) return;
+        pos= end;
+      }
+      body= start;
+      return;
+    }
+    pos= sub_end;
+  }
+}
+
+/******************************************************************************
+* Materializing the document
+******************************************************************************/
+
+string
+texmacs_binary_rep::get_atom (int i) {
+  int len= atom_len[i];
+  if (len > TMB_SHARE) return string (data + atom_pos[i], len);
+  if (N(atoms[i]) != len) atoms[i]= intern (string (data + atom_pos[i], len));
+  return atoms[i];
+}
+
+tree
+texmacs_binary_rep::decode (int& pos) {
+  int start= pos, tag, arity, end;
+  if (error || !read_node (pos, tag, arity, end)) return "";
+  if (arity < 0) return tree (get_atom (tag >> 1));
+  if (start == body) {
+    int i, n= N(par_pos);
+    tree r (DOCUMENT, n);
+    for (i=0; i<n; i++) r[i]= get_paragraph (i);
+    pos= end;
+    return r;
+  }
+  int i;
+  tree r (labels[tag >> 1], arity);
+  for (i=0; i<arity; i++) {
+    if (pos >= end) { error= true; return r; }
+    r[i]= decode (pos);
+  }
+  if (pos != end) error= true;
+  pos= end;
+  return r;
+}
+
+bool
+texmacs_binary_rep::is_error () {
+  return error || root < 0;
+}
+
+string
+texmacs_binary_rep::get_version () {
+  return version;
+}
+
+int
+texmacs_binary_rep::nr_paragraphs () {
+  return N(par_pos);
+}
+
+tree
+texmacs_binary_rep::get_paragraph (int i) {
+  if (!done[i]) {
+    int pos= par_pos[i];
+    pars[i]= decode (pos);
+    done[i]= true;
+  }
+  return pars[i];
+}
+
+tree
+texmacs_binary_rep::get_document () {
+  if (root < 0) return "";
+  int pos= root;
+  return decode (pos);
+}
+
+/******************************************************************************
+* Conversion of the binary format to TeXmacs trees
+******************************************************************************/
+
+static tree
+texmacs_binary_to_tree (texmacs_binary b) {
+  tree error (LABEL_ERROR, "bad format or data");
+  if (b->is_error ()) return error;
+  tree doc= b->get_document ();
+  if (b->is_error () || !is_document (doc)) return error;
+  if (b->get_version () != TEXMACS_VERSION) {
+    doc= upgrade (doc, b->get_version ());
+    intern_atoms (doc);
+  }
+  return doc;
+}
+
+tree
+texmacs_binary_to_tree (string s) {
+  return texmacs_binary_to_tree (texmacs_binary (s));
+}
+
+tree
+texmacs_binary_to_tree (url u) {
+  return texmacs_binary_to_tree (texmacs_binary (u));
+}
@@ -0,0 +1,77 @@
+
+/******************************************************************************
+* MODULE     : tmbin.hpp
+* DESCRIPTION: compact binary format for TeXmacs documents
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#ifndef TMBIN_H
+#define TMBIN_H
+#include "tree.hpp"
+#include "file.hpp"
+
+/******************************************************************************
+* The binary format consists of a header with the version of TeXmacs which
+* wrote the document, a table with the names of the labels of the compound
+* nodes, a pool with the distinct atoms and the encoding of the tree
+* itself. A node starts with a varint tag, which is
+* twice the index of an atom in the pool, or twice the index of a label
+* plus one. Compound nodes continue with a varint arity and the byte size
+* of the encoding of their children, so that subtrees can be skipped.
+*
+* A texmacs_binary gives access to such an encoding without decoding it
+* entirely: the paragraphs of the body are only materialized on demand.
+* Notice that the paragraphs are returned as they were written: documents
+* of older versions are only upgraded by texmacs_binary_to_tree.
+******************************************************************************/
+
+class texmacs_binary_rep: concrete_struct {
+  mapped_file   mf;         // the encoded document
+  const char*   data;       // its contents
+  int           size;       // its size
+  bool          error;      // invalid document?
+  string        version;    // version of TeXmacs which wrote the document
+  array<tree_label> labels; // the table of labels
+  array<int>    atom_pos;   // positions of the atoms in the pool
+  array<int>    atom_len;   // lengths of the atoms in the pool
+  array<string> atoms;      // the short atoms which have already been decoded
+  int           root;       // position of the root node
+  int           body;       // position of the body of the document, or -1
+  array<int>    par_pos;    // positions of the paragraphs of the body
+  array<tree>   pars;       // the paragraphs which have been materialized
+  array<bool>   done;       // which paragraphs have been materialized
+
+  bool   read_int (int& pos, int& x);
+  bool   read_node (int& pos, int& tag, int& arity, int& end);
+  void   open ();
+  string get_atom (int i);
+  tree   decode (int& pos);
+
+public:
+  texmacs_binary_rep (url u);
+  texmacs_binary_rep (string s);
+  bool   is_error ();
+  string get_version ();
+  int    nr_paragraphs ();
+  tree   get_paragraph (int i);
+  tree   get_document ();
+  friend class texmacs_binary;
+};
+
+class texmacs_binary {
+  CONCRETE(texmacs_binary);
+  inline texmacs_binary (url u): rep (tm_new<texmacs_binary_rep> (u)) {}
+  inline texmacs_binary (string s): rep (tm_new<texmacs_binary_rep> (s)) {}
+};
+CONCRETE_CODE(texmacs_binary);
+
+bool   is_texmacs_binary (string s);
+string tree_to_texmacs_binary (tree t);
+tree   texmacs_binary_to_tree (string s);
+tree   texmacs_binary_to_tree (url u);
+
+#endif // defined TMBIN_H
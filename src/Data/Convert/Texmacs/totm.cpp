@@ -11,30 +11,44 @@
 
 #include "convert.hpp"
 #include "drd_std.hpp"
+#include "file.hpp"
 
 /******************************************************************************
-* Conversion of TeXmacs trees to the present TeXmacs string format
+* Conversion of TeXmacs trees to the present TeXmacs string format.
+* Only the current line is kept in buf, since the writer never needs to
+* look back beyond it. Complete lines are moved to out and, when writing
+* to a file, the contents of out are written as soon as they exceed
+* TM_WRITER_BUFFER bytes.
 ******************************************************************************/
 
+#define TM_WRITER_BUFFER 65536
+
 struct tm_writer {
-  string  buf;       // the resulting string
+  file_writer* file; // the file to which we write, if any
+  string  out;       // the complete lines which have not yet been written
+  string  buf;       // the current line
   string  spc;       // "" or " "
   string  tmp;       // not yet flushed characters
   int     mode;      // normal: 0, verbatim: 1, mathematics: 2
+  array<string> names; // private copies of the constructor names, if any
 
   int     tab;       // number of tabs after CR
   int     xpos;      // current horizontal position in buf
   bool    spc_flag;  // true if last printed character was a space or CR
   bool    ret_flag;  // true if last printed character was a CR
 
-  tm_writer ():
+  tm_writer (file_writer* file2= NULL):
+    file (file2), out (""),
     buf (""), spc (""), tmp (""), mode (0),
     tab (0), xpos (0), spc_flag (true), ret_flag (true) {}
 
+  void newline ();
+  void finish ();
   void cr ();
   void flush ();
   void write_space ();
   void write_return ();
+  string name (tree_label l);
   void write (string s, bool flag= true, bool encode_space= false);
   void br (int indent= 0);
   void tag (string before, string s, string after);
@@ -42,6 +56,28 @@ struct tm_writer {
   void write (tree t);
 };
 
+void
+tm_writer::newline () {
+  buf << '\n';
+  out << buf;
+  buf= "";
+  if (file != NULL && N(out) >= TM_WRITER_BUFFER) {
+    (*file)->write (out.data (), N(out));
+    out= "";
+  }
+}
+
+void
+tm_writer::finish () {
+  flush ();
+  out << buf;
+  buf= "";
+  if (file != NULL) {
+    (*file)->write (out.data (), N(out));
+    out= "";
+  }
+}
+
 void
 tm_writer::cr () {
   int i, n= N(buf);
@@ -53,7 +89,7 @@ tm_writer::cr () {
     n  = n- N(buf);
     for (i=0; i<n; i++) buf << "\\ ";
   }
-  buf << '\n';
+  newline ();
   for (i=0; i<std::min(tab,20); i++) buf << ' ';
   xpos= std::min(tab,20);
 }
@@ -121,7 +157,8 @@ tm_writer::write_space () {
 void
 tm_writer::write_return () {
   if (ret_flag) {
-    buf << "\\;\n";
+    buf << "\\;";
+    newline ();
     cr ();
   }
   else {
@@ -130,13 +167,20 @@ tm_writer::write_return () {
       tmp= "\\ ";
     }
     flush ();
-    buf << "\n";
+    newline ();
     cr ();
   }
   spc_flag= true;
   ret_flag= true;
 }
 
+string
+tm_writer::name (tree_label l) {
+  int i= (int) l;
+  if (i < N(names) && N(names[i]) != 0) return names[i];
+  return as_string (l);
+}
+
 void
 tm_writer::write (string s, bool flag, bool encode_space) {
   if (flag) {
@@ -291,10 +335,10 @@ tm_writer::write (tree t) {
         break;
       }
     }
-    apply (as_string (EXPAND), A(t));
+    apply (name (EXPAND), A(t));
     break;
   case COLLECTION:
-    tag ("<\\", as_string (COLLECTION), ">");
+    tag ("<\\", name (COLLECTION), ">");
     if (n==0) br ();
     else {
       br (2);
@@ -304,10 +348,10 @@ tm_writer::write (tree t) {
       }
       br (-2);
     }
-    tag ("</", as_string (COLLECTION), ">");
+    tag ("</", name (COLLECTION), ">");
     break;
   default:
-    apply (as_string (L(t)), A(t));
+    apply (name (L(t)), A(t));
     break;
   }
 }
@@ -316,8 +360,8 @@ tm_writer::write (tree t) {
 * Conversion of TeXmacs trees to TeXmacs strings
 ******************************************************************************/
 
-string
-tree_to_texmacs (tree t) {
+static tree
+simplify_style (tree t) {
   if (!is_snippet (t)) {
     int i, n= N(t);
     tree r (t, n);
@@ -331,9 +375,70 @@ tree_to_texmacs (tree t) {
       else r[i]= t[i];
     t= r;
   }
+  return t;
+}
 
+string
+tree_to_texmacs (tree t) {
+  tm_writer tmw;
+  tmw.write (simplify_style (t));
+  tmw.finish ();
+  return tmw.out;
+}
+
+/******************************************************************************
+* Snapshots for the serialization in another thread. Strings and trees are
+* reference counted without locks, so the snapshot does not share anything
+* with the document: atoms are copied, and so are the names of the
+* constructors, which are otherwise looked up in a global table.
+******************************************************************************/
+
+static void
+snapshot_name (tree_label l, tree& names) {
+  int i, n= N(names);
+  if ((int) l >= n) {
+    tree r (TUPLE, std::max (((int) l) + 1, 2*n));
+    for (i=0; i<N(r); i++) r[i]= (i<n? names[i]: tree (""));
+    names= r;
+  }
+  if (names[(int) l] == "") names[(int) l]= copy (as_string (l));
+}
+
+static tree
+snapshot_copy (tree t, tree& names) {
+  if (is_atomic (t)) return tree (copy (t->label));
+  int i, n= N(t);
+  snapshot_name (L(t), names);
+  tree r (t, n);
+  for (i=0; i<n; i++) r[i]= snapshot_copy (t[i], names);
+  return r;
+}
+
+tree
+texmacs_snapshot (tree t) {
+  tree names (TUPLE);
+  snapshot_name (EXPAND, names);
+  snapshot_name (COLLECTION, names);
+  tree doc= snapshot_copy (simplify_style (t), names);
+  return tree (TUPLE, doc, names);
+}
+
+string
+texmacs_snapshot_to_string (tree snapshot) {
   tm_writer tmw;
-  tmw.write (t);
-  tmw.flush ();
-  return tmw.buf;
+  for (int i=0; i<N(snapshot[1]); i++)
+    tmw.names << snapshot[1][i]->label;
+  tmw.write (snapshot[0]);
+  tmw.finish ();
+  return tmw.out;
+}
+
+bool
+tree_to_texmacs (tree t, url u) {
+  file_writer fw (u);
+  if (fw->error) return true;
+  tm_writer tmw (&fw);
+  tmw.write (simplify_style (t));
+  tmw.finish ();
+  return fw->commit ();
 }
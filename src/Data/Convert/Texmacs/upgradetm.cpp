@@ -1767,7 +1767,7 @@ upgrade_formatting (tree t) {
 * Upgrade expand
 ******************************************************************************/
 
-static tree
+tree
 upgrade_expand (tree t, tree_label WHICH_EXPAND) {
   if (is_atomic (t)) return t;
   else if (is_func (t, WHICH_EXPAND) && is_atomic (t[0])) {
@@ -1795,7 +1795,7 @@ upgrade_expand (tree t, tree_label WHICH_EXPAND) {
   }
 }
 
-static tree
+tree
 upgrade_xexpand (tree t) {
   if (is_atomic (t)) return t;
   else {
@@ -4176,6 +4176,134 @@ preserve_lengths (tree t) {
   return change_doc_attr (t, "style", style);
 }
 
+/******************************************************************************
+* Fused upgrades of single nodes
+******************************************************************************/
+
+typedef tree (*node_upgrade) (tree t);
+
+struct local_upgrades {
+  array<node_upgrade> rules;  // NULL for renamings
+  array<string>       which;  // primitives to be renamed
+  array<string>       by;     // their new names
+  void rename (string which, string by);
+  void add (node_upgrade rule);
+  tree apply (tree t);
+};
+
+void
+local_upgrades::rename (string which2, string by2) {
+  rules << ((node_upgrade) NULL);
+  which << which2;
+  by    << by2;
+}
+
+void
+local_upgrades::add (node_upgrade rule) {
+  rules << rule;
+  which << string ("");
+  by    << string ("");
+}
+
+tree
+local_upgrades::apply (tree t) {
+  // The children are upgraded first and the rules are then applied to
+  // the node itself, in the order in which they were added. This gives
+  // the same result as one traversal per rule, provided that each rule
+  // only looks at the node and its atomic children. Unchanged subtrees
+  // are shared with the original tree.
+  if (is_atomic (t) || N(rules) == 0) return t;
+  int i, n= N(t);
+  tree r= t;
+  for (i=0; i<n; i++) {
+    tree u= apply (t[i]);
+    if (!strong_equal (u, t[i])) {
+      if (strong_equal (r, t)) {
+        r= tree (t, n);
+        for (int j=0; j<n; j++) r[j]= t[j];
+      }
+      r[i]= u;
+    }
+  }
+  for (i=0; i<N(rules); i++)
+    if (rules[i] != NULL) r= rules[i] (r);
+    else if (is_compound (r, which[i])) {
+      // the previous rules may have changed the arity of the node
+      tree s (make_tree_label (by[i]), N(r));
+      for (int j=0; j<N(r); j++) s[j]= r[j];
+      r= s;
+    }
+  return r;
+}
+
+static tree
+upgrade_qed_node (tree t) {
+  if (t == tree (VALUE, "qed")) return compound ("qed");
+  return t;
+}
+
+static tree
+upgrade_copyright_dashes_node (tree t) {
+  if (!is_compound (t, "tmdoc-copyright") || N(t) == 0 || !is_atomic (t[0]))
+    return t;
+  string s= replace (t[0]->label, "--", "\25");
+  if (s == t[0]->label) return t;
+  int i, n= N(t);
+  tree r (t, n);
+  for (i=1; i<n; i++) r[i]= t[i];
+  r[0]= s;
+  return r;
+}
+
+static tree
+upgrade_expand_node (tree t, tree_label WHICH_EXPAND) {
+  if (is_func (t, WHICH_EXPAND) && N(t) > 0 && is_atomic (t[0])) {
+    int i, n= N(t)-1;
+    string s= t[0]->label;
+    if (s == "quote") s= s * "-env";
+    tree r (make_tree_label (s), n);
+    for (i=0; i<n; i++) r[i]= t[i+1];
+    return r;
+  }
+  if (is_func (t, ASSIGN, 2) && t[0] == "quote" && is_func (t[1], MACRO))
+    return tree (ASSIGN, t[0]->label * "-env", t[1]);
+  return t;
+}
+
+static tree
+upgrade_expand_node (tree t) {
+  return upgrade_expand_node (t, EXPAND);
+}
+
+static tree
+upgrade_hide_expand_node (tree t) {
+  return upgrade_expand_node (t, HIDE_EXPAND);
+}
+
+static tree
+upgrade_var_expand_node (tree t) {
+  return upgrade_expand_node (t, VAR_EXPAND);
+}
+
+static tree
+upgrade_xexpand_node (tree t) {
+  if (!is_expand (t)) return t;
+  int i, n= N(t);
+  tree r (COMPOUND, n);
+  for (i=0; i<n; i++) r[i]= t[i];
+  return r;
+}
+
+tree
+upgrade_expands (tree t) {
+  local_upgrades lu;
+  lu.add (upgrade_expand_node);
+  lu.add (upgrade_hide_expand_node);
+  lu.add (upgrade_var_expand_node);
+  lu.add (upgrade_xexpand_node);
+  return lu.apply (t);
+}
+
 /******************************************************************************
 * Upgrade from previous versions
 ******************************************************************************/
@@ -4192,10 +4320,7 @@ upgrade_tex (tree t) {
   t= upgrade_menus_in_help (t);
   t= upgrade_capitalize_menus (t);
   t= upgrade_formatting (t);
-  t= upgrade_expand (t, EXPAND);
-  t= upgrade_expand (t, HIDE_EXPAND);
-  t= upgrade_expand (t, VAR_EXPAND);
-  t= upgrade_xexpand (t);
+  t= upgrade_expands (t);
   t= upgrade_function (t);
   t= upgrade_apply (t);
   t= upgrade_env_vars (t);
@@ -4262,13 +4387,16 @@ upgrade (tree t, string version) {
     t= upgrade_session (t);
   if (version_inf_eq (version, "1.0.2.0"))
     t= upgrade_formatting (t);
-  if (version_inf_eq (version, "1.0.2.3"))
-    t= upgrade_expand (t, EXPAND);
-  if (version_inf_eq (version, "1.0.2.4"))
-    t= upgrade_expand (t, HIDE_EXPAND);
   if (version_inf_eq (version, "1.0.2.5")) {
-    t= upgrade_expand (t, VAR_EXPAND);
-    t= upgrade_xexpand (t);
+    // the expansions by name only look at single nodes
+    local_upgrades lu;
+    if (version_inf_eq (version, "1.0.2.3"))
+      lu.add (upgrade_expand_node);
+    if (version_inf_eq (version, "1.0.2.4"))
+      lu.add (upgrade_hide_expand_node);
+    lu.add (upgrade_var_expand_node);
+    lu.add (upgrade_xexpand_node);
+    t= lu.apply (t);
   }
   if (version_inf_eq (version, "1.0.2.6")) {
     t= upgrade_function (t);
@@ -4364,11 +4492,28 @@ upgrade (tree t, string version) {
   }
   if (version_inf_eq (version, "1.99.4"))
     t= upgrade_draw_over_under (t);
-  if (version_inf_eq (version, "1.99.6")) {
-    t= upgrade_qed (t);
+
+  // The recent upgrades of single nodes are done in a single traversal;
+  // they commute with the upgrades of the style which are done afterwards
+  local_upgrades lu;
+  if (version_inf_eq (version, "1.99.6"))
+    lu.add (upgrade_qed_node);
+  if (version_inf_eq (version, "1.99.9")) {
+    lu.rename ("solution", "solution*");
+    lu.rename ("answer", "answer*");
+    lu.rename ("html-div", "html-div-class");
+    lu.rename ("html-style", "html-div-style");
+  }
+  if (version_inf_eq (version, "1.99.12")) {
+    lu.add (upgrade_copyright_dashes_node);
+    lu.rename ("swell", "inflate");
+    lu.rename ("swell-top", "inflate-top");
+    lu.rename ("swell-bottom", "inflate-bottom");
+  }
+  t= lu.apply (t);
+  if (version_inf_eq (version, "1.99.6"))
     if (is_non_style_document (t))
       t= preserve_spacing (t);
-  }
   if (version_inf_eq (version, "1.99.8")) {
     if (is_non_style_document (t)) {
       t= rename_style (t, "exam", "old-exam");
@@ -4376,21 +4521,9 @@ upgrade (tree t, string version) {
       t= rename_style (t, "beamer", "old2-beamer");
     }
   }
-  if (version_inf_eq (version, "1.99.9")) {
-    t= rename_primitive (t, "solution", "solution*");
-    t= rename_primitive (t, "answer", "answer*");
-    t= rename_primitive (t, "html-div", "html-div-class");
-    t= rename_primitive (t, "html-style", "html-div-style");
-  }
   if (version_inf_eq (version, "1.99.11"))
     if (is_non_style_document (t))
       t= preserve_dots (t);
-  if (version_inf_eq (version, "1.99.12")) {
-    t= upgrade_copyright_dashes (t);
-    t= rename_primitive (t, "swell", "inflate");
-    t= rename_primitive (t, "swell-top", "inflate-top");
-    t= rename_primitive (t, "swell-bottom", "inflate-bottom");
-  }
   if (version_inf_eq (version, "1.99.13"))
     t= preserve_lengths (t);
 
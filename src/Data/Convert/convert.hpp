@@ -39,7 +39,14 @@ scheme_tree compute_index (url u);
 /*** Texmacs ***/
 tree   texmacs_to_tree (string s);
 tree   texmacs_document_to_tree (string s);
+tree   texmacs_document_to_tree (url u);
 string tree_to_texmacs (tree t);
+bool   tree_to_texmacs (tree t, url u);
+tree   texmacs_snapshot (tree t);
+string texmacs_snapshot_to_string (tree snapshot);
+bool   is_texmacs_binary (string s);
+tree   texmacs_binary_to_tree (string s);
+string tree_to_texmacs_binary (tree t);
 tree   extract (tree doc, string attr);
 tree   extract_document (tree doc);
 tree   change_doc_attr (tree doc, string attr, tree val);
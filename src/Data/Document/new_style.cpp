@@ -14,6 +14,7 @@
 #include "data_cache.hpp"
 #include "convert.hpp"
 #include "../../Typeset/env.hpp"
+#include "../../Style/Memorizer/memo_store.hpp"
 
 /******************************************************************************
 * Global data
@@ -106,6 +107,7 @@ style_invalidate_cache () {
   }
   init_style_data ();
   remove ("$TEXMACS_HOME_PATH/system/cache" * url_wildcard ("__*"));
+  memo_invalidate ();
 }
 
 void
@@ -12,6 +12,7 @@
 #include "fast_search.hpp"
 #include "analyze.hpp"
 #include "iterator.hpp"
+#include <algorithm>
 
 /******************************************************************************
 * Subroutines
@@ -157,3 +158,154 @@ get_longest_common (string s1, string s2, int& b1, int& e1, int& b2, int& e2) {
     }
   }
 }
+
+/******************************************************************************
+* Suffix arrays
+******************************************************************************/
+
+static void
+induce_sort (int* s, bool* ls, int* sa, int n, int* sum_s, int* sum_l,
+             int upper, array<int> lms) {
+  // induce the order of all suffixes from the order of the LMS suffixes
+  int i;
+  array<int> buf_a (upper+1);
+  int* buf= A(buf_a);
+  for (i=0; i<n; i++) sa[i]= -1;
+  for (i=0; i<=upper; i++) buf[i]= sum_s[i];
+  for (i=0; i<N(lms); i++)
+    if (lms[i] != n) sa[buf[s[lms[i]]]++]= lms[i];
+  for (i=0; i<=upper; i++) buf[i]= sum_l[i];
+  sa[buf[s[n-1]]++]= n-1;
+  for (i=0; i<n; i++) {
+    int v= sa[i];
+    if (v >= 1 && !ls[v-1]) sa[buf[s[v-1]]++]= v-1;
+  }
+  for (i=0; i<=upper; i++) buf[i]= sum_l[i];
+  for (i=n-1; i>=0; i--) {
+    int v= sa[i];
+    if (v >= 1 && ls[v-1]) sa[--buf[s[v-1]+1]]= v-1;
+  }
+}
+
+static array<int>
+suffix_sort (array<int> s, int upper) {
+  // NOTE: SA-IS algorithm by Nong, Zhang and Chan, in linear time
+  int i, n= N(s);
+  array<int> sa (n);
+  if (n < 2) {
+    if (n == 1) sa[0]= 0;
+    return sa;
+  }
+  if (n == 2) {
+    sa[0]= (s[0] < s[1]? 0: 1);
+    sa[1]= 1 - sa[0];
+    return sa;
+  }
+  array<bool> ls (n);
+  ls[n-1]= false;
+  for (i=n-2; i>=0; i--)
+    ls[i]= (s[i] == s[i+1])? ls[i+1]: (s[i] < s[i+1]);
+  array<int> sum_l (upper+1), sum_s (upper+1);
+  for (i=0; i<=upper; i++) sum_l[i]= sum_s[i]= 0;
+  for (i=0; i<n; i++)
+    if (!ls[i]) sum_s[s[i]]++;
+    else if (s[i] < upper) sum_l[s[i]+1]++;
+  for (i=0; i<=upper; i++) {
+    sum_s[i] += sum_l[i];
+    if (i < upper) sum_l[i+1] += sum_s[i];
+  }
+
+  array<int> lms_map (n+1), lms;
+  for (i=0; i<=n; i++) lms_map[i]= -1;
+  for (i=1; i<n; i++)
+    if (!ls[i-1] && ls[i]) {
+      lms_map[i]= N(lms);
+      lms << i;
+    }
+  int m= N(lms);
+  induce_sort (A(s), A(ls), A(sa), n, A(sum_s), A(sum_l), upper, lms);
+  if (m == 0) return sa;
+
+  // sort the LMS substrings recursively, by their names
+  array<int> sorted_lms;
+  for (i=0; i<n; i++)
+    if (lms_map[sa[i]] != -1) sorted_lms << sa[i];
+  array<int> rec_s (m);
+  int rec_upper= 0;
+  rec_s[lms_map[sorted_lms[0]]]= 0;
+  for (i=1; i<m; i++) {
+    int l= sorted_lms[i-1], r= sorted_lms[i];
+    int end_l= (lms_map[l] + 1 < m)? lms[lms_map[l] + 1]: n;
+    int end_r= (lms_map[r] + 1 < m)? lms[lms_map[r] + 1]: n;
+    bool same= true;
+    if (end_l - l != end_r - r) same= false;
+    else {
+      while (l < end_l && s[l] == s[r]) { l++; r++; }
+      if (l == n || s[l] != s[r]) same= false;
+    }
+    if (!same) rec_upper++;
+    rec_s[lms_map[sorted_lms[i]]]= rec_upper;
+  }
+  array<int> rec_sa= suffix_sort (rec_s, rec_upper);
+  for (i=0; i<m; i++) sorted_lms[i]= lms[rec_sa[i]];
+  induce_sort (A(s), A(ls), A(sa), n, A(sum_s), A(sum_l), upper, sorted_lms);
+  return sa;
+}
+
+suffix_array_rep::suffix_array_rep (string s2): s (s2) {
+  int i, n= N(s);
+  array<int> codes (n);
+  for (i=0; i<n; i++) codes[i]= (int) (unsigned char) s[i];
+  sa= suffix_sort (codes, 255);
+}
+
+string
+suffix_array_rep::get_string () {
+  return s;
+}
+
+static int
+compare_prefix (string s, int pos, string what) {
+  // compare the suffix of s at pos with what, up to the length of what
+  int i, n= N(s), k= N(what);
+  for (i=0; i<k && pos+i<n; i++)
+    if (s[pos+i] != what[i])
+      return ((unsigned char) s[pos+i]) < ((unsigned char) what[i])? -1: 1;
+  return i == k? 0: -1;
+}
+
+void
+suffix_array_rep::search_range (string what, int& b, int& e) {
+  // the suffixes starting with what are those at positions b, ..., e-1
+  int lo= 0, hi= N(sa);
+  while (lo < hi) {
+    int mid= (lo + hi) >> 1;
+    if (compare_prefix (s, sa[mid], what) < 0) lo= mid + 1;
+    else hi= mid;
+  }
+  b= lo;
+  hi= N(sa);
+  while (lo < hi) {
+    int mid= (lo + hi) >> 1;
+    if (compare_prefix (s, sa[mid], what) <= 0) lo= mid + 1;
+    else hi= mid;
+  }
+  e= lo;
+}
+
+int
+suffix_array_rep::count (string what) {
+  int b, e;
+  search_range (what, b, e);
+  return e - b;
+}
+
+array<int>
+suffix_array_rep::search_all (string what) {
+  int b, e;
+  search_range (what, b, e);
+  array<int> r (e - b);
+  for (int i=b; i<e; i++) r[i-b]= sa[i];
+  std::sort (A(r), A(r) + N(r));
+  return r;
+}
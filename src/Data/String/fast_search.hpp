@@ -42,4 +42,25 @@ CONCRETE_CODE(string_searcher);
 void get_longest_common (string s1, string s2,
                          int& b1, int& e1, int& b2, int& e2);
 
+class suffix_array;
+class suffix_array_rep: concrete_struct {
+  string s;
+  array<int> sa;
+  void search_range (string what, int& b, int& e);
+
+public:
+  suffix_array_rep (string s);
+  string get_string ();
+  int count (string what);
+  array<int> search_all (string what);
+  friend class suffix_array;
+};
+
+class suffix_array {
+CONCRETE(suffix_array);
+  inline suffix_array (): rep (tm_new<suffix_array_rep> ("")) {}
+  inline suffix_array (string s): rep (tm_new<suffix_array_rep> (s)) {}
+};
+CONCRETE_CODE(suffix_array);
+
 #endif // FAST_SEARCH_H
@@ -13,6 +13,9 @@
 #include "analyze.hpp"
 #include "boot.hpp"
 #include "drd_mode.hpp"
+#include "fast_search.hpp"
+#include "modification.hpp"
+#include <algorithm>
 
 int  search_max_hits= 1000000;
 bool blank_match_flag= false;
@@ -458,6 +461,191 @@ select (range_set& sel, tree t, tree what, path p) {
   }
 }
 
+/******************************************************************************
+* Indexed searches of plain strings.
+* When the same tree is searched again without having been modified in
+* between, as during incremental search, we build a suffix array for its
+* atoms, separated by null characters. The nodes of the tree are numbered
+* in preorder and we remember the range of the text of each node, so that
+* we only have to visit the subtrees which contain the searched string.
+* Raw data are not indexed and searched as before.
+* Modifications of an indexed tree which is part of the edit tree are
+* announced to an observer attached to it, so that the index survives
+* modifications elsewhere, like those of the search field. For other trees,
+* any modification invalidates the index. Only one index is kept, and the
+* trees which were searched once are only remembered by their addresses.
+******************************************************************************/
+
+#define SEARCH_INDEX_CANDIDATES 16
+#define SEARCH_INDEX_MAX_OCCURRENCES 65536
+
+struct search_index {
+  tree         root;    // the indexed tree
+  bool         locase;  // whether the atoms were converted to lower case
+  observer     obs;     // watches root if it is part of the edit tree
+  bool         stale;   // whether root has been modified
+  int          stamp;   // modification stamp when root is not watched
+  suffix_array sa;      // suffix array of the text of the atoms
+  array<int>   start;   // start of the text of each node, -1 for raw data
+  array<int>   end;     // end of the text of each node
+  array<int>   first;   // position in kids of the children of each node
+  array<int>   kids;    // numbers of the children of all nodes
+  array<int>   occ;     // sorted occurrences of the searched string
+  int          len;     // length of the searched string
+};
+
+class search_index_observer_rep: public observer_rep {
+  search_index* idx;
+public:
+  search_index_observer_rep (search_index* idx2): idx (idx2) {}
+  tm_ostream& print (tm_ostream& out) { return out << " search_index"; }
+  void announce (tree& ref, modification mod) {
+    (void) ref; if (mod->k != MOD_SET_CURSOR) idx->stale= true; }
+  void notify_detach (tree& ref, tree closest, bool right) {
+    (void) ref; (void) closest; (void) right; idx->stale= true; }
+};
+
+static search_index* the_index= NULL;
+static array<tree_rep*> index_candidates;
+
+static void
+delete_search_index () {
+  if (the_index == NULL) return;
+  if (!is_nil (the_index->obs))
+    detach_observer (the_index->root, the_index->obs);
+  tm_delete (the_index);
+  the_index= NULL;
+}
+
+static bool
+is_valid (search_index* idx) {
+  if (is_nil (idx->obs)) return idx->stamp == modification_stamp;
+  return !idx->stale;
+}
+
+static int
+build_index (search_index* idx, tree t, string& text) {
+  int k= N(idx->start);
+  idx->start << N(text);
+  idx->end << N(text);
+  idx->first << -1;
+  if (is_atomic (t)) {
+    text << (idx->locase? locase_all (t->label): t->label);
+    idx->end[k]= N(text);
+    text << '\0';
+  }
+  else if (is_func (t, RAW_DATA)) idx->start[k]= -1;
+  else {
+    int i, f= N(idx->kids), n= N(t);
+    idx->first[k]= f;
+    for (i=0; i<n; i++) idx->kids << -1;
+    for (i=0; i<n; i++) {
+      int c= build_index (idx, t[i], text);
+      idx->kids[f+i]= c;
+    }
+    idx->end[k]= N(text);
+  }
+  return k;
+}
+
+static search_index*
+get_search_index (tree t) {
+  if (the_index != NULL && !is_valid (the_index)) delete_search_index ();
+  if (the_index != NULL && strong_equal (the_index->root, t) &&
+      the_index->locase == case_insensitive_match_flag)
+    return the_index;
+  for (int i=0; i<N(index_candidates); i++)
+    if (index_candidates[i] == inside (t)) {
+      delete_search_index ();
+      the_index= tm_new<search_index> ();
+      the_index->root  = t;
+      the_index->locase= case_insensitive_match_flag;
+      the_index->stale = false;
+      the_index->stamp = modification_stamp;
+      if (ip_attached (obtain_ip (t))) {
+        the_index->obs= tm_new<search_index_observer_rep> (the_index);
+        attach_observer (the_index->root, the_index->obs);
+      }
+      string text;
+      build_index (the_index, t, text);
+      the_index->sa= suffix_array (text);
+      return the_index;
+    }
+  if (N(index_candidates) >= SEARCH_INDEX_CANDIDATES)
+    index_candidates= range (index_candidates, 1, N(index_candidates));
+  index_candidates << inside (t);
+  return NULL;
+}
+
+static search_index*
+prepare_search_index (tree t, tree what) {
+  if (!is_atomic (what) || N(what->label) == 0) return NULL;
+  for (int i=0; i<N(what->label); i++)
+    if (what->label[i] == '\0') return NULL;
+  search_index* idx= get_search_index (t);
+  if (idx == NULL) return NULL;
+  // frequent strings are found quickly enough without the index
+  if (idx->sa->count (what->label) > SEARCH_INDEX_MAX_OCCURRENCES) return NULL;
+  idx->occ= idx->sa->search_all (what->label);
+  idx->len= N(what->label);
+  return idx;
+}
+
+static bool
+index_contains (search_index* idx, int k) {
+  if (idx->start[k] < 0) return true;
+  int* o= A(idx->occ);
+  int* e= o + N(idx->occ);
+  int* it= std::lower_bound (o, e, idx->start[k]);
+  return it != e && *it + idx->len <= idx->end[k];
+}
+
+static void
+search (search_index* idx, range_set& sel, tree t, tree what, path p, int k) {
+  if (N(sel) > search_max_hits) return;
+  if (idx->start[k] < 0) search (sel, t, what, p);
+  else if (!index_contains (idx, k)) return;
+  else if (is_atomic (t)) search_string (sel, t->label, what, p);
+  else if (match (t, what))
+    merge (sel, simple_range (p * start (t), p * end (t)));
+  else {
+    int f= idx->first[k];
+    for (int i=0; i<N(t); i++)
+      if (index_contains (idx, idx->kids[f+i]))
+        if (is_accessible_for_search (t, i))
+          search (idx, sel, t[i], what, p * i, idx->kids[f+i]);
+  }
+}
+
+static void
+search (search_index* idx, range_set& sel, tree t, tree what,
+        path p, path pos, int k) {
+  if (idx->start[k] < 0) search (sel, t, what, p, pos);
+  else if (is_atomic (t) || is_nil (pos)) search (idx, sel, t, what, p, k);
+  else if (!index_contains (idx, k)) return;
+  else {
+    int hits= 0, f= idx->first[k];
+    array<range_set> sub (N(t));
+    if (pos->item >= 0 && pos->item < N(t))
+      if (is_accessible_for_search (t, pos->item)) {
+        search (idx, sub[pos->item], t[pos->item], what,
+                p * pos->item, pos->next, idx->kids[f+pos->item]);
+        hits += N(sub[pos->item]);
+      }
+    for (int d=1; d<N(t); d++)
+      for (int e=0; e<=1; e++) {
+        if (hits > search_max_hits) break;
+        int i= (e==0? pos->item + d: pos->item - d);
+        if (i >= 0 && i < N(t) && index_contains (idx, idx->kids[f+i]))
+          if (is_accessible_for_search (t, i)) {
+            search (idx, sub[i], t[i], what, p * i, idx->kids[f+i]);
+            hits += N(sub[i]);
+          }
+      }
+    for (int i=0; i<N(t); i++) sel << sub[i];
+  }
+}
+
 /******************************************************************************
 * Front end
 ******************************************************************************/
@@ -468,7 +656,9 @@ search (tree t, tree what, path p, int limit) {
   initialize_search ();
   range_set sel;
   //cout << "Search " << what << ", " << contains_select_region (what) << "\n";
+  search_index* idx= prepare_search_index (t, what);
   if (contains_select_region (what)) select (sel, t, what, p);
+  else if (idx != NULL) search (idx, sel, t, what, p, 0);
   else search (sel, t, what, p);
   //cout << "Selected " << sel << "\n";
   search_max_hits= 1000000;
@@ -481,7 +671,9 @@ search (tree t, tree what, path p, path pos, int limit) {
   initialize_search ();
   range_set sel;
   //cout << "Search " << what << ", " << contains_select_region (what) << "\n";
+  search_index* idx= prepare_search_index (t, what);
   if (contains_select_region (what)) select (sel, t, what, p);
+  else if (idx != NULL) search (idx, sel, t, what, p, pos, 0);
   else search (sel, t, what, p, pos);
   //cout << "Selected " << sel << "\n";
   search_max_hits= 1000000;
@@ -490,8 +682,14 @@ search (tree t, tree what, path p, path pos, int limit) {
 
 range_set
 previous_search_hit (range_set sels, path cur, bool strict) {
-  int i= (N(sels) >> 1) << 1;
-  while (i >= 2 && !path_less_eq (sels[i-2], cur)) i -= 2;
+  // the hits are sorted, so we look for the last one before cur by dichotomy
+  int lo= 0, hi= N(sels) >> 1;
+  while (lo < hi) {
+    int mid= (lo + hi) >> 1;
+    if (path_less_eq (sels[2*mid], cur)) lo= mid + 1;
+    else hi= mid;
+  }
+  int i= 2*lo;
   if (strict && i >= 2 && !path_less (sels[i-1], cur)) i -= 2;
   if (i >= 2) return range (sels, i-2, i);
   return range_set ();
@@ -499,8 +697,13 @@ previous_search_hit (range_set sels, path cur, bool strict) {
 
 range_set
 next_search_hit (range_set sels, path cur, bool strict) {
-  int i=0, n=N(sels);
-  while (i+2 <= n && !path_less_eq (cur, sels[i+1])) i += 2;
+  int lo= 0, hi= N(sels) >> 1, n= N(sels);
+  while (lo < hi) {
+    int mid= (lo + hi) >> 1;
+    if (path_less_eq (cur, sels[2*mid+1])) hi= mid;
+    else lo= mid + 1;
+  }
+  int i= 2*lo;
   while (i+4 <= n && sels[i+1] == sels[i+2] && sels[i+1] == cur) i += 2;
   if (strict && i+2 <= n) i += 2;
   if (i+2 <= n) return range (sels, i, i+2);
@@ -22,6 +22,7 @@
 #include <setjmp.h>
 #include "image_files.hpp"
 #include "iterator.hpp"
+#include "tm_timer.hpp"
 
 #ifdef EXPERIMENTAL
 #include "../../Style/Memorizer/clean_copy.hpp"
@@ -31,9 +32,23 @@
 #include "Ghostscript/gs_utilities.hpp"
 #endif
 
+#ifdef PDF_RENDERER
+#include "Pdf/pdf_hummus_renderer.hpp"
+#ifndef OS_MINGW
+#include <thread>
+#include <unistd.h>
+#include <spawn.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#define PARALLEL_PRINT
+extern char **environ;
+#endif
+#endif
+
 #ifdef QTTEXMACS
 #include "Qt/qt_gui.hpp"
 #include "Qt/qt_utilities.hpp"
+#include <QCoreApplication>
 #endif
 
 /******************************************************************************
@@ -215,6 +230,114 @@ edit_main_rep::nr_pages () {
   return N (the_box[0]);
 }
 
+static void
+print_pages (renderer ren, box the_box, tree bg, double w, double h,
+             int start, int end) {
+  for (int i=start; i<end; i++) {
+    ren->set_background (bg);
+    if (bg != "white" && bg != "#ffffff")
+      ren->clear_pattern (0, (SI) -h, (SI) w, 0);
+
+    rectangles rs;
+    the_box[0]->sx(i)= 0;
+    the_box[0]->sy(i)= 0;
+    the_box[0][i]->redraw (ren, path (0), rs);
+    if (i<end-1) ren->next_page ();
+  }
+}
+
+#ifdef PARALLEL_PRINT
+#define PARALLEL_PRINT_PAGES 16
+
+static bool printing_part= false;
+
+static url
+helper_binary () {
+#ifdef QTTEXMACS
+  return url_system (from_qstring (QCoreApplication::applicationFilePath ()));
+#else
+  return url ("$TEXMACS_BIN_PATH/bin/texmacs.bin");
+#endif
+}
+
+static int
+spawn_print_helper (url file, url part, int a, int b) {
+  // Starts a TeXmacs process without windows, which loads the saved
+  // document and prints the pages a to b into part.
+  // Returns the pid of the helper or -1 on failure.
+  string cmd= "(begin (set-printer-dpi " * scm_quote (printing_dpi) * ")"
+    " (load-buffer " * scm_quote (as_string (file)) * " :strict)"
+    " (print-part-to-file " * scm_quote (as_string (part)) *
+    " " * scm_quote (as_string (a + 1)) *
+    " " * scm_quote (as_string (b)) * "))";
+  array<string> arg;
+  arg << concretize (helper_binary ())
+      << string ("-gi") << string (global_scheme_name.c_str ())
+      << string ("--print-helper") << string ("-x") << cmd << string ("-q");
+  array<string> env;
+  for (char** e= environ; *e != NULL; e++)
+    if (!starts (string (*e), "QT_QPA_PLATFORM="))
+      env << string (*e);
+  env << string ("QT_QPA_PLATFORM=offscreen");
+
+  posix_spawn_file_actions_t actions;
+  if (posix_spawn_file_actions_init (&actions) != 0) return -1;
+  posix_spawn_file_actions_addopen (&actions, 1, "/dev/null", O_WRONLY, 0);
+  posix_spawn_file_actions_addopen (&actions, 2, "/dev/null", O_WRONLY, 0);
+  array<char*> _arg, _env;
+  for (int i=0; i<N(arg); i++) _arg << as_charp (arg[i]);
+  for (int i=0; i<N(env); i++) _env << as_charp (env[i]);
+  _arg << (char*) NULL;
+  _env << (char*) NULL;
+  pid_t pid;
+  int status= posix_spawn (&pid, _arg[0], &actions, NULL, A(_arg), A(_env));
+  for (int i=0; i<N(arg); i++) tm_delete_array (_arg[i]);
+  for (int i=0; i<N(env); i++) tm_delete_array (_env[i]);
+  posix_spawn_file_actions_destroy (&actions);
+  return status == 0? (int) pid: -1;
+}
+
+static bool
+print_pages_in_parallel (url file, url name, int start, int end,
+                         hashmap<string,string> metadata) {
+  // Ranges of pages are printed into separate files by helper processes,
+  // which are merged afterwards.  Boxes and fonts are not thread safe,
+  // so each helper typesets its own copy of the document, as saved in file.
+  // Returns false if the document should be printed sequentially.
+  if (get_preference ("parallel pdf export", "on") == "off") return false;
+  int pages= end - start;
+  int nr= (int) std::thread::hardware_concurrency ();
+  nr= std::min (nr, pages / PARALLEL_PRINT_PAGES);
+  if (nr < 2) return false;
+
+  array<url> parts;
+  array<int> pids;
+  bool ok= true;
+  for (int k=0; k<nr; k++) {
+    int a= start + (k * pages) / nr, b= start + ((k+1) * pages) / nr;
+    url part= url_temp (".pdf");
+    int pid= spawn_print_helper (file, part, a, b);
+    if (pid < 0) { ok= false; break; }
+    parts << part;
+    pids << pid;
+  }
+  for (int k=0; k<N(pids); k++) {
+    int status;
+    if (waitpid (pids[k], &status, 0) < 0 ||
+        !WIFEXITED (status) || WEXITSTATUS (status) != 0 ||
+        !exists (parts[k]) || !exists (glue (parts[k], ".info")))
+      ok= false;
+  }
+
+  if (ok) ok= pdf_hummus_merge (parts, name, as_int (printing_dpi), metadata);
+  for (int k=0; k<N(parts); k++) {
+    if (exists (parts[k])) remove (parts[k]);
+    if (exists (glue (parts[k], ".info"))) remove (glue (parts[k], ".info"));
+  }
+  return ok;
+}
+#endif
+
 void
 edit_main_rep::print_doc (url name, bool conform, int first, int last) {
   bool ps  = (suffix (name) == "ps");
@@ -239,6 +362,10 @@ edit_main_rep::print_doc (url name, bool conform, int first, int last) {
   // Set environment variables for printing
 
   typeset_prepare ();
+  hashmap<string,tree> screen_env;
+  string print_vars[]= { DPI, PAGE_SHOW_HF, PAGE_SCREEN_MARGIN, PAGE_BORDER,
+                         BG_COLOR, PAGE_MEDIUM, PAGE_PRINTED };
+  for (string var: print_vars) screen_env (var)= env->read (var);
   env->write (DPI, printing_dpi);
   env->write (PAGE_SHOW_HF, "true");
   env->write (PAGE_SCREEN_MARGIN, "false");
@@ -252,7 +379,14 @@ edit_main_rep::print_doc (url name, bool conform, int first, int last) {
 
   // Typeset pages for printing
 
-  box the_box= typeset_as_document (env, subtree (et, rp), reverse (rp));
+  box the_box;
+  hashmap<string,tree> print_env;
+  for (string var: print_vars) print_env (var)= env->read (var);
+  if (!has_changed (THE_TREE + THE_ENVIRONMENT) &&
+      only_page_layout_changed (screen_env, print_env))
+    the_box= typeset_pages (ttt);
+  if (is_nil (the_box) || N(the_box) == 0 || N(the_box[0]) == 0)
+    the_box= typeset_as_document (env, subtree (et, rp), reverse (rp));
 
   // Determine parameters for printer
 
@@ -276,27 +410,39 @@ edit_main_rep::print_doc (url name, bool conform, int first, int last) {
   }
   
   // Print pages
-  renderer ren= printer (name, dpi, pages, page_type, landsc, w/cm, h/cm);
-  
-  if (ren->is_started ()) {
-    int i;
-    ren->set_metadata ("title", get_metadata ("title"));
-    ren->set_metadata ("author", get_metadata ("author"));
-    ren->set_metadata ("subject", get_metadata ("subject"));
-    for (i=start; i<end; i++) {
-      tree bg= env->read (BG_COLOR);
-      ren->set_background (bg);
-      if (bg != "white" && bg != "#ffffff")
-        ren->clear_pattern (0, (SI) -h, (SI) w, 0);
-
-      rectangles rs;
-      the_box[0]->sx(i)= 0;
-      the_box[0]->sy(i)= 0;
-      the_box[0][i]->redraw (ren, path (0), rs);
-      if (i<end-1) ren->next_page ();
+  tree bg= env->read (BG_COLOR);
+  bool done= false;
+#ifdef PARALLEL_PRINT
+  // the helpers print the document as it was saved
+  url file= buf->buf->name;
+  if (use_pdf () && suffix (name) == "pdf" && !conform && !printing_part &&
+      buf->buf->fm == "texmacs" && !buf->needs_to_be_saved () &&
+      is_rooted (file, "default") && exists (file)) {
+    hashmap<string,string> metadata;
+    metadata ("title")= get_metadata ("title");
+    metadata ("author")= get_metadata ("author");
+    metadata ("subject")= get_metadata ("subject");
+    done= print_pages_in_parallel (file, name, start, end, metadata);
+  }
+#endif
+
+  if (!done) {
+#ifdef PARALLEL_PRINT
+    renderer ren= printing_part?
+      pdf_hummus_renderer (name, dpi, pages, page_type, landsc,
+                           w/cm, h/cm, true):
+      printer (name, dpi, pages, page_type, landsc, w/cm, h/cm);
+#else
+    renderer ren= printer (name, dpi, pages, page_type, landsc, w/cm, h/cm);
+#endif
+    if (ren->is_started ()) {
+      ren->set_metadata ("title", get_metadata ("title"));
+      ren->set_metadata ("author", get_metadata ("author"));
+      ren->set_metadata ("subject", get_metadata ("subject"));
+      print_pages (ren, the_box, bg, w, h, start, end);
     }
+    tm_delete (ren);
   }
-  tm_delete (ren);
 
 #ifdef USE_GS
   if (!use_pdf () && pdf) {
@@ -322,6 +468,18 @@ edit_main_rep::print_to_file (url name, string first, string last) {
   set_message ("Done printing", "print to file");
 }
 
+void
+edit_main_rep::print_part_to_file (url name, string first, string last) {
+  // prints a range of pages for the merger of a parallel export
+#ifdef PARALLEL_PRINT
+  printing_part= true;
+  print_doc (name, false, as_int (first), as_int (last));
+  printing_part= false;
+#else
+  print_to_file (name, first, last);
+#endif
+}
+
 void
 edit_main_rep::print_buffer (string first, string last) {
   url target;
@@ -23,6 +23,7 @@
 #ifdef EXPERIMENTAL
 #include "../../Style/Environment/std_environment.hpp"
 #endif // EXPERIMENTAL
+#include "../../Style/Memorizer/memo_store.hpp"
 
 //box empty_box (path ip, int x1=0, int y1=0, int x2=0, int y2=0);
 bool enable_fastenv= false;
@@ -680,10 +681,12 @@ simplify_execed (tree t) {
 }
 
 static tree
-expand_references (tree t, hashmap<string,tree> h) {
+expand_references (tree t, hashmap<string,tree> h,
+                   hashmap<string,bool>& used) {
   if (is_atomic (t)) return t;
   if (is_func (t, REFERENCE, 1) || is_func (t, PAGEREF)) {
     string ref= as_string (simplify_execed (t[0]));
+    used (ref)= true;
     if (h->contains (ref)) {
       int which= is_func (t, REFERENCE, 1)? 0: 1;
       return tree (HLINK, copy (h[ref][which]), "#" * ref);
@@ -693,7 +696,7 @@ expand_references (tree t, hashmap<string,tree> h) {
   int i, n= N(t);
   tree r (t, n);
   for (i=0; i<n; i++)
-    r[i]= expand_references (t[i], h);
+    r[i]= expand_references (t[i], h, used);
   return r;  
 }
 
@@ -710,17 +713,55 @@ prefix_specific (hashmap<string,tree>& H, string prefix) {
   H= R;
 }
 
+static string
+memo_state (edit_env env) {
+  // quantities which are derived from the variables when the environment
+  // is updated and which are used without reading the variables,
+  // for instance by the evaluation of lengths
+  string s= env->fn->res_name;
+  s << "|" << as_string (env->magn) << "|" << as_string (env->pixel)
+    << "|" << as_string (env->flexibility) << "|" << as_string (env->mode)
+    << "|" << as_string (env->index_level)
+    << "|" << as_string ((int) env->display_style)
+    << "|" << as_string (env->page_real_width)
+    << "|" << as_string (env->page_real_height);
+  return s;
+}
+
 tree
 edit_typeset_rep::exec (tree t, hashmap<string,tree> H, bool expand_refs) {
+  // The result only depends on the style, the tree, the font and
+  // magnification, and the environment variables and references which
+  // are read during the evaluation, unless the evaluation calls scheme,
+  // accesses files or sets references
+  string key= memo_key (the_style, t, memo_state (env));
+  if (expand_refs) key= key * "+refs";
+  tree r;
+  if (memo_lookup (the_style, key, H, env->local_ref, env->global_ref, r))
+    return r;
+
   hashmap<string,tree> H2;
   env->read_env (H2);
   env->write_env (H);
+  int impure= env->impure;
+  bool track= env->track_reads;
+  hashmap<string,bool> vars= env->read_vars, refs= env->read_refs;
+  env->track_reads= true;
+  env->read_vars= hashmap<string,bool> (false);
+  env->read_refs= hashmap<string,bool> (false);
   t= env->exec (t);
+  env->track_reads= track;
+  hashmap<string,bool> used (false);
   if (expand_refs)
-    t= expand_references (t, buf->data->ref);
+    t= expand_references (t, buf->data->ref, used);
+  tree deps= memo_dependencies (env->read_vars, env->read_refs, used, H,
+                                env->local_ref, env->global_ref);
+  env->read_vars= vars;
+  env->read_refs= refs;
   t= simplify_execed (t);
   t= simplify_correct (t);
   env->write_env (H2);
+  if (env->impure == impure) memo_remember (the_style, key, t, deps);
   return t;
 }
 
@@ -93,6 +93,10 @@ frame reslash (metric slash, metric proto);
 void  normalize_borders (glyph& gl, metric& ex);
 
 glyph shrink      (glyph gl, int xf, int yf, SI& xo, SI& yo);
+glyph shrink      (glyph gl, int xf, int yf,
+                   int dx, int dy, int tx, int ty, SI& xo, SI& yo);
+glyph shrink_reference (glyph gl, int xf, int yf,
+                        int dx, int dy, int tx, int ty, SI& xo, SI& yo);
 glyph join        (glyph gl1, glyph gl2);
 glyph intersect   (glyph gl1, glyph gl2);
 glyph exclude     (glyph gl1, glyph gl2);
@@ -11,6 +11,13 @@
 
 #include "bitmap_font.hpp"
 #include "renderer.hpp"
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 static int
 log2i (int i) {
@@ -150,9 +157,13 @@ get_ver_shift (glyph gl, int yfactor, int ty) {
   return my_mod (gl->height- gl->yoff- 1- middle, yfactor);
 }
 
+/******************************************************************************
+* Reference implementation of the shrinking, pixel by pixel
+******************************************************************************/
+
 glyph
-shrink (glyph gl, int xfactor, int yfactor,
-	int dx, int dy, int tx, int ty, SI& xo, SI& yo)
+shrink_reference (glyph gl, int xfactor, int yfactor,
+                  int dx, int dy, int tx, int ty, SI& xo, SI& yo)
 {
   /*
   cout << "------------------------------------------------------------------------------\n";
@@ -215,6 +226,148 @@ shrink (glyph gl, int xfactor, int yfactor,
   return CB;
 }
 
+/******************************************************************************
+* Vectorized kernels for the shrinking
+******************************************************************************/
+
+static inline void
+or_row (QN* dest, const QN* src, int n) {
+  int i= 0;
+#if defined(__AVX2__)
+  for (; i+32 <= n; i+=32) {
+    __m256i a= _mm256_loadu_si256 ((const __m256i*) (dest+i));
+    __m256i b= _mm256_loadu_si256 ((const __m256i*) (src+i));
+    _mm256_storeu_si256 ((__m256i*) (dest+i), _mm256_or_si256 (a, b));
+  }
+#elif defined(__SSE2__)
+  for (; i+16 <= n; i+=16) {
+    __m128i a= _mm_loadu_si128 ((const __m128i*) (dest+i));
+    __m128i b= _mm_loadu_si128 ((const __m128i*) (src+i));
+    _mm_storeu_si128 ((__m128i*) (dest+i), _mm_or_si128 (a, b));
+  }
+#endif
+  for (; i<n; i++) dest[i] |= src[i];
+}
+
+static inline void
+add_row (unsigned short* sum, const QN* src, int n) {
+  int i= 0;
+#if defined(__AVX2__)
+  for (; i+16 <= n; i+=16) {
+    __m256i a= _mm256_loadu_si256 ((const __m256i*) (sum+i));
+    __m256i b= _mm256_cvtepu8_epi16 (_mm_loadu_si128 ((const __m128i*) (src+i)));
+    _mm256_storeu_si256 ((__m256i*) (sum+i), _mm256_add_epi16 (a, b));
+  }
+#elif defined(__SSE2__)
+  __m128i zero= _mm_setzero_si128 ();
+  for (; i+8 <= n; i+=8) {
+    __m128i a= _mm_loadu_si128 ((const __m128i*) (sum+i));
+    __m128i b= _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i*) (src+i)),
+                                  zero);
+    _mm_storeu_si128 ((__m128i*) (sum+i), _mm_add_epi16 (a, b));
+  }
+#endif
+  for (; i<n; i++) sum[i] += src[i];
+}
+
+struct expand_table {
+  // the eight pixels of each byte of a packed raster
+  unsigned long long pixels[256];
+  expand_table () {
+    for (int b=0; b<256; b++) {
+      QN bytes[8];
+      for (int i=0; i<8; i++) bytes[i]= (b >> i) & 1;
+      memcpy (&pixels[b], bytes, 8);
+    }
+  }
+};
+
+static QN*
+unpack_glyph (glyph gl) {
+  // One byte per pixel; the rows of the packed raster are contiguous
+  static const expand_table expand;
+  int i, n= gl->width * gl->height, nb= (n+7) >> 3;
+  QN* r= tm_new_array<QN> (nb << 3);
+  for (i=0; i<nb; i++)
+    memcpy (r + (i<<3), &expand.pixels[gl->raster[i]], 8);
+  return r;
+}
+
+/******************************************************************************
+* Shrinking glyphs
+******************************************************************************/
+
+glyph
+shrink (glyph gl, int xfactor, int yfactor,
+	int dx, int dy, int tx, int ty, SI& xo, SI& yo)
+{
+  // The blocks of the reference implementation are only square ones
+  if (xfactor != yfactor)
+    return shrink_reference (gl, xfactor, yfactor, dx, dy, tx, ty, xo, yo);
+
+  int x1= dx- gl->xoff;
+  int x2= dx- gl->xoff+ gl->width+ tx;
+  int X1= my_div (x1, xfactor);
+  int X2= my_div (x2+xfactor-1, xfactor);
+
+  int y1= dy+ gl->yoff+ 1- gl->height;
+  int y2= dy+ gl->yoff+ 1+ ty;
+  int Y1= my_div (y1, yfactor);
+  int Y2= my_div (y2+yfactor-1, yfactor);
+
+  int frac_x= (dx- gl->xoff- X1*xfactor);
+  int frac_y= (dy+ gl->yoff- Y1*yfactor);
+  SI  off_x = (((-X1) *xfactor+ dx)*PIXEL + ((tx*PIXEL)>>1))/xfactor;
+  SI  off_y = (((Y2-1)*yfactor- dy)*PIXEL - ((ty*PIXEL)>>1))/yfactor;
+
+  // Rasterize the glyph, thickened by tx and ty, on a byte per pixel;
+  // the rows of the bitmap go upwards, the rows of the glyph downwards
+  int i, j, y, w= gl->width, dw= w+ tx;
+  int ww=(X2-X1)*xfactor, hh=(Y2-Y1)*yfactor;
+  QN* pixels= unpack_glyph (gl);
+  QN* bitmap= tm_new_array<QN> (ww*hh);
+  QN* row   = tm_new_array<QN> (dw);
+  memset (bitmap, 0, ww*hh);
+  for (y=0; y<gl->height; y++) {
+    QN* src= pixels + y*w;
+    if (tx != 0) {
+      memset (row, 0, dw);
+      for (i=0; i<=tx; i++) or_row (row + i, src, w);
+      src= row;
+    }
+    for (j=0; j<=ty; j++)
+      or_row (bitmap + (frac_y- y+ ty- j)*ww + frac_x, src, dw);
+  }
+
+  // Sum over the blocks: first the columns, then the rows
+  int X, Y, nr= xfactor*yfactor;
+  int new_depth= gl->depth+ log2i (nr);
+  if (new_depth > 8) new_depth= 8;
+  glyph CB (X2-X1, Y2-Y1, -X1, Y2-1, new_depth, gl->status);
+  CB->index = gl->index;
+  unsigned short* col= tm_new_array<unsigned short> (ww);
+  for (Y=Y1; Y<Y2; Y++) {
+    memset (col, 0, ww * sizeof (unsigned short));
+    for (j=0; j<yfactor; j++)
+      add_row (col, bitmap + ((Y-Y1)*yfactor + j)*ww, ww);
+    for (X=X1; X<X2; X++) {
+      int sum= 0;
+      unsigned short* c= col + (X-X1)*xfactor;
+      for (i=0; i<xfactor; i++) sum += c[i];
+      if (nr >= 64) sum= (64 * sum) / nr;
+      if (new_depth == 1) CB->set (X, Y, sum);
+      else CB->raster[(Y2-1-Y)*CB->width + (X-X1)]= sum;
+    }
+  }
+  xo= off_x;
+  yo= off_y;
+  tm_delete_array (col);
+  tm_delete_array (row);
+  tm_delete_array (bitmap);
+  tm_delete_array (pixels);
+  return CB;
+}
+
 glyph
 shrink (glyph gl, int xfactor, int yfactor, SI& xo, SI& yo) {
   if ((gl->width==0) || (gl->height==0)) {
@@ -13,6 +13,10 @@
 #define RASTER_H
 #include "raster_operators.hpp"
 #include "unary_function.hpp"
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <vector>
 
 /******************************************************************************
 * Raster class
@@ -718,12 +722,221 @@ gaussian_pen (double rx, double ry, double phi, double order= 2.5) {
     return pixelize<C> (fun, w, w, R, R, 1);
 }
 
+/******************************************************************************
+* Parallel processing of bands of rows
+******************************************************************************/
+
+#define RASTER_PARALLEL_WORK 1000000
+
+template<typename Fun> void
+parallel_bands (int n, double work, const Fun& fun) {
+    // Apply fun (start, end) to consecutive bands which cover [0, n),
+    // using several threads if the estimated work is large enough.
+    // The bands must write to disjoint data and fun should only access
+    // raw arrays, since the reference counting of rasters is not atomic.
+    int nr= 1;
+    if (work >= RASTER_PARALLEL_WORK) {
+        nr= (int) std::thread::hardware_concurrency ();
+        nr= std::min (nr, (int) (work / (RASTER_PARALLEL_WORK / 2)));
+        nr= std::min (nr, n);
+    }
+    if (nr <= 1) {
+        if (n > 0) fun (0, n);
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (int i=1; i<nr; i++) {
+        int start= (int) ((((long long) i) * n) / nr);
+        int end  = (int) ((((long long) (i+1)) * n) / nr);
+        threads.emplace_back ([&fun, start, end] () { fun (start, end); });
+    }
+    fun (0, n / nr);
+    for (auto& t: threads) t.join ();
+}
+
+/******************************************************************************
+* Fast Fourier transforms
+******************************************************************************/
+
+inline int
+fft_size (int n) {
+    // length of the transforms for convolutions with a pen of size n
+    int p= 32;
+    while (p < 2*n) p <<= 1;
+    return p;
+}
+
+inline void
+fft_twiddles (int n, std::vector<double>& cs, std::vector<double>& sn) {
+    cs.resize (n/2);
+    sn.resize (n/2);
+    for (int k=0; k<n/2; k++) {
+        cs[k]= cos ((2 * M_PI * k) / n);
+        sn[k]= sin ((2 * M_PI * k) / n);
+    }
+}
+
+template<typename C> void
+fft (C* re, C* im, int n, const double* cs, const double* sn, bool inv) {
+    // in place radix 2 transform of length n, where cs[k] + i sn[k] is
+    // exp (2 pi i k / n); the inverse transform is not normalized
+    for (int i=1, j=0; i<n; i++) {
+        int bit= n >> 1;
+        for (; (j & bit) != 0; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            std::swap (re[i], re[j]);
+            std::swap (im[i], im[j]);
+        }
+    }
+    for (int len=2; len<=n; len <<= 1) {
+        int half= len >> 1, step= n / len;
+        for (int i=0; i<n; i+=len)
+            for (int j=0; j<half; j++) {
+                double wr= cs[j*step], wi= (inv? sn[j*step]: -sn[j*step]);
+                int p= i + j, q= p + half;
+                C vr= re[q] * wr - im[q] * wi;
+                C vi= re[q] * wi + im[q] * wr;
+                re[q]= re[p] - vr;
+                im[q]= im[p] - vi;
+                re[p] += vr;
+                im[p] += vi;
+            }
+    }
+}
+
+struct fft_plan {
+    int pw, ph;
+    std::vector<double> csx, snx, csy, sny;
+    fft_plan (int pw2, int ph2): pw (pw2), ph (ph2) {
+        fft_twiddles (pw, csx, snx);
+        fft_twiddles (ph, csy, sny); }
+};
+
+template<typename C> void
+fft_2d (const fft_plan& p, C* re, C* im, C* col_re, C* col_im,
+        int rows, bool inv) {
+    // two dimensional transform of a pw x ph buffer; for the direct
+    // transform, only the first rows may be non zero, and for the
+    // inverse transform, only the first rows of the result are computed
+    int pw= p.pw, ph= p.ph;
+    if (!inv)
+        for (int y=0; y<rows; y++)
+            fft (re + y*pw, im + y*pw, pw, &p.csx[0], &p.snx[0], false);
+    for (int x=0; x<pw; x++) {
+        for (int y=0; y<ph; y++) {
+            col_re[y]= re[y*pw+x];
+            col_im[y]= im[y*pw+x];
+        }
+        fft (col_re, col_im, ph, &p.csy[0], &p.sny[0], inv);
+        for (int y=0; y<ph; y++) {
+            re[y*pw+x]= col_re[y];
+            im[y*pw+x]= col_im[y];
+        }
+    }
+    if (inv)
+        for (int y=0; y<rows; y++)
+            fft (re + y*pw, im + y*pw, pw, &p.csx[0], &p.snx[0], true);
+}
+
+/******************************************************************************
+* Convolution engines on raw arrays, which accumulate into d
+******************************************************************************/
+
+template<typename C, typename S> void
+direct_convolute (C* d, const C* s1, int s1w, int s1h,
+                  const S* s2, int s2w, int s2h) {
+    // For each pixel of d, the terms are added in the same order as
+    // in a loop over the rows of s1, so that the result does not depend
+    // on the number of threads
+    int dw= s1w + s2w - 1, dh= s1h + s2h - 1;
+    double work= ((double) s1w) * s1h * s2w * s2h;
+    parallel_bands (dh, work, [=] (int start, int end) {
+        for (int yd=start; yd<end; yd++) {
+            int o= yd * dw;
+            int y2lo= std::max (0, yd - s1h + 1), y2hi= std::min (s2h - 1, yd);
+            for (int y2=y2hi; y2>=y2lo; y2--) {
+                int o1= (yd - y2) * s1w, o2= y2 * s2w;
+                for (int x1=0; x1<s1w; x1++)
+                    for (int x2=0; x2<s2w; x2++)
+                        d[o+x1+x2] += s1[o1+x1] * s2[o2+x2];
+            }
+        }
+    });
+}
+
+inline double
+fft_convolute_work (int s1w, int s1h, int s2w, int s2h) {
+    int pw= fft_size (s2w), ph= fft_size (s2h);
+    int tw= pw - s2w + 1, th= ph - s2h + 1;
+    double tiles= ((double) ((s1w + tw - 1) / tw)) * ((s1h + th - 1) / th);
+    return 6 * tiles * pw * ph * log2 (((double) pw) * ph);
+}
+
+template<typename C, typename S> void
+fft_convolute (C* d, const C* s1, int s1w, int s1h,
+               const S* s2, int s2w, int s2h) {
+    // Overlap-add: s1 is cut into tiles which are convolved with s2 using
+    // transforms of a fixed size.  The contributions of two tiles of the
+    // same column may overlap in d, so even and odd rows of tiles are
+    // handled in two successive parallel passes.
+    int dw= s1w + s2w - 1;
+    fft_plan p (fft_size (s2w), fft_size (s2h));
+    int pw= p.pw, ph= p.ph, n= pw * ph;
+    int tw= pw - s2w + 1, th= ph - s2h + 1;
+    int ntx= (s1w + tw - 1) / tw, nty= (s1h + th - 1) / th;
+
+    std::vector<double> kre (n, 0.0), kim (n, 0.0), kcr (ph), kci (ph);
+    for (int y2=0; y2<s2h; y2++)
+        for (int x2=0; x2<s2w; x2++)
+            kre[y2*pw+x2]= (double) s2[y2*s2w+x2];
+    fft_2d (p, &kre[0], &kim[0], &kcr[0], &kci[0], s2h, false);
+    const double* kr= &kre[0];
+    const double* ki= &kim[0];
+    const fft_plan* pp= &p;
+
+    double work= fft_convolute_work (s1w, s1h, s2w, s2h);
+    for (int parity=0; parity<2; parity++)
+        parallel_bands ((nty + 1 - parity) / 2, work / 2,
+                        [=] (int start, int end) {
+            std::vector<C> re (n), im (n), col_re (ph), col_im (ph);
+            double scale= 1.0 / ((double) n);
+            for (int k=start; k<end; k++) {
+                int y0= (2*k + parity) * th, rows= std::min (th, s1h - y0);
+                for (int tx=0; tx<ntx; tx++) {
+                    int x0= tx * tw, cols= std::min (tw, s1w - x0);
+                    for (int i=0; i<n; i++) {
+                        clear (re[i]);
+                        clear (im[i]);
+                    }
+                    for (int y=0; y<rows; y++)
+                        for (int x=0; x<cols; x++)
+                            re[y*pw+x]= s1[(y0+y)*s1w + x0+x];
+                    fft_2d (*pp, &re[0], &im[0], &col_re[0], &col_im[0],
+                            rows, false);
+                    for (int i=0; i<n; i++) {
+                        C r= re[i], m= im[i];
+                        re[i]= r * kr[i] - m * ki[i];
+                        im[i]= r * ki[i] + m * kr[i];
+                    }
+                    int orows= rows + s2h - 1, ocols= cols + s2w - 1;
+                    fft_2d (*pp, &re[0], &im[0], &col_re[0], &col_im[0],
+                            orows, true);
+                    for (int y=0; y<orows; y++)
+                        for (int x=0; x<ocols; x++)
+                            d[(y0+y)*dw + x0+x] += re[y*pw+x] * scale;
+                }
+            }
+        });
+}
+
 /******************************************************************************
 * Convolution and blur
 ******************************************************************************/
 
 template<typename C, typename S> raster<C>
 convolute (raster<C> s1, raster<S> s2) {
+    // Large pens are handled using Fourier transforms
     if (s1->w * s1->h == 0) return s1;
     TM_ASSERT (s2->w * s2->h != 0, "empty convolution argument");
     int s1w= s1->w, s1h= s1->h, s2w= s2->w, s2h= s2->h;
@@ -731,13 +944,10 @@ convolute (raster<C> s1, raster<S> s2) {
     raster<C> d (dw, dh, s1->ox + s2->ox, s1->oy + s2->oy);
     clear (d);
     raster<C> temp= mul_alpha (s1);
-    for (int y1=0; y1<s1h; y1++)
-        for (int y2=0; y2<s2h; y2++) {
-            int o1= y1 * s1w, o2= y2 * s2w, o= (y1 + y2) * dw;
-            for (int x1=0; x1<s1w; x1++)
-                for (int x2=0; x2<s2w; x2++)
-                    d->a[o+x1+x2] += temp->a[o1+x1] * s2->a[o2+x2];
-        }
+    double direct_work= ((double) s1w) * s1h * s2w * s2h;
+    if (fft_convolute_work (s1w, s1h, s2w, s2h) < direct_work)
+        fft_convolute (d->a, temp->a, s1w, s1h, s2->a, s2w, s2h);
+    else direct_convolute (d->a, temp->a, s1w, s1h, s2->a, s2w, s2h);
     return div_alpha (d);
 }
 
@@ -780,20 +990,32 @@ factored_convolute (raster<C> s1, raster<S> s2) {
     raster<C> temp= mul_alpha (s1);
     raster<C> aux (dw, s1h, s1->ox + s2->ox, s1->oy);
     clear (aux);
-    for (int y1=0; y1<s1h; y1++) {
-        int o1= y1 * s1w, o= y1 * dw;
-        for (int x1=0; x1<s1w; x1++)
-            for (int x2=0; x2<s2w; x2++)
-                aux->a[o+x1+x2] += temp->a[o1+x1] * xs->a[x2];
-    }
     raster<C> d (dw, dh, s1->ox + s2->ox, s1->oy + s2->oy);
     clear (d);
-    for (int y1=0; y1<s1h; y1++)
-        for (int y2=0; y2<s2h; y2++) {
-            int o1= y1 * dw, o= (y1 + y2) * dw;
-            for (int x1=0; x1<dw; x1++)
-                d->a[o+x1] += aux->a[o1+x1] * ys->a[y2];
+    const C* src= temp->a;
+    const S* xa= xs->a;
+    const S* ya= ys->a;
+    C* ax= aux->a;
+    C* da= d->a;
+    parallel_bands (s1h, ((double) s1w) * s1h * s2w, [=] (int start, int end) {
+        for (int y1=start; y1<end; y1++) {
+            int o1= y1 * s1w, o= y1 * dw;
+            for (int x1=0; x1<s1w; x1++)
+                for (int x2=0; x2<s2w; x2++)
+                    ax[o+x1+x2] += src[o1+x1] * xa[x2];
         }
+    });
+    parallel_bands (dh, ((double) dw) * s1h * s2h, [=] (int start, int end) {
+        for (int yd=start; yd<end; yd++) {
+            int o= yd * dw;
+            int y2lo= std::max (0, yd - s1h + 1), y2hi= std::min (s2h - 1, yd);
+            for (int y2=y2hi; y2>=y2lo; y2--) {
+                int o1= (yd - y2) * dw;
+                for (int x1=0; x1<dw; x1++)
+                    da[o+x1] += ax[o1+x1] * ya[y2];
+            }
+        }
+    });
     return div_alpha (d);
 }
 
@@ -835,14 +1057,24 @@ thicken (raster<C> s1, raster<S> s2) {
     int s1w= s1->w, s1h= s1->h, s2w= s2->w, s2h= s2->h, dw= d->w;
     raster<F> temp= get_alpha (s1);
     clear_alpha (d);
-    for (int y1=0; y1<s1h; y1++)
-        for (int y2=0; y2<s2h; y2++) {
-            int o1= y1 * s1w, o2= y2 * s2w, o= (y1 + y2) * dw;
-            for (int x1=0; x1<s1w; x1++)
-                for (int x2=0; x2<s2w; x2++)
-                    src_over (get_alpha (d->a[o+x1+x2]),
-                              temp->a[o1+x1] * s2->a[o2+x2]);
+    int dh= d->h;
+    const F* ta= temp->a;
+    const S* pa= s2->a;
+    C* da= d->a;
+    double work= ((double) s1w) * s1h * s2w * s2h;
+    parallel_bands (dh, work, [=] (int start, int end) {
+        for (int yd=start; yd<end; yd++) {
+            int o= yd * dw;
+            int y2lo= std::max (0, yd - s1h + 1), y2hi= std::min (s2h - 1, yd);
+            for (int y2=y2hi; y2>=y2lo; y2--) {
+                int o1= (yd - y2) * s1w, o2= y2 * s2w;
+                for (int x1=0; x1<s1w; x1++)
+                    for (int x2=0; x2<s2w; x2++)
+                        src_over (get_alpha (da[o+x1+x2]),
+                                  ta[o1+x1] * pa[o2+x2]);
+            }
         }
+    });
     return d;
 }
 
@@ -869,28 +1101,111 @@ erode (C& dest_a, const C& src_a, const C& pen_a) {
     dest_a= std::min (dest_a, a);
 }
 
+template<typename F> void
+running_min (F* t, const F* s, int n, int l, F* g, F* h) {
+    // van Herk / Gil-Werman filter: t[i] is the minimum of s over the
+    // window [i-l+1, i] clipped to [0, n), for 0 <= i < n+l-1.
+    // The minima are computed from prefix and suffix minima on blocks
+    // of length l, using two auxiliary arrays g and h of size n+l-1.
+    int m= n + l - 1;
+    F inf= std::numeric_limits<F>::infinity ();
+    for (int i=0; i<m; i++) {
+        F v= (i < n? s[i]: inf);
+        g[i]= (i % l == 0? v: std::min (g[i-1], v));
+    }
+    for (int i=m-1; i>=0; i--) {
+        F v= (i < n? s[i]: inf);
+        h[i]= (i % l == l-1 || i == m-1? v: std::min (h[i+1], v));
+    }
+    for (int i=0; i<m; i++)
+        t[i]= (i < l-1? g[i]: std::min (h[i-l+1], g[i]));
+}
+
 template<typename C, typename S> raster<C>
 erode (raster<C> s1, raster<S> s2) {
+    // Each row of the pen is decomposed into runs of equal values.
+    // Since src * p + (1 - p) increases with src, the contribution of
+    // a run only depends on the minimum of src over a sliding window,
+    // which is computed using running_min.  Pens with too many runs,
+    // such as smooth pens, are handled directly.
     typedef typename C::scalar_type F;
     if (s1->w * s1->h == 0) return s1;
     TM_ASSERT (s2->w * s2->h != 0, "empty pen");
     raster<C> d= copy (s1);
     int s1w= s1->w, s1h= s1->h, s2w= s2->w, s2h= s2->h, dw= d->w;//, dh= d->h;
+    int s2ox= s2->ox, s2oy= s2->oy;
     raster<F> temp= get_alpha (s1);
     //for (int i=0; i<dw*dh; i++)
     //  get_alpha (d->a[i])= F (1.0);
-    for (int y1=0; y1<s1h; y1++)
-        for (int y2=0; y2<s2h; y2++) {
-            int yd= y1 + y2 - s2->oy;
-            if (yd < 0 || yd >= s1h) continue;
-            int o1= y1 * s1w, o2= y2 * s2w, o= yd * dw;
-            for (int x1=0; x1<s1w; x1++)
-                for (int x2=0; x2<s2w; x2++) {
-                    int xd= x1 + x2 - s2->ox;
-                    if (xd < 0 || xd >= s1w) continue;
-                    erode (get_alpha (d->a[o+xd]), temp->a[o1+x1], s2->a[o2+x2]);
-                }
+    const F* ta= temp->a;
+    const S* pa= s2->a;
+    C* da= d->a;
+
+    std::vector<int> run_y, run_x, run_l;
+    for (int y2=0; y2<s2h; y2++)
+        for (int x2=0; x2<s2w; ) {
+            int l= 1;
+            while (x2 + l < s2w && pa[y2*s2w+x2+l] == pa[y2*s2w+x2]) l++;
+            run_y.push_back (y2);
+            run_x.push_back (x2);
+            run_l.push_back (l);
+            x2 += l;
         }
+    int nr= (int) run_y.size ();
+
+    if (2 * nr >= s2w * s2h) {
+        double work= ((double) s1w) * s1h * s2w * s2h;
+        parallel_bands (s1h, work, [=] (int start, int end) {
+            for (int yd=start; yd<end; yd++)
+                for (int y2=0; y2<s2h; y2++) {
+                    int y1= yd - y2 + s2oy;
+                    if (y1 < 0 || y1 >= s1h) continue;
+                    int o1= y1 * s1w, o2= y2 * s2w, o= yd * dw;
+                    for (int x1=0; x1<s1w; x1++)
+                        for (int x2=0; x2<s2w; x2++) {
+                            int xd= x1 + x2 - s2ox;
+                            if (xd < 0 || xd >= s1w) continue;
+                            erode (get_alpha (da[o+xd]), ta[o1+x1], pa[o2+x2]);
+                        }
+                }
+        });
+        return d;
+    }
+
+    std::vector<int> lengths (run_l);
+    std::sort (lengths.begin (), lengths.end ());
+    lengths.erase (std::unique (lengths.begin (), lengths.end ()),
+                   lengths.end ());
+    const int* ry= &run_y[0];
+    const int* rx= &run_x[0];
+    const int* rl= &run_l[0];
+    for (int l: lengths) {
+        int m= s1w + l - 1;
+        std::vector<F> mins (((size_t) s1h) * m);
+        F* ma= &mins[0];
+        double work= 3.0 * s1h * m;
+        parallel_bands (s1h, work, [=] (int start, int end) {
+            std::vector<F> g (m), h (m);
+            for (int y1=start; y1<end; y1++)
+                running_min (ma + y1*m, ta + y1*s1w, s1w, l, &g[0], &h[0]);
+        });
+        parallel_bands (s1h, ((double) s1w) * s1h * nr, [=] (int start, int end) {
+            for (int yd=start; yd<end; yd++)
+                for (int r=0; r<nr; r++) {
+                    if (rl[r] != l) continue;
+                    int y1= yd - ry[r] + s2oy;
+                    if (y1 < 0 || y1 >= s1h) continue;
+                    F p= pa[ry[r]*s2w + rx[r]];
+                    const F* row= ma + y1*m;
+                    int o= yd * dw;
+                    for (int xd=0; xd<s1w; xd++) {
+                        int hi= xd + s2ox - rx[r];
+                        if (hi < 0 || hi >= m) continue;
+                        erode (get_alpha (da[o+xd]), row[hi], p);
+                    }
+                }
+        });
+    }
     return d;
 }
 
@@ -904,23 +1219,33 @@ variation (raster<C> s1, raster<S> s2) {
     if (s1->w * s1->h == 0) return s1;
     TM_ASSERT (s2->w * s2->h != 0, "empty pen");
     raster<C> d= convolute (s1, s2);
+    int s1w= s1->w, s1h= s1->h;
     int s2w= s2->w, s2h= s2->h, dw= d->w, dh= d->h;
     int s2ox= s2->ox, s2oy= s2->oy;
     raster<F> temp= get_alpha (s1);
-    for (int y0=0; y0<dh; y0++)
-        for (int x0=0; x0<dw; x0++) {
-            int x1= x0 - s2ox, y1= y0 - s2oy;
-            F ref= temp->internal_get_pixel (x1, y1);
-            F min_v= 0, max_v= 0;
-            for (int y2=0; y2<s2h; y2++)
-                for (int x2=0; x2<s2w; x2++) {
-                    F cur= temp->internal_get_pixel (x1 - (x2 - s2ox), y1 - (y2 - s2oy));
-                    F v= (cur - ref) * s2->a[y2*s2w + x2];
-                    max_v= std::max (max_v, v);
-                    min_v= std::min (min_v, v);
-                }
-            get_alpha (d->a[y0*dw + x0]) = max_v - min_v;
-        }
+    const F* ta= temp->a;
+    const S* pa= s2->a;
+    C* da= d->a;
+    auto pixel= [ta, s1w, s1h] (int x, int y) -> F {
+        if (x >= 0 && s1w > x && y >= 0 && s1h > y) return ta[y*s1w+x];
+        else return F (0); };
+    double work= ((double) dw) * dh * s2w * s2h;
+    parallel_bands (dh, work, [=] (int start, int end) {
+        for (int y0=start; y0<end; y0++)
+            for (int x0=0; x0<dw; x0++) {
+                int x1= x0 - s2ox, y1= y0 - s2oy;
+                F ref= pixel (x1, y1);
+                F min_v= 0, max_v= 0;
+                for (int y2=0; y2<s2h; y2++)
+                    for (int x2=0; x2<s2w; x2++) {
+                        F cur= pixel (x1 - (x2 - s2ox), y1 - (y2 - s2oy));
+                        F v= (cur - ref) * pa[y2*s2w + x2];
+                        max_v= std::max (max_v, v);
+                        min_v= std::min (min_v, v);
+                    }
+                get_alpha (da[y0*dw + x0]) = max_v - min_v;
+            }
+    });
     return d;
 }
 
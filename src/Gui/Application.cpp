@@ -53,6 +53,12 @@ void texmacs::Application::withCurrentEditor(std::function<void(edit_interface_r
 }
 
 void texmacs::Application::showSchemeImplementationChooserWidget() {
+    // Helper processes use the resources extracted by the interactive process
+    if (helper_mode) {
+        QTimer::singleShot(0, this, SLOT(onApplicationStarted()));
+        return;
+    }
+
     mWelcomeWidget = new WelcomeWidget();
     mWelcomeWidget->show();
 
@@ -7,6 +7,7 @@
 #include <QKeySequence>
 #include <QMimeData>
 #include <QBuffer>
+#include <QThread>
 
 
 #include "edit_interface.hpp"
@@ -19,6 +20,10 @@ texmacs::DocumentWidget::DocumentWidget(qt_simple_widget_rep *drawer, edit_inter
     assert(drawer != nullptr);
     assert(editor != nullptr);
 
+    // Keep one core for the GUI thread, which records the tiles
+    mParallelRendering = QThread::idealThreadCount() > 1;
+    mTilePool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+
     drawer->associatedDocumentWidget = this;
 
     setAttribute(Qt::WA_NoSystemBackground);
@@ -42,26 +47,210 @@ texmacs::DocumentWidget::DocumentWidget(qt_simple_widget_rep *drawer, edit_inter
     //mTextEdit.viewport()->installEventFilter(this);
 }
 
+texmacs::DocumentWidget::~DocumentWidget() {
+    // The results of the pending tiles are posted to this widget
+    mTilePool.waitForDone();
+}
+
+static inline int floorDiv(int a, int b) {
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
 void texmacs::DocumentWidget::paint(QPainter &painter) {
 
     painter.setRenderHint(QPainter::Antialiasing, true);
     painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
 
-    QPixmap antialiasedPixmap(painter.device()->width() * retina_factor, painter.device()->height() * retina_factor);
-    QPainter *antialiasedPainter = new QPainter(&antialiasedPixmap);
-    antialiasedPainter->setRenderHint(QPainter::Antialiasing, true);
-    antialiasedPainter->setRenderHint(QPainter::SmoothPixmapTransform, true);
+    // The backing store is a cache of tiles, so that scrolling only needs to
+    // render the newly exposed tiles and small invalidations (like a blinking
+    // cursor) only repaint the part of the tiles they intersect. The tiles
+    // form a grid in the logical pixels of the document, like the scroll
+    // origin, while their contents and dirty regions are in device pixels.
+    if (mDrawer->invalidated_all || mTilesZoom != mDrawer->zoom_factor || mTilesRetina != retina_factor) {
+        mTiles.clear();
+        mTilesZoom = mDrawer->zoom_factor;
+        mTilesRetina = retina_factor;
+        mTileSpan = qMax(1, TileSize / retina_factor);
+        mTilesGeneration++;
+        mDrawer->invalidated_all = false;
+    }
 
+    // The invalid regions are recorded in device pixels, relative to the
+    // last backing position, which is in logical pixels
+    QPoint backingPos = mDrawer->backing_pos * retina_factor;
+    rectangles rects = mDrawer->invalid_regions;
+    mDrawer->invalid_regions = rectangles();
+    while (!is_nil(rects)) {
+        rectangle r = rects->item;
+        invalidateTiles(QRect(r->x1 + backingPos.x(), r->y1 + backingPos.y(), r->x2 - r->x1, r->y2 - r->y1));
+        rects = rects->next;
+    }
 
-    qt_renderer_rep ren(antialiasedPainter, antialiasedPainter->device()->width(), antialiasedPainter->device()->height());
-    mDrawer->invalidate_all();
-    mDrawer->repaint_invalid_regions(&ren);
+    QPoint org = origin();
+    mDrawer->backing_pos = org;
+
+    int tx1 = floorDiv(org.x(), mTileSpan);
+    int ty1 = floorDiv(org.y(), mTileSpan);
+    int tx2 = floorDiv(org.x() + painter.device()->width() - 1, mTileSpan);
+    int ty2 = floorDiv(org.y() + painter.device()->height() - 1, mTileSpan);
+    int extent = tileSize();
+
+    QList<quint64> dirtyTiles;
+    for (int ty = ty1; ty <= ty2; ty++) {
+        for (int tx = tx1; tx <= tx2; tx++) {
+            auto it = mTiles.find(tileKey(tx, ty));
+            if (it == mTiles.end()) {
+                QImage image(extent, extent, QImage::Format_ARGB32_Premultiplied);
+                image.fill(palette().color(QPalette::Base));
+                it = mTiles.insert(tileKey(tx, ty), Tile{image, QRegion(0, 0, extent, extent)});
+            }
+            if (!it->dirty.isEmpty() && !it->pending) {
+                dirtyTiles << tileKey(tx, ty);
+            }
+        }
+    }
 
-    // Delete the painter
-    delete antialiasedPainter;
+    // Walking the boxes is not thread safe, so the dirty tiles are recorded
+    // on the GUI thread. When several tiles are dirty (when scrolling or in
+    // zoomed out views), only the recording is done here and the much more
+    // expensive rasterization is done concurrently by the worker threads.
+    // The tiles are composited as soon as their rasterization is finished.
+    bool interrupted = false;
+    bool parallel = mParallelRendering && dirtyTiles.size() > 1;
+    for (quint64 key : dirtyTiles) {
+        Tile &tile = mTiles[key];
+        int tx = int(quint32(key >> 32));
+        int ty = int(quint32(key & 0xffffffff));
+        if (!parallel) {
+            interrupted = !renderTile(tx, ty, tile);
+        } else {
+            QPicture picture;
+            interrupted = !recordTile(tx, ty, tile, picture);
+            if (!interrupted) {
+                rasterizeTile(key, tile.image, picture);
+            }
+        }
+        if (interrupted) {
+            break;
+        }
+    }
 
     painter.scale(1.0 / retina_factor, 1.0 / retina_factor);
-    painter.drawPixmap(0, 0, antialiasedPixmap);
+    for (int ty = ty1; ty <= ty2; ty++) {
+        for (int tx = tx1; tx <= tx2; tx++) {
+            painter.drawImage((tx * mTileSpan - org.x()) * retina_factor,
+                              (ty * mTileSpan - org.y()) * retina_factor,
+                              mTiles[tileKey(tx, ty)].image);
+        }
+    }
+
+    evictTiles(tx1, ty1, tx2, ty2);
+
+    // Interrupted tiles stay dirty and are completed during the next paint
+    if (interrupted) {
+        update();
+    }
+}
+
+void texmacs::DocumentWidget::invalidateTiles(const QRect &rect) {
+    if (rect.isEmpty()) {
+        return;
+    }
+    int extent = tileSize();
+    int tx1 = floorDiv(rect.left(), extent);
+    int ty1 = floorDiv(rect.top(), extent);
+    int tx2 = floorDiv(rect.right(), extent);
+    int ty2 = floorDiv(rect.bottom(), extent);
+    for (int ty = ty1; ty <= ty2; ty++) {
+        for (int tx = tx1; tx <= tx2; tx++) {
+            auto it = mTiles.find(tileKey(tx, ty));
+            if (it == mTiles.end()) {
+                continue;
+            }
+            QRect tileRect(tx * extent, ty * extent, extent, extent);
+            it->dirty += rect.intersected(tileRect).translated(-tileRect.topLeft());
+        }
+    }
+}
+
+bool texmacs::DocumentWidget::renderTile(int tx, int ty, Tile &tile) {
+    QRect r = tile.dirty.boundingRect();
+
+    QPainter tilePainter(&tile.image);
+    tilePainter.setRenderHint(QPainter::Antialiasing, true);
+    tilePainter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+
+    qt_renderer_rep ren(&tilePainter, tileSize(), tileSize());
+    if (mDrawer->repaint_rect(&ren, QPoint(tx * mTileSpan, ty * mTileSpan),
+                              r.left(), r.top(), r.right() + 1, r.bottom() + 1)) {
+        tile.dirty = QRegion();
+        return true;
+    }
+    return false;
+}
+
+bool texmacs::DocumentWidget::recordTile(int tx, int ty, Tile &tile, QPicture &picture) {
+    QRect r = tile.dirty.boundingRect();
+
+    QPainter recorder(&picture);
+    recorder.setRenderHint(QPainter::Antialiasing, true);
+    recorder.setRenderHint(QPainter::SmoothPixmapTransform, true);
+
+    qt_renderer_rep ren(&recorder, tileSize(), tileSize());
+    if (mDrawer->repaint_rect(&ren, QPoint(tx * mTileSpan, ty * mTileSpan),
+                              r.left(), r.top(), r.right() + 1, r.bottom() + 1)) {
+        // Later invalidations accumulate in dirty while the tile is pending
+        tile.dirty = QRegion();
+        tile.pending = true;
+        return true;
+    }
+    return false;
+}
+
+void texmacs::DocumentWidget::rasterizeTile(quint64 key, QImage image, QPicture picture) {
+    // The image and the picture are implicitly shared with atomic reference
+    // counts, so the worker detaches its own copy of the tile before painting
+    int generation = mTilesGeneration;
+    mTilePool.start([this, key, generation, image, picture]() mutable {
+        {
+            QPainter tilePainter(&image);
+            tilePainter.setRenderHint(QPainter::Antialiasing, true);
+            tilePainter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+            tilePainter.drawPicture(0, 0, picture);
+        }
+        QMetaObject::invokeMethod(this, [this, key, generation, image]() {
+            tileRasterized(key, generation, image);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void texmacs::DocumentWidget::tileRasterized(quint64 key, int generation, QImage image) {
+    if (generation != mTilesGeneration) {
+        return;
+    }
+    auto it = mTiles.find(key);
+    if (it == mTiles.end()) {
+        return;
+    }
+    it->image = image;
+    it->pending = false;
+    update();
+}
+
+void texmacs::DocumentWidget::evictTiles(int tx1, int ty1, int tx2, int ty2) {
+    // Keep one screen worth of tiles around the visible ones, so that
+    // scrolling back and forth does not render the same tiles again
+    int mx = tx2 - tx1 + 1;
+    int my = ty2 - ty1 + 1;
+    for (auto it = mTiles.begin(); it != mTiles.end();) {
+        int tx = int(quint32(it.key() >> 32));
+        int ty = int(quint32(it.key() & 0xffffffff));
+        if (tx < tx1 - mx || tx > tx2 + mx || ty < ty1 - my || ty > ty2 + my) {
+            it = mTiles.erase(it);
+        } else {
+            ++it;
+        }
+    }
 }
 
 bool texmacs::DocumentWidget::event(QEvent *event) {
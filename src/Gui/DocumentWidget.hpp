@@ -17,6 +17,11 @@
 #include <QPlainTextEdit>
 #include <QVBoxLayout>
 #include <QGestureEvent>
+#include <QHash>
+#include <QRegion>
+#include <QImage>
+#include <QPicture>
+#include <QThreadPool>
 
 #include "ThingyTabInnerWindow.hpp"
 
@@ -33,6 +38,8 @@ namespace texmacs {
     public:
         DocumentWidget(qt_simple_widget_rep *drawer, edit_interface_rep *editor, ThingyTabInnerWindow *parent);
 
+        ~DocumentWidget() override;
+
         void paintEvent(QPaintEvent *event) override {
             if (!isVisible()) {
                 return;
@@ -108,10 +115,58 @@ namespace texmacs {
             return mEditor;
         }
 
+        /// When enabled, the tiles which need to be repainted are rasterized
+        /// concurrently on a pool of worker threads (see paint)
+        void setParallelRendering(bool enabled) {
+            mParallelRendering = enabled;
+        }
+
+        bool parallelRendering() const {
+            return mParallelRendering;
+        }
+
     public slots:
         void updateText();
 
     private:
+        /// Maximal size in device pixels of the square tiles of the backing store
+        static constexpr int TileSize = 256;
+
+        /// Size in device pixels of the tiles, which span mTileSpan logical pixels
+        int tileSize() const {
+            return mTileSpan * mTilesRetina;
+        }
+
+        /// A tile of the backing store, positioned on a grid of mTileSpan logical
+        /// pixels, whose image and dirty region are in device pixels. Only the
+        /// dirty part of a tile is repainted by the drawer. A tile is pending
+        /// while it is being rasterized by a worker thread.
+        struct Tile {
+            QImage image;
+            QRegion dirty;
+            bool pending = false;
+        };
+
+        static quint64 tileKey(int tx, int ty) {
+            return (quint64(quint32(tx)) << 32) | quint64(quint32(ty));
+        }
+
+        void invalidateTiles(const QRect &rect);
+        bool renderTile(int tx, int ty, Tile &tile);
+        bool recordTile(int tx, int ty, Tile &tile, QPicture &picture);
+        void rasterizeTile(quint64 key, QImage image, QPicture picture);
+        void tileRasterized(quint64 key, int generation, QImage image);
+        void evictTiles(int tx1, int ty1, int tx2, int ty2);
+
+        QHash<quint64, Tile> mTiles;
+        double mTilesZoom = 0.0;
+        int mTilesRetina = 0;
+        int mTileSpan = TileSize;
+        int mTilesGeneration = 0;
+
+        bool mParallelRendering;
+        QThreadPool mTilePool;
+
         ThingyTabInnerWindow *mParent;
         qt_simple_widget_rep *mDrawer;
         edit_interface_rep *mEditor;
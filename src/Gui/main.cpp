@@ -140,6 +140,11 @@ int main(int argc, char** argv) {
                           return 0;
                       });
 
+    argsParser.option({"--print-helper"}, "", [](std::vector<std::string> &args, int pos) {
+        helper_mode = true;
+        return 0;
+    });
+
     argsParser.option({"-r", "--reverse"}, "Reverse video mode", [](std::vector<std::string> &args, int pos) {
         set_reverse_colors(true);;
         return 0;
@@ -243,5 +248,7 @@ int main(int argc, char** argv) {
     app.showSchemeImplementationChooserWidget();
 
     // Execute the application
-    return app.exec();
+    int ret = app.exec();
+    release_interned_strings();
+    return ret;
 }
@@ -327,6 +327,8 @@ raw_set_cursor (tree& ref, int pos, tree data) {
   // consistency_check ();
 }
 
+int modification_stamp= 0;
+
 void
 raw_apply (tree& t, modification mod) {
   TM_ASSERT (is_applicable (t, mod), "invalid modification");
@@ -360,6 +362,7 @@ raw_apply (tree& t, modification mod) {
     break;
   }
   packrat_invalid_colors= true;
+  if (mod->k != MOD_SET_CURSOR) modification_stamp++;
 }
 
 /******************************************************************************
@@ -0,0 +1,271 @@
+
+/******************************************************************************
+* MODULE     : flat_hashmap.cpp
+* DESCRIPTION: hashmaps with open addressing and reference counting
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#ifndef FLAT_HASHMAP_CC
+#define FLAT_HASHMAP_CC
+#include "flat_hashmap.hpp"
+#define TMPL template<class T, class U>
+#define H hashentry<T,U>
+
+// The table is enlarged beyond a load of 7/8 and shrunk below 1/4
+#define FLAT_FULL(size,n) (8*(size) > 7*(n))
+#define FLAT_SPARSE(size,n) ((n) > 1 && 4*(size) < (n))
+
+/******************************************************************************
+* Low level routines
+******************************************************************************/
+
+TMPL
+flat_hashmap_rep<T,U>::flat_hashmap_rep (U init2, int n2, int max2):
+  size (0), n (1), init (init2)
+{
+  while (n < n2 * max2) n <<= 1;
+  dist= tm_new_array<int> (n);
+  a   = tm_new_array<H> (n);
+  for (int i=0; i<n; i++) dist[i]= -1;
+}
+
+TMPL int
+flat_hashmap_rep<T,U>::find (T x, int hv) {
+  int mask= n-1, i= hv & mask;
+  for (int d=0; dist[i] >= d; d++, i= (i+1) & mask)
+    if (a[i].code == hv && a[i].key == x)
+      return i;
+  return -1;
+}
+
+TMPL int
+flat_hashmap_rep<T,U>::insert (int hv, T x, U y) {
+  // The key should not yet be present and the table should not be full.
+  // Returns the slot in which the new entry was stored.
+  int mask= n-1, i= hv & mask, d= 0, pos= -1;
+  H e (hv, x, y);
+  while (dist[i] >= 0) {
+    if (dist[i] < d) {
+      H tmp= a[i]; a[i]= e; e= tmp;
+      int td= dist[i]; dist[i]= d; d= td;
+      if (pos < 0) pos= i;
+    }
+    i= (i+1) & mask;
+    d++;
+  }
+  a[i]= e;
+  dist[i]= d;
+  size++;
+  return pos < 0? i: pos;
+}
+
+TMPL void
+flat_hashmap_rep<T,U>::erase (int i) {
+  // Backward shift deletion: no tombstones are needed
+  int mask= n-1, j= (i+1) & mask;
+  while (dist[j] > 0) {
+    a[i]= a[j];
+    dist[i]= dist[j] - 1;
+    i= j;
+    j= (j+1) & mask;
+  }
+  a[i]= H ();
+  dist[i]= -1;
+  size--;
+}
+
+/******************************************************************************
+* Routines for hashmaps
+******************************************************************************/
+
+TMPL void
+flat_hashmap_rep<T,U>::resize (int n2) {
+  int i;
+  int oldn= n;
+  int* oldd= dist;
+  H*   olda= a;
+  n= 1;
+  while (n < n2 || FLAT_FULL (size, n)) n <<= 1;
+  dist= tm_new_array<int> (n);
+  a   = tm_new_array<H> (n);
+  for (i=0; i<n; i++) dist[i]= -1;
+  size= 0;
+  for (i=0; i<oldn; i++)
+    if (oldd[i] >= 0)
+      (void) insert (olda[i].code, olda[i].key, olda[i].im);
+  tm_delete_array (oldd);
+  tm_delete_array (olda);
+}
+
+TMPL bool
+flat_hashmap_rep<T,U>::contains (T x) {
+  return find (x, hash (x)) >= 0;
+}
+
+TMPL bool
+flat_hashmap_rep<T,U>::empty () {
+  return size==0;
+}
+
+TMPL U&
+flat_hashmap_rep<T,U>::bracket_rw (T x) {
+  int hv= hash (x);
+  int i = find (x, hv);
+  if (i >= 0) return a[i].im;
+  if (FLAT_FULL (size+1, n)) resize (n<<1);
+  return a[insert (hv, x, init)].im;
+}
+
+TMPL U
+flat_hashmap_rep<T,U>::bracket_ro (T x) {
+  int i= find (x, hash (x));
+  if (i >= 0) return a[i].im;
+  return init;
+}
+
+TMPL void
+flat_hashmap_rep<T,U>::reset (T x) {
+  int i= find (x, hash (x));
+  if (i < 0) return;
+  erase (i);
+  if (FLAT_SPARSE (size, n)) resize (n>>1);
+}
+
+TMPL void
+flat_hashmap_rep<T,U>::generate (void (*routine) (T)) {
+  int i;
+  for (i=0; i<n; i++)
+    if (dist[i] >= 0)
+      routine (a[i].key);
+}
+
+TMPL tm_ostream&
+operator << (tm_ostream& out, flat_hashmap<T,U> h) {
+  int i= 0, j= 0, n= h->n, size= h->size;
+  out << "{ ";
+  for (; i<n; i++)
+    if (h->dist[i] >= 0) {
+      out << h->a[i];
+      if (j != size-1) out << ", ";
+      j++;
+    }
+  out << " }";
+  return out;
+}
+
+TMPL flat_hashmap<T,U>::operator tree () {
+  int i=0, j=0, n=rep->n, size=rep->size;
+  tree t (COLLECTION, size);
+  for (; i<n; i++)
+    if (rep->dist[i] >= 0)
+      t[j++]= (tree) rep->a[i];
+  return t;
+}
+
+TMPL void
+flat_hashmap_rep<T,U>::join (flat_hashmap<T,U> h) {
+  int i= 0, n= h->n;
+  for (; i<n; i++)
+    if (h->dist[i] >= 0)
+      bracket_rw (h->a[i].key)= copy (h->a[i].im);
+}
+
+TMPL bool
+operator == (flat_hashmap<T,U> h1, flat_hashmap<T,U> h2) {
+  if (h1->size != h2->size) return false;
+  int i= 0, n= h1->n;
+  for (; i<n; i++)
+    if (h1->dist[i] >= 0)
+      if (h2[h1->a[i].key] != h1->a[i].im) return false;
+  return true;
+}
+
+TMPL bool
+operator != (flat_hashmap<T,U> h1, flat_hashmap<T,U> h2) {
+  return !(h1 == h2);
+}
+
+/******************************************************************************
+* Extra routines for environments
+******************************************************************************/
+
+TMPL void
+flat_hashmap_rep<T,U>::write_back (T x, flat_hashmap<T,U> base) {
+  int hv= hash (x);
+  if (find (x, hv) >= 0) return;
+  int j= base->find (x, hv);
+  U y= (j >= 0? base->a[j].im: base->init);
+  if (FLAT_FULL (size+1, n)) resize (n<<1);
+  (void) insert (hv, x, y);
+}
+
+TMPL void
+flat_hashmap_rep<T,U>::pre_patch (flat_hashmap<T,U> patch,
+                                  flat_hashmap<T,U> base) {
+  int i= 0, n= patch->n;
+  for (; i<n; i++)
+    if (patch->dist[i] >= 0) {
+      T x= patch->a[i].key;
+      U y= contains (x)? bracket_ro (x): patch->a[i].im;
+      if (base[x] == y) reset (x);
+      else bracket_rw (x)= y;
+    }
+}
+
+TMPL void
+flat_hashmap_rep<T,U>::post_patch (flat_hashmap<T,U> patch,
+                                   flat_hashmap<T,U> base) {
+  int i= 0, n= patch->n;
+  for (; i<n; i++)
+    if (patch->dist[i] >= 0) {
+      T x= patch->a[i].key;
+      U y= patch->a[i].im;
+      if (base[x] == y) reset (x);
+      else bracket_rw (x)= y;
+    }
+}
+
+TMPL flat_hashmap<T,U>
+copy (flat_hashmap<T,U> h) {
+  int i, n= h->n;
+  flat_hashmap<T,U> h2 (h->init, n);
+  h2->size= h->size;
+  for (i=0; i<n; i++) {
+    h2->dist[i]= h->dist[i];
+    if (h->dist[i] >= 0)
+      h2->a[i]= H (h->a[i].code, h->a[i].key, h->a[i].im);
+  }
+  return h2;
+}
+
+TMPL flat_hashmap<T,U>
+changes (flat_hashmap<T,U> patch, flat_hashmap<T,U> base) {
+  int i;
+  flat_hashmap<T,U> h (base->init);
+  for (i=0; i<patch->n; i++)
+    if (patch->dist[i] >= 0)
+      if (patch->a[i].im != base [patch->a[i].key])
+        h (patch->a[i].key)= patch->a[i].im;
+  return h;
+}
+
+TMPL flat_hashmap<T,U>
+invert (flat_hashmap<T,U> patch, flat_hashmap<T,U> base) {
+  int i;
+  flat_hashmap<T,U> h (base->init);
+  for (i=0; i<patch->n; i++)
+    if (patch->dist[i] >= 0)
+      if (patch->a[i].im != base [patch->a[i].key])
+        h (patch->a[i].key)= base [patch->a[i].key];
+  return h;
+}
+
+#undef FLAT_SPARSE
+#undef FLAT_FULL
+#undef H
+#undef TMPL
+#endif // defined FLAT_HASHMAP_CC
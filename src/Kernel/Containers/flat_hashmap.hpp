@@ -0,0 +1,93 @@
+
+/******************************************************************************
+* MODULE     : flat_hashmap.hpp
+* DESCRIPTION: hashmaps with open addressing and reference counting
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#ifndef FLAT_HASHMAP_H
+#define FLAT_HASHMAP_H
+#include "hashmap.hpp"
+
+/******************************************************************************
+* A flat_hashmap<T,U> has the same interface as a hashmap<T,U>, but stores
+* its entries (together with their hash codes) directly inside one array,
+* using robin hood hashing for the collision resolution. Insertions do not
+* allocate list nodes and lookups do not chase pointers, which makes it
+* the preferred choice for heavily used maps.
+******************************************************************************/
+
+template<class T,class U> class flat_hashmap;
+template<class T,class U> class flat_hashmap_iterator_rep;
+
+template<class T,class U> int N (flat_hashmap<T,U> a);
+template<class T,class U> tm_ostream& operator << (tm_ostream& out, flat_hashmap<T,U> h);
+template<class T,class U> flat_hashmap<T,U> copy (flat_hashmap<T,U> h);
+template<class T,class U> flat_hashmap<T,U> changes (flat_hashmap<T,U> p, flat_hashmap<T,U> b);
+template<class T,class U> flat_hashmap<T,U> invert (flat_hashmap<T,U> p, flat_hashmap<T,U> b);
+template<class T,class U> bool operator == (flat_hashmap<T,U> h1, flat_hashmap<T,U> h2);
+template<class T,class U> bool operator != (flat_hashmap<T,U> h1, flat_hashmap<T,U> h2);
+
+template<class T, class U> class flat_hashmap_rep: concrete_struct {
+  int size;                  // size of hashmap (nr of entries)
+  int n;                     // nr of slots (a power of two)
+  U   init;                  // default entry
+  int* dist;                 // distance to the ideal slot, -1 if empty
+  hashentry<T,U>* a;         // the array of entries
+
+  int  find (T x, int hv);
+  int  insert (int hv, T x, U y);
+  void erase (int i);
+
+public:
+  flat_hashmap_rep<T,U> (U init2, int n2=1, int max2=1);
+  inline ~flat_hashmap_rep<T,U> () {
+    tm_delete_array (dist); tm_delete_array (a); }
+  void resize (int n);
+  void reset (T x);
+  void generate (void (*routine) (T));
+  bool contains (T x);
+  bool empty ();
+  U    bracket_ro (T x);
+  U&   bracket_rw (T x);
+  void join (flat_hashmap<T,U> H);
+
+  friend class flat_hashmap<T,U>;
+  friend class flat_hashmap_iterator_rep<T,U>;
+  friend int N LESSGTR (flat_hashmap<T,U> h);
+  friend tm_ostream& operator << LESSGTR (tm_ostream& out, flat_hashmap<T,U> h);
+
+  void write_back (T x, flat_hashmap<T,U> base);
+  void pre_patch (flat_hashmap<T,U> patch, flat_hashmap<T,U> base);
+  void post_patch (flat_hashmap<T,U> patch, flat_hashmap<T,U> base);
+  friend flat_hashmap<T,U> copy LESSGTR (flat_hashmap<T,U> h);
+  friend flat_hashmap<T,U> changes LESSGTR (flat_hashmap<T,U> patch, flat_hashmap<T,U> base);
+  friend flat_hashmap<T,U> invert LESSGTR (flat_hashmap<T,U> patch, flat_hashmap<T,U> base);
+
+  friend bool operator == LESSGTR (flat_hashmap<T,U> h1, flat_hashmap<T,U> h2);
+  friend bool operator != LESSGTR (flat_hashmap<T,U> h1, flat_hashmap<T,U> h2);
+};
+
+template<class T, class U> class flat_hashmap {
+CONCRETE_TEMPLATE_2(flat_hashmap,T,U);
+  inline flat_hashmap ():
+    rep (tm_new<flat_hashmap_rep<T,U> > (type_helper<U>::init_val (), 1, 1)) {}
+  inline flat_hashmap (U init, int n=1, int max=1):
+    rep (tm_new<flat_hashmap_rep<T,U> > (init, n, max)) {}
+  inline U  operator [] (T x) { return rep->bracket_ro (x); }
+  inline U& operator () (T x) { return rep->bracket_rw (x); }
+  operator tree ();
+};
+CONCRETE_TEMPLATE_2_CODE(flat_hashmap,class,T,class,U);
+
+#define TMPL template<class T, class U>
+TMPL inline int N (flat_hashmap<T,U> h) { return h->size; }
+#undef TMPL
+
+#include "flat_hashmap.cpp"
+
+#endif // defined FLAT_HASHMAP_H
@@ -12,6 +12,7 @@
 #ifndef ITERATOR_CC
 #define ITERATOR_CC
 #include "hashmap.hpp"
+#include "flat_hashmap.hpp"
 #include "hashset.hpp"
 #include "iterator.hpp"
 
@@ -136,4 +137,44 @@ iterate (hashmap<T,U> h) {
 }
 // hashmap_iterator
 
+// flat_hashmap_iterator
+template<class T, class U>
+class flat_hashmap_iterator_rep: public iterator_rep<T> {
+  flat_hashmap<T,U> h;
+  int i;
+  void spool ();
+
+public:
+  flat_hashmap_iterator_rep (flat_hashmap<T,U> h);
+  bool busy ();
+  T next ();
+};
+
+template<class T, class U>
+flat_hashmap_iterator_rep<T,U>::flat_hashmap_iterator_rep
+  (flat_hashmap<T,U> h2): h (h2), i (0) {}
+
+template<class T, class U> void
+flat_hashmap_iterator_rep<T,U>::spool () {
+  while (i < h->n && h->dist[i] < 0) i++;
+}
+
+template<class T, class U> bool
+flat_hashmap_iterator_rep<T,U>::busy () {
+  spool ();
+  return i < h->n;
+}
+
+template<class T, class U> T
+flat_hashmap_iterator_rep<T,U>::next () {
+  TM_ASSERT (busy (), "end of iterator");
+  return h->a[i++].key;
+}
+
+template<class T, class U> iterator<T>
+iterate (flat_hashmap<T,U> h) {
+  return tm_new<flat_hashmap_iterator_rep<T,U> > (h);
+}
+// flat_hashmap_iterator
+
 #endif // defined ITERATOR_CC
@@ -114,6 +114,7 @@ bool is_applicable (tree t, modification mod);
 tree clean_apply (tree t, modification mod);
 void raw_apply (tree& t, modification mod);      // in observer.cpp
 void apply (tree& t, modification mod);          // in observer.cpp
+extern int modification_stamp;                   // in observer.cpp
 
 /******************************************************************************
 * Hooks
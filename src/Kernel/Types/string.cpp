@@ -29,21 +29,35 @@ round_length (int n) {
 }
 
 string_rep::string_rep (int n2):
-  n(n2), a ((n==0)?((char*) NULL):tm_new_array<char> (round_length(n))) {}
+  n(n2), a ((n<=STRING_INLINE)? b: tm_new_array<char> (round_length(n))),
+  interned (false) {}
 
 void
 string_rep::resize (int m) {
-  int nn= round_length (n);
-  int mm= round_length (m);
-  if (mm != nn) {
-    if (mm != 0) {
+  if (m <= STRING_INLINE) {
+    if (a != b) {
       int i, k= (m<n? m: n);
-      char* b= tm_new_array<char> (mm);
       for (i=0; i<k; i++) b[i]= a[i];
-      if (nn != 0) tm_delete_array (a);
+      tm_delete_array (a);
       a= b;
     }
-    else if (nn != 0) tm_delete_array (a);
+  }
+  else if (a == b) {
+    int i;
+    char* c= tm_new_array<char> (round_length (m));
+    for (i=0; i<n; i++) c[i]= a[i];
+    a= c;
+  }
+  else {
+    int nn= round_length (n);
+    int mm= round_length (m);
+    if (mm != nn) {
+      int i, k= (m<n? m: n);
+      char* c= tm_new_array<char> (mm);
+      for (i=0; i<k; i++) c[i]= a[i];
+      tm_delete_array (a);
+      a= c;
+    }
   }
   n= m;
 }
@@ -102,7 +116,9 @@ string::operator != (const char* s) {
 bool
 string::operator == (string a) {
   int i;
+  if (rep == a.rep) return true;
   if (rep->n!=a->n) return false;
+  if (rep->interned && a->interned) return false;
   for (i=0; i<rep->n; i++)
     if (rep->a[i]!=a->a[i]) return false;
   return true;
@@ -111,7 +127,9 @@ string::operator == (string a) {
 bool
 string::operator != (string a) {
   int i;
+  if (rep == a.rep) return false;
   if (rep->n!=a->n) return true;
+  if (rep->interned && a->interned) return true;
   for (i=0; i<rep->n; i++)
     if (rep->a[i]!=a->a[i]) return true;
   return false;
@@ -132,13 +150,22 @@ string::operator () (int begin, int end) {
 string
 copy (string s) {
   int i, n=N(s);
+  char* S= s.data ();
   string r (n);
-  for (i=0; i<n; i++) r[i]=s[i];
+  for (i=0; i<n; i++) r[i]=S[i];
   return r;
 }
 
+void
+string::detach () {
+  // strings share their representation when copied, and interned strings
+  // even share it with unrelated strings of the same contents
+  if (rep->ref_count > 1) *this= copy (*this);
+}
+
 string&
 operator << (string& a, char x) {
+  if (is_interned (a)) a= copy (a);
   a->resize (N(a)+ 1);
   a [N(a)-1]=x;
   return a;
@@ -147,17 +174,20 @@ operator << (string& a, char x) {
 string&
 operator << (string& a, string b) {
   int i, k1= N(a), k2=N(b);
+  if (is_interned (a)) a= copy (a);
   a->resize (k1+k2);
-  for (i=0; i<k2; i++) a[i+k1]= b[i];
+  char* B= b.data ();
+  for (i=0; i<k2; i++) a[i+k1]= B[i];
   return a;
 }
 
 string
 operator * (string a, string b) {
   int i, n1=N(a), n2=N(b);
+  char *A= a.data (), *B= b.data ();
   string c(n1+n2);
-  for (i=0; i<n1; i++) c[i]=a[i];
-  for (i=0; i<n2; i++) c[i+n1]=b[i];
+  for (i=0; i<n1; i++) c[i]=A[i];
+  for (i=0; i<n2; i++) c[i+n1]=B[i];
   return c;
 }
 
@@ -174,10 +204,11 @@ operator * (string a, const char* b) {
 bool
 operator < (string s1, string s2) {
   int i;
+  char *S1= s1.data (), *S2= s2.data ();
   for (i=0; i<N(s1); i++) {
     if (i>=N(s2)) return false;
-    if (s1[i]<s2[i]) return true;
-    if (s2[i]<s1[i]) return false;
+    if (S1[i]<S2[i]) return true;
+    if (S2[i]<S1[i]) return false;
   }
   return i<N(s2);
 }
@@ -185,10 +216,11 @@ operator < (string s1, string s2) {
 bool
 operator <= (string s1, string s2) {
   int i;
+  char *S1= s1.data (), *S2= s2.data ();
   for (i=0; i<N(s1); i++) {
     if (i>=N(s2)) return false;
-    if (s1[i]<s2[i]) return true;
-    if (s2[i]<s1[i]) return false;
+    if (S1[i]<S2[i]) return true;
+    if (S2[i]<S1[i]) return false;
   }
   return true;
 }
@@ -197,20 +229,114 @@ tm_ostream&
 operator << (tm_ostream& out, string a) {
   int i, n=N(a);
   if (n==0) return out;
-  for (i=0; i<n; i++) out << a[i];
+  char* A= a.data ();
+  for (i=0; i<n; i++) out << A[i];
   return out;
 }
 
-int
-hash (string s) {
-  int i, h=0, n=N(s);
+static inline int
+compute_hash (const char* a, int n) {
+  int i, h=0;
   for (i=0; i<n; i++) {
     h=(h<<9)+(h>>23);
-    h=h+((int) s[i]);
+    h=h+((int) a[i]);
   }
   return h;
 }
 
+int
+string_rep::code () {
+  // the hash code of an interned string is kept in the inline storage
+  int h;
+  memcpy (&h, b, sizeof (int));
+  return h;
+}
+
+int
+hash (string s) {
+  if (s->interned) return s->code ();
+  return compute_hash (s->a, s->n);
+}
+
+/******************************************************************************
+* Interning
+******************************************************************************/
+
+/* The intern table maps each string contents to a unique shared
+   representation, so that equal interned strings are equal as pointers and
+   carry their hash code. Interned representations are never modified:
+   operator << copies them first, and writes through operator [] are only
+   allowed after detach, as for any other shared string. The table keeps
+   them alive until release_interned_strings is called at the end of the
+   session. Like the reference counts, the table is not thread safe,
+   so that strings are only interned by the main thread. */
+
+static string_rep** intern_table= NULL;
+static int intern_n   = 0;  // nr of slots (a power of two)
+static int intern_size= 0;  // nr of interned strings
+
+string
+intern (string s) {
+  if (s->interned) return s;
+  int h= compute_hash (s->a, s->n);
+  if (2 * (intern_size + 1) > intern_n) {
+    int i, n2= (intern_n == 0? 1024: intern_n << 1);
+    string_rep** t2= tm_new_array<string_rep*> (n2);
+    for (i=0; i<n2; i++) t2[i]= NULL;
+    for (i=0; i<intern_n; i++)
+      if (intern_table[i] != NULL) {
+        int j= intern_table[i]->code () & (n2-1);
+        while (t2[j] != NULL) j= (j+1) & (n2-1);
+        t2[j]= intern_table[i];
+      }
+    if (intern_table != NULL) tm_delete_array (intern_table);
+    intern_table= t2;
+    intern_n= n2;
+  }
+  int i= h & (intern_n-1);
+  for (; intern_table[i] != NULL; i= (i+1) & (intern_n-1)) {
+    string_rep* r= intern_table[i];
+    if (r->n == s->n && r->code () == h &&
+        memcmp (r->a, s->a, s->n) == 0) {
+      string c;
+      INC_COUNT (r);
+      DEC_COUNT (c.rep);
+      c.rep= r;
+      return c;
+    }
+  }
+  string c (0);
+  c->a= tm_new_array<char> (round_length (std::max (s->n, 1)));
+  c->n= s->n;
+  memcpy (c->a, s->a, s->n);
+  memcpy (c->b, &h, sizeof (int));
+  c->interned= true;
+  INC_COUNT (c.rep); // the table keeps a reference
+  intern_table[i]= c.rep;
+  intern_size++;
+  return c;
+}
+
+bool
+is_interned (string s) {
+  return s->interned;
+}
+
+void
+release_interned_strings () {
+  // the strings which are still in use become ordinary strings, since
+  // equal strings which are interned later will no longer share them
+  for (int i=0; i<intern_n; i++)
+    if (intern_table[i] != NULL) {
+      intern_table[i]->interned= false;
+      DEC_COUNT (intern_table[i]);
+    }
+  if (intern_table != NULL) tm_delete_array (intern_table);
+  intern_table= NULL;
+  intern_n    = 0;
+  intern_size = 0;
+}
+
 /******************************************************************************
 * Conversion routines
 ******************************************************************************/
@@ -15,19 +15,29 @@
 
 #include "basic.hpp"
 
+// Short strings are stored inside string_rep, which then fits in 32 bytes
+#define STRING_INLINE 7
+
 class string;
 class string_rep: concrete_struct {
   int n;
   char* a;
+  char b[STRING_INLINE]; // inline storage, or hash code of interned strings
+  bool interned;         // interned strings are shared and never modified
 
 public:
-  inline string_rep (): n(0), a(NULL) {}
+  inline string_rep (): n(0), a(b), interned(false) {}
          string_rep (int n);
-  inline ~string_rep () { if (n!=0) tm_delete_array (a); }
+  inline ~string_rep () { if (a != b) tm_delete_array (a); }
   void resize (int n);
+  int  code ();
 
   friend class string;
   friend inline int N (string a);
+  friend int hash (string s);
+  friend string intern (string s);
+  friend bool is_interned (string s);
+  friend void release_interned_strings ();
 };
 
 class string {
@@ -39,12 +49,15 @@ class string {
   string (const char *s);
   string (const char *s, int n);
   inline char& operator [] (int i) { return rep->a[i]; }
+  inline char operator [] (int i) const { return rep->a[i]; }
   bool operator == (const char* s);
   bool operator != (const char* s);
   bool operator == (string s);
   bool operator != (string s);
   string operator () (int start, int end);
   char *data() { return rep->a; }
+  void detach (); // call before writing through [] into a shared string
+  friend string intern (string s);
 };
 CONCRETE_CODE(string);
 
@@ -59,6 +72,9 @@ string   operator * (string a, const char* b);
 bool     operator < (string a, string b);
 bool     operator <= (string a, string b);
 int      hash (string s);
+string   intern (string s);
+bool     is_interned (string s);
+void     release_interned_strings ();
 
 bool     as_bool   (string s);
 int      as_int    (string s);
@@ -253,6 +253,20 @@ replace (tree t, tree w, tree b) {
   }
 }
 
+void
+intern_atoms (tree t, int max_len) {
+  // share the labels of short atoms, which are frequently repeated in
+  // documents (variable names, tags, spaces, numbers, ...)
+  if (is_atomic (t)) {
+    if (N(t->label) <= max_len) t->label= intern (t->label);
+  }
+  else {
+    int i, n= N(t);
+    for (i=0; i<n; i++)
+      intern_atoms (t[i], max_len);
+  }
+}
+
 /******************************************************************************
 * Tree predicates
 ******************************************************************************/
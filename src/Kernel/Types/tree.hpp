@@ -249,6 +249,7 @@ inline string as_string (tree t) {
   else return ""; }
 string tree_as_string (tree t);
 tree replace (tree t, tree w, tree b);
+void intern_atoms (tree t, int max_len= 32);
 template<class T> inline tree as_tree (T x) { return (tree) x; }
 template<> inline tree as_tree (int x) { return as_string (x); }
 template<> inline tree as_tree (long int x) { return as_string (x); }
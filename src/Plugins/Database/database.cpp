@@ -17,26 +17,16 @@
 * Constructors
 ******************************************************************************/
 
-db_line_rep::db_line_rep (db_atom id2, db_atom attr2, db_atom val2,
-                          db_time created2, db_time expires2):
-  id (id2), attr (attr2), val (val2), created (created2), expires (expires2) {}
-
-db_line::db_line () {
-  rep= tm_new<db_line_rep> (0, 0, 0, DB_MAX_TIME, DB_MAX_TIME); }
-
-db_line::db_line (db_atom id, db_atom attr, db_atom val,
-                  db_time created, db_time expires) {
-  rep= tm_new<db_line_rep> (id, attr, val, created, expires); }
-
 database_rep::database_rep (url u, bool clone):
-  db_name (u), db (), outdated (0), with_history (!clone),
+  db_name (u), db_id (), db_attr (), db_val (), db_created (), db_expires (),
+  outdated (0), with_history (!clone),
   atom_encode (-1), atom_decode (),
   id_lines (), val_lines (), ids_list (), ids_set (),
-  error_flag (false), loaded (""), pending (""),
-  start_pending (0), time_stamp (0),
+  error_flag (false), loaded (0), loaded_code (0), pending (""),
+  start_pending (0), time_stamp (0), checkpointed (0),
   key_encode (-1), key_decode (),
   atom_indexed (), key_occurrences (),
-  key_completions (), name_completions ()
+  key_trie (), name_trie ()
 {
   if (is_none (db_name)) error_flag= false;
   else if (!clone) initialize ();
@@ -61,16 +51,18 @@ database_rep::create_atom (string s) {
     id_lines << db_line_nrs ();
     val_lines << db_line_nrs ();
     atom_indexed << false;
-    name_indexed << false;
   }
   return atom_encode[s];
 }
 
 db_line_nr
 database_rep::extend_field (db_atom id, db_atom attr, db_atom val, db_time t) {
-  db_line_nr nr= (db_line_nr) N(db);
-  db_line l (id, attr, val, t, DB_MAX_TIME);
-  db << l;
+  db_line_nr nr= (db_line_nr) nr_lines ();
+  db_id << id;
+  db_attr << attr;
+  db_val << val;
+  db_created << t;
+  db_expires << DB_MAX_TIME;
   id_lines[id] << nr;
   val_lines[val] << nr;
   if (!ids_set->contains (id)) {
@@ -186,9 +178,9 @@ database_rep::get_field (db_atom id, db_atom attr, db_time t) {
   db_atoms r;
   db_line_nrs nrs= id_lines[id];
   for (int i=0; i<N(nrs); i++) {
-    db_line& l= db[nrs[i]];
-    if (l->attr == attr && ((t == 0) || (l->created <= t && t < l->expires)))
-      r << l->val;
+    db_line_nr nr= nrs[i];
+    if (db_attr[nr] == attr && is_active (nr, t))
+      r << db_val[nr];
   }
   return r;
 }
@@ -197,9 +189,9 @@ void
 database_rep::remove_field (db_atom id, db_atom attr, db_time t) {
   db_line_nrs nrs= id_lines[id];
   for (int i=0; i<N(nrs); i++) {
-    db_line& l= db[nrs[i]];
-    if (l->attr == attr && l->expires == DB_MAX_TIME) {
-      l->expires= t;
+    db_line_nr nr= nrs[i];
+    if (db_attr[nr] == attr && db_expires[nr] == DB_MAX_TIME) {
+      db_expires[nr]= t;
       notify_removed_field (nrs[i]);
       outdated++;
     }
@@ -212,11 +204,11 @@ database_rep::get_attributes (db_atom id, db_time t) {
   db_atoms r;
   db_line_nrs nrs= id_lines[id];
   for (int i=0; i<N(nrs); i++) {
-    db_line& l= db[nrs[i]];
-    if ((t == 0) || (l->created <= t && t < l->expires))
-      if (!done->contains (l->attr)) {
-        done->insert (l->attr);
-        r << l->attr;
+    db_line_nr nr= nrs[i];
+    if (is_active (nr, t))
+      if (!done->contains (db_attr[nr])) {
+        done->insert (db_attr[nr]);
+        r << db_attr[nr];
       }
   }
   return r;
@@ -238,9 +230,9 @@ database_rep::get_entry (db_atom id, db_time t) {
   db_atoms r;
   db_line_nrs nrs= id_lines[id];
   for (int i=0; i<N(nrs); i++) {
-    db_line& l= db[nrs[i]];
-    if ((t == 0) || (l->created <= t && t < l->expires))
-      r << l->attr << l->val;
+    db_line_nr nr= nrs[i];
+    if (is_active (nr, t))
+      r << db_attr[nr] << db_val[nr];
   }
   return r;
 }
@@ -249,9 +241,9 @@ void
 database_rep::remove_entry (db_atom id, db_time t) {
   db_line_nrs nrs= id_lines[id];
   for (int i=0; i<N(nrs); i++) {
-    db_line& l= db[nrs[i]];
-    if (l->expires == DB_MAX_TIME) {
-      l->expires= t;
+    db_line_nr nr= nrs[i];
+    if (db_expires[nr] == DB_MAX_TIME) {
+      db_expires[nr]= t;
       notify_removed_field (nrs[i]);
       outdated++;
     }
@@ -262,10 +254,11 @@ void
 database_rep::inspect_history (db_atom name) {
   db_line_nrs nrs= val_lines[name];
   for (int i=0; i<N(nrs); i++) {
-    db_line& l= db[nrs[i]];
-    if (from_atom (l->attr) == "name")
-      cout << from_atom (l->id) << ", name, " << from_atom (l->val) << ", "
-           << ((long int) l->created) << ", " << ((long int) l->expires) << LF;
+    db_line_nr nr= nrs[i];
+    if (from_atom (db_attr[nr]) == "name")
+      cout << from_atom (db_id[nr]) << ", name, " << from_atom (db_val[nr])
+           << ", " << ((long int) db_created[nr])
+           << ", " << ((long int) db_expires[nr]) << LF;
   }
 }
 
@@ -378,3 +371,15 @@ get_name_completions (url u, string s) {
   database db= get_database (u);
   return db->compute_name_completions (s);
 }
+
+strings
+get_fuzzy_completions (url u, string s) {
+  database db= get_database (u);
+  return db->compute_completions (s, true);
+}
+
+strings
+get_fuzzy_name_completions (url u, string s) {
+  database db= get_database (u);
+  return db->compute_name_completions (s, true);
+}
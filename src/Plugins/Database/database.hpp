@@ -24,27 +24,30 @@ typedef double db_time;
 typedef array<db_atom> db_atoms;
 #define DB_MAX_TIME ((db_time) 10675199166.0)
 
-class db_line_rep: public concrete_struct {
-public:
-  db_atom id;
-  db_atom attr;
-  db_atom val;
-  db_time created;
-  db_time expires;
+/******************************************************************************
+* Prefix trees for the completion of keywords and names
+******************************************************************************/
 
-  db_line_rep (db_atom id, db_atom attr, db_atom val,
-               db_time created, db_time expires);
+class db_trie {
+  array<int>  first;    // first child of each node
+  array<int>  next;     // next sibling of each node
+  array<char> label;    // last character of the prefix of each node
+  array<int>  item;     // item whose string ends at the node, or -1
+  array<int>  weight;   // weight of this item
+  array<int>  best;     // largest weight of an item in the subtree
 
-  friend class database;
-};
+  int  child (int node, char c, bool create);
+  int  find (string s);
+  void collect (int node, array<int>& r);
+  void fuzzy_nodes (int node, string s, int i, bool edited, array<int>& r);
+  array<int> ranked (array<int> roots, int limit);
 
-class db_line {
-  CONCRETE(db_line);
-  db_line ();
-  db_line (db_atom id, db_atom attr, db_atom val,
-           db_time created, db_time expires);
+public:
+  db_trie ();
+  void insert (string s, int it, int w);
+  array<int> complete (string s);
+  array<int> complete (string s, int limit, bool fuzzy);
 };
-CONCRETE_CODE(db_line);
 
 /******************************************************************************
 * Databases
@@ -59,10 +62,15 @@ typedef int db_key;
 typedef array<db_key> db_keys;
 
 class database;
+class mapped_file;
 class database_rep: public concrete_struct {
 private:
   url db_name;
-  array<db_line> db;
+  array<db_atom> db_id;         // the lines of the database are stored
+  array<db_atom> db_attr;       // column by column, so that the scans
+  array<db_atom> db_val;        // during queries only access the fields
+  array<db_time> db_created;    // which they need
+  array<db_time> db_expires;
   int outdated;
   bool with_history;
 
@@ -74,18 +82,19 @@ private:
   hashset<db_atom> ids_set;
 
   bool error_flag;
-  string loaded;
+  int loaded;                   // the length of the journal on disk
+  int loaded_code;              // and its hash code
   string pending;
   int start_pending;
   int time_stamp;
+  int checkpointed;
   
   hashmap<string,db_atom> key_encode;
   array<string> key_decode;
   array<bool> atom_indexed;
-  array<bool> name_indexed;
   array<db_atoms> key_occurrences;
-  hashmap<string,db_keys> key_completions;
-  hashmap<string,db_atoms> name_completions;
+  db_trie key_trie;
+  db_trie name_trie;
 
 public:
   bool atom_exists (string s);
@@ -100,11 +109,16 @@ public:
 private:
   db_atom create_atom (string s);
   db_line_nr extend_field (db_atom id, db_atom attr, db_atom vals, db_time t);
+  inline int nr_lines () { return N(db_id); }
+  inline bool is_active (db_line_nr nr, db_time t) {
+    return t == 0 || (db_created[nr] <= t && t < db_expires[nr]); }
   bool line_satisfies (db_line_nr nr, db_constraint c, db_time t);
   bool id_satisfies (db_atom id, db_constraint c, db_time t);
   bool id_satisfies (db_atom id, db_constraints cs, db_time t);
   db_constraint encode_constraint (tree q);
   db_constraints encode_constraints (tree q);
+  int constraint_cost (db_constraint c);
+  db_atoms constraint_ids (db_constraint c, db_time t);
   db_atoms filter (db_atoms ids, tree qt, db_time t, int limit);
   int compute_complexity (tree q);
   int ansatz_index (tree q);
@@ -115,8 +129,11 @@ private:
   void notify_created_atom (string s);
   void notify_extended_field (db_line_nr nr);
   void notify_removed_field (db_line_nr nr);
-  void replay (string s);
+  void replay (const char* s, int n, int pos= 0);
   void replay (database clone, int start, bool all);
+  url checkpoint_name ();
+  void save_checkpoint ();
+  int load_checkpoint (mapped_file journal);
   database compress ();
   void initialize ();
   void purge ();
@@ -124,12 +141,11 @@ private:
 private:
   db_key as_key (string s);
   string from_key (db_key a);
-  void add_completed_as (db_key k);
   void indexate (db_atom val);
   void indexate_name (db_atom val);
   db_constraint encode_keywords_constraint (tree q);
-  strings compute_completions (string s);
-  strings compute_name_completions (string s);
+  strings compute_completions (string s, bool fuzzy= false);
+  strings compute_name_completions (string s, bool fuzzy= false);
   tree normalize_query (tree q);
 
 private:
@@ -154,6 +170,8 @@ public:
   friend void check_for_updates ();
   friend strings get_completions (url u, string s);
   friend strings get_name_completions (url u, string s);
+  friend strings get_fuzzy_completions (url u, string s);
+  friend strings get_fuzzy_name_completions (url u, string s);
 };
 
 class database {
@@ -175,6 +193,8 @@ strings query (url u, tree q, db_time t, int limit);
 void inspect_history (url u, string name);
 strings get_completions (url u, string s);
 strings get_name_completions (url u, string s);
+strings get_fuzzy_completions (url u, string s);
+strings get_fuzzy_name_completions (url u, string s);
 
 void sync_databases ();
 void check_for_updates ();
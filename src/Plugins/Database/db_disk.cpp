@@ -11,11 +11,16 @@
 
 #include "Database/database.hpp"
 #include "file.hpp"
+#include <string.h>
 
 #define DB_CREATE_ATOM   1
 #define DB_CREATE_FIELD  2
 #define DB_REMOVE_FIELD  3
 
+#define DB_CHECKPOINT_MAGIC "%-%-tm-db-checkpoint-1-%-%\n"
+#define DB_CHECKPOINT_ORDER 0x01020304
+#define DB_CHECKPOINT_SIZE  262144
+
 #ifdef OS_MINGW
 #define random rand
 #endif
@@ -44,7 +49,7 @@ marshall_number (string& s, unsigned long int i) {
 }
 
 static unsigned long int
-unmarshall_number (string s, int& pos) {
+unmarshall_number (const char* s, int& pos) {
   int n= (int) ((unsigned char) s[pos++]);
   if (n >= 8) return n - 8;
   unsigned long int r= 0;
@@ -64,13 +69,24 @@ marshall_string (string& s, string x) {
 }
 
 static string
-unmarshall_string (string s, int& pos) {
+unmarshall_string (const char* s, int& pos) {
   int n= unmarshall_number (s, pos);
-  string r= s (pos, pos+n);
+  string r (s + pos, n);
   pos += n;
   return r;
 }
 
+static int
+journal_code (const char* s, int n, int h= 0) {
+  // the hash code of a part of the journal, continuing the code h
+  // of the preceding part, as computed by hash (string)
+  for (int i=0; i<n; i++) {
+    h= (h<<9) + (h>>23);
+    h= h + ((int) s[i]);
+  }
+  return h;
+}
+
 /******************************************************************************
 * Writing to disk cache
 ******************************************************************************/
@@ -84,12 +100,11 @@ database_rep::notify_created_atom (string s) {
 
 void
 database_rep::notify_extended_field (db_line_nr nr) {
-  db_line& l= db[nr];
   pending << (char) ((unsigned char) DB_CREATE_FIELD);
-  marshall_number (pending, l->id);
-  marshall_number (pending, l->attr);
-  marshall_number (pending, l->val);
-  marshall_number (pending, (unsigned long int) l->created);
+  marshall_number (pending, db_id[nr]);
+  marshall_number (pending, db_attr[nr]);
+  marshall_number (pending, db_val[nr]);
+  marshall_number (pending, (unsigned long int) db_created[nr]);
   //cout << "Notify extended " << as_atom (l->id)
   //<< ", " << as_atom (l->attr)
   //<< ", " << as_atom (l->val) << LF;
@@ -97,10 +112,9 @@ database_rep::notify_extended_field (db_line_nr nr) {
 
 void
 database_rep::notify_removed_field (db_line_nr nr) {
-  db_line& l= db[nr];
   pending << (char) ((unsigned char) DB_REMOVE_FIELD);
   marshall_number (pending, nr);
-  marshall_number (pending, (unsigned long int) l->expires);
+  marshall_number (pending, (unsigned long int) db_expires[nr]);
   //cout << "Notify removed " << as_atom (l->id)
   //<< ", " << as_atom (l->attr) << LF;
 }
@@ -110,9 +124,8 @@ database_rep::notify_removed_field (db_line_nr nr) {
 ******************************************************************************/
 
 void
-database_rep::replay (string s) {
-  int pos= 0;
-  while (pos < N(s)) {
+database_rep::replay (const char* s, int n, int pos) {
+  while (pos < n) {
     unsigned int cmd= (unsigned int) ((unsigned char) s[pos++]);
     switch (cmd) {
     case DB_CREATE_ATOM:
@@ -134,8 +147,8 @@ database_rep::replay (string s) {
       {
         db_line_nr nr= (db_line_nr) unmarshall_number (s, pos);
         db_time    t = (db_time)    unmarshall_number (s, pos);
-        if (db[nr]->expires == DB_MAX_TIME) outdated++;
-        db[nr]->expires= t;
+        if (db_expires[nr] == DB_MAX_TIME) outdated++;
+        db_expires[nr]= t;
         break;
       }
     default:
@@ -145,24 +158,193 @@ database_rep::replay (string s) {
   }
 }
 
+/******************************************************************************
+* Checkpoints.
+* A checkpoint contains the state of the database after replaying the
+* start of the journal, as well as the length and the hash code of this
+* start. The atoms and keys are stored as strings, the columns of the
+* lines and the occurrences of the keys as raw arrays of the machine.
+* The other indexes are rebuilt from these data without recomputing the
+* keywords, and only the remainder of the journal needs to be replayed.
+******************************************************************************/
+
+static void
+write_raw (string& s, const void* p, int n) {
+  if (n > 0) s << string ((const char*) p, n);
+}
+
+static void
+write_int (string& s, int i) {
+  write_raw (s, &i, sizeof (int));
+}
+
+static void
+write_string (string& s, string x) {
+  write_int (s, N(x));
+  s << x;
+}
+
+static bool
+read_raw (mapped_file mf, int& pos, void* p, int n) {
+  if (n < 0 || n > mf->size - pos) return false;
+  if (n > 0) memcpy (p, mf->data + pos, n);
+  pos += n;
+  return true;
+}
+
+static bool
+read_string (mapped_file mf, int& pos, string& x) {
+  int n;
+  if (!read_raw (mf, pos, &n, sizeof (int))) return false;
+  if (n < 0 || n > mf->size - pos) return false;
+  x= string (mf->data + pos, n);
+  pos += n;
+  return true;
+}
+
+template<class T> static bool
+read_array (mapped_file mf, int& pos, array<T>& a, int n) {
+  if (n < 0 || n > (mf->size - pos) / ((int) sizeof (T))) return false;
+  a= array<T> (n);
+  return read_raw (mf, pos, A(a), n * sizeof (T));
+}
+
+static bool
+valid_atoms (db_atoms a, int nr_atoms) {
+  for (int i=0; i<N(a); i++)
+    if (a[i] < 0 || a[i] >= nr_atoms) return false;
+  return true;
+}
+
+url
+database_rep::checkpoint_name () {
+  return glue (db_name, ".checkpoint");
+}
+
+void
+database_rep::save_checkpoint () {
+  int n= nr_lines ();
+  string s= DB_CHECKPOINT_MAGIC;
+  write_int (s, DB_CHECKPOINT_ORDER);
+  write_int (s, loaded);
+  write_int (s, loaded_code);
+  write_int (s, N(atom_decode));
+  write_int (s, n);
+  write_int (s, N(key_decode));
+  write_int (s, outdated);
+  for (int i=0; i<N(atom_decode); i++)
+    write_string (s, atom_decode[i]);
+  write_raw (s, A(db_id), n * sizeof (db_atom));
+  write_raw (s, A(db_attr), n * sizeof (db_atom));
+  write_raw (s, A(db_val), n * sizeof (db_atom));
+  write_raw (s, A(db_created), n * sizeof (db_time));
+  write_raw (s, A(db_expires), n * sizeof (db_time));
+  for (int k=0; k<N(key_decode); k++) {
+    write_string (s, key_decode[k]);
+    write_int (s, N(key_occurrences[k]));
+    write_raw (s, A(key_occurrences[k]),
+               N(key_occurrences[k]) * sizeof (db_atom));
+  }
+  file_writer fw (checkpoint_name ());
+  fw->write (s.data (), N(s));
+  if (!fw->commit ()) checkpointed= loaded;
+}
+
+int
+database_rep::load_checkpoint (mapped_file journal) {
+  // returns the part of the journal which has been restored,
+  // whose hash code is stored in loaded_code
+  url u= checkpoint_name ();
+  if (!exists (u)) return 0;
+  mapped_file mf (u);
+  int pos= strlen (DB_CHECKPOINT_MAGIC);
+  if (mf->error || mf->size < pos ||
+      memcmp (mf->data, DB_CHECKPOINT_MAGIC, pos) != 0) return 0;
+  int h[7];
+  if (!read_raw (mf, pos, h, sizeof (h))) return 0;
+  int order= h[0], len= h[1], code= h[2];
+  int nr_atoms= h[3], n= h[4], nr_keys= h[5];
+  if (order != DB_CHECKPOINT_ORDER || len < 0 || len > journal->size ||
+      nr_atoms < 0 || nr_keys < 0 || journal_code (journal->data, len) != code)
+    return 0;
+
+  // read and check the whole checkpoint before modifying the database
+  strings atoms, keys;
+  for (int i=0; i<nr_atoms; i++) {
+    string x;
+    if (!read_string (mf, pos, x)) return 0;
+    atoms << x;
+  }
+  db_atoms ids, attrs, vals;
+  array<db_time> created, expires;
+  if (!read_array (mf, pos, ids, n) ||
+      !read_array (mf, pos, attrs, n) ||
+      !read_array (mf, pos, vals, n) ||
+      !read_array (mf, pos, created, n) ||
+      !read_array (mf, pos, expires, n) ||
+      !valid_atoms (ids, nr_atoms) ||
+      !valid_atoms (attrs, nr_atoms) ||
+      !valid_atoms (vals, nr_atoms)) return 0;
+  array<db_atoms> occs;
+  for (int k=0; k<nr_keys; k++) {
+    string x;
+    int nr;
+    db_atoms occ;
+    if (!read_string (mf, pos, x) ||
+        !read_raw (mf, pos, &nr, sizeof (int)) ||
+        !read_array (mf, pos, occ, nr) ||
+        !valid_atoms (occ, nr_atoms)) return 0;
+    keys << x;
+    occs << occ;
+  }
+  if (pos != mf->size) return 0;
+
+  // rebuild the database in the same way as during a replay
+  for (int i=0; i<nr_atoms; i++)
+    (void) create_atom (atoms[i]);
+  db_id= ids; db_attr= attrs; db_val= vals;
+  db_created= created; db_expires= expires;
+  db_atom contributor= atom_encode ["contributor"];
+  db_atom name= atom_encode ["name"];
+  for (int nr=0; nr<n; nr++) {
+    db_atom id= db_id[nr], attr= db_attr[nr], val= db_val[nr];
+    id_lines[id] << nr;
+    val_lines[val] << nr;
+    if (!ids_set->contains (id)) {
+      ids_set->insert (id);
+      ids_list << id;
+    }
+    if (attr != contributor) atom_indexed[val]= true;
+    if (attr == name) indexate_name (val);
+  }
+  for (int k=0; k<nr_keys; k++) {
+    (void) as_key (keys[k]);
+    key_occurrences[k]= occs[k];
+    key_trie.insert (keys[k], k, N(occs[k]));
+  }
+  outdated= h[6];
+  checkpointed= len;
+  loaded_code= code;
+  return len;
+}
+
 /******************************************************************************
 * Creating a new database with the active entries only
 ******************************************************************************/
 
 void
 database_rep::replay (database clone, int start, bool all) {
-  for (int nr=start; nr<N(db); nr++) {
-    db_line& l= db[nr];
-    if (all || l->expires == DB_MAX_TIME) {
-      db_atom id  = clone->as_atom (from_atom (l->id  ));
-      db_atom attr= clone->as_atom (from_atom (l->attr));
-      db_atom val = clone->as_atom (from_atom (l->val ));
-      db_time t   = l->created;
+  for (int nr=start; nr<nr_lines (); nr++) {
+    if (all || db_expires[nr] == DB_MAX_TIME) {
+      db_atom id  = clone->as_atom (from_atom (db_id  [nr]));
+      db_atom attr= clone->as_atom (from_atom (db_attr[nr]));
+      db_atom val = clone->as_atom (from_atom (db_val [nr]));
+      db_time t   = db_created[nr];
       db_line_nr cnr= clone->extend_field (id, attr, val, t);
       clone->notify_extended_field (cnr);
       //cout << "  Add " << from_atom (l->id) << ", " << from_atom (l->attr) << ", " << from_atom (l->val) << LF;
-      if (l->expires != DB_MAX_TIME) {
-        clone->db[cnr]->expires= t;
+      if (db_expires[nr] != DB_MAX_TIME) {
+        clone->db_expires[cnr]= t;
         clone->notify_removed_field (cnr);
         clone->outdated++;
         //cout << "  Removed " << from_atom (l->id) << ", " << from_atom (l->attr) << ", " << from_atom (l->val) << LF;
@@ -173,7 +355,7 @@ database_rep::replay (database clone, int start, bool all) {
 
 database
 database_rep::compress () {
-  //cout << "Compressing " << outdated << " items out of " << N(db) << LF;
+  //cout << "Compressing " << outdated << " items out of " << nr_lines () << LF;
   database clone (db_name, true);
   replay (clone, 0, false);
   return clone;
@@ -187,15 +369,21 @@ void
 database_rep::initialize () {
   error_flag= false;
   if (exists (db_name)) {
-    if (load_string (db_name, loaded, false)) {
+    mapped_file journal (db_name);
+    if (journal->error) {
       std_error << "Could not load database file "
                 << as_string (db_name) << LF;
       error_flag= true;
     }
     else {
-      replay (loaded);
-      start_pending= N(db);
+      int start= load_checkpoint (journal);
+      loaded= journal->size;
+      loaded_code= journal_code (journal->data + start, loaded - start,
+                                 loaded_code);
+      replay (journal->data, loaded, start);
+      start_pending= nr_lines ();
       time_stamp= last_modified (db_name);
+      if (loaded - checkpointed >= DB_CHECKPOINT_SIZE) save_checkpoint ();
     }
   }
   else {
@@ -226,9 +414,10 @@ database_rep::purge () {
       remove (db_append);
       //cout << "Appended latest changes in " << db_append
       //<< " to " << db_name << LF;
-      loaded << pending;
+      loaded_code= journal_code (pending.data (), N(pending), loaded_code);
+      loaded += N(pending);
       pending= "";
-      start_pending= N(db);
+      start_pending= nr_lines ();
       time_stamp= last_modified (db_name);
       return;
     }
@@ -239,7 +428,20 @@ database_rep::purge () {
     // and use an atomic move in order to replace the old file
     int rnd= (int) (((unsigned int) rand ()) & 0xffffff);
     url replace= glue (db_name, ".replace-" * as_string (rnd));
-    if (!save_string (replace, loaded * pending, false)) {
+    bool err= true, modified= false;
+    {
+      // the journal is only mapped while it is copied
+      mapped_file journal (db_name);
+      modified= !journal->error && journal->size != loaded;
+      if (!journal->error && !modified) {
+        file_writer fw (replace);
+        fw->write (journal->data, loaded);
+        fw->write (pending.data (), N(pending));
+        err= fw->commit ();
+      }
+    }
+    if (modified) return;
+    if (!err) {
       if (last_modified (db_name) > time_stamp) {
         // FIXME: this test should really be part of the atomic operation
         remove (replace);
@@ -248,9 +450,10 @@ database_rep::purge () {
       move (replace, db_name);  // NOTE: critical atomic operation
       //cout << "Replaced " << db_name
       //<< " by latest changes in " << replace << LF;
-      loaded << pending;
+      loaded_code= journal_code (pending.data (), N(pending), loaded_code);
+      loaded += N(pending);
       pending= "";
-      start_pending= N(db);
+      start_pending= nr_lines ();
       time_stamp= last_modified (db_name);
       return;
     }
@@ -275,7 +478,7 @@ sync_databases () {
     }
   require_check= true;
   for (int i=0; i<N(dbs); i++)
-    if (dbs[i]->with_history || (2 * dbs[i]->outdated) <= N(dbs[i]->db))
+    if (dbs[i]->with_history || (2 * dbs[i]->outdated) <= dbs[i]->nr_lines ())
       dbs[i]->purge ();
     else {
       database db= dbs[i]->compress ();
@@ -288,12 +491,16 @@ sync_databases () {
       if (db->error_flag)
         dbs[i]->with_history= true;
       else {
-        db->start_pending= N(db->db);
+        db->start_pending= db->nr_lines ();
         db->time_stamp= last_modified (replace);
         move (replace, current);  // NOTE: critical atomic operation
         dbs[i]= db;
       }
     }
+  for (int i=0; i<N(dbs); i++)
+    if (!dbs[i]->error_flag && dbs[i]->pending == "" &&
+        dbs[i]->loaded - dbs[i]->checkpointed >= DB_CHECKPOINT_SIZE)
+      dbs[i]->save_checkpoint ();
 }
 
 void
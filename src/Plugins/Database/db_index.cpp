@@ -14,8 +14,10 @@
 #include "convert.hpp"
 #include "universal.hpp"
 #include "analyze.hpp"
+#include "merge_sort.hpp"
+#include <queue>
 
-#define MAX_PREFIX_LENGTH 6
+#define DB_MAX_COMPLETIONS 100
 
 /******************************************************************************
 * Computing list of keywords in a string
@@ -58,6 +60,124 @@ compute_keywords (string s) {
   return r;
 }
 
+/******************************************************************************
+* Prefix trees
+******************************************************************************/
+
+db_trie::db_trie () {
+  first << -1; next << -1; label << '\0';
+  item << -1; weight << 0; best << 0;
+}
+
+int
+db_trie::child (int node, char c, bool create) {
+  // the children of a node are sorted by their labels
+  unsigned char uc= (unsigned char) c;
+  int prev= -1, cur= first[node];
+  while (cur >= 0 && ((unsigned char) label[cur]) < uc) {
+    prev= cur;
+    cur= next[cur];
+  }
+  if (cur >= 0 && label[cur] == c) return cur;
+  if (!create) return -1;
+  int r= N(first);
+  first << -1; next << cur; label << c;
+  item << -1; weight << 0; best << 0;
+  if (prev < 0) first[node]= r;
+  else next[prev]= r;
+  return r;
+}
+
+int
+db_trie::find (string s) {
+  int node= 0;
+  for (int i=0; i<N(s) && node >= 0; i++)
+    node= child (node, s[i], false);
+  return node;
+}
+
+void
+db_trie::insert (string s, int it, int w) {
+  // insert s with item it, or increase its weight by w
+  array<int> path;
+  int node= 0;
+  path << node;
+  for (int i=0; i<N(s); i++) {
+    node= child (node, s[i], true);
+    path << node;
+  }
+  item[node]= it;
+  weight[node] += w;
+  for (int i=0; i<N(path); i++)
+    best[path[i]]= std::max (best[path[i]], weight[node]);
+}
+
+void
+db_trie::collect (int node, array<int>& r) {
+  if (item[node] >= 0) r << item[node];
+  for (int c= first[node]; c >= 0; c= next[c])
+    collect (c, r);
+}
+
+array<int>
+db_trie::complete (string s) {
+  // all items whose strings start with s
+  array<int> r;
+  int node= find (s);
+  if (N(s) > 0 && node >= 0) collect (node, r);
+  return r;
+}
+
+void
+db_trie::fuzzy_nodes (int node, string s, int i, bool edited, array<int>& r) {
+  // nodes whose prefixes are at edit distance at most one from s
+  if (i == N(s)) {
+    r << node;
+    return;
+  }
+  if (!edited) fuzzy_nodes (node, s, i+1, true, r);
+  for (int c= first[node]; c >= 0; c= next[c]) {
+    if (label[c] == s[i]) fuzzy_nodes (c, s, i+1, edited, r);
+    else if (!edited) fuzzy_nodes (c, s, i+1, true, r);
+    if (!edited) fuzzy_nodes (c, s, i, true, r);
+  }
+}
+
+array<int>
+db_trie::ranked (array<int> roots, int limit) {
+  // the items of largest weight in the subtrees of the roots,
+  // where items which were inserted first are preferred on ties
+  std::priority_queue<std::pair<int,int> > todo;
+  hashset<int> done;
+  for (int i=0; i<N(roots); i++)
+    todo.push (std::pair<int,int> (best[roots[i]], -2 * roots[i]));
+  array<int> r;
+  while (!todo.empty () && N(r) < limit) {
+    int code= -todo.top ().second;
+    todo.pop ();
+    int node= code >> 1;
+    if ((code & 1) != 0) r << item[node];
+    else if (!done->contains (node)) {
+      done->insert (node);
+      if (item[node] >= 0)
+        todo.push (std::pair<int,int> (weight[node], -2 * node - 1));
+      for (int c= first[node]; c >= 0; c= next[c])
+        todo.push (std::pair<int,int> (best[c], -2 * c));
+    }
+  }
+  return r;
+}
+
+array<int>
+db_trie::complete (string s, int limit, bool fuzzy) {
+  array<int> roots;
+  if (N(s) == 0) return roots;
+  // a single character is at distance one from any string
+  if (fuzzy && N(s) > 1) fuzzy_nodes (0, s, 0, false, roots);
+  else if (find (s) >= 0) roots << find (s);
+  return ranked (roots, limit);
+}
+
 /******************************************************************************
 * Key management
 ******************************************************************************/
@@ -83,48 +203,24 @@ database_rep::from_key (db_key a) {
 * Indexation
 ******************************************************************************/
 
-void
-database_rep::add_completed_as (db_key k) {
-  string kw= from_key (k);
-  int pos= 0, n= N(kw);
-  for (int i=0; i<MAX_PREFIX_LENGTH && pos<n; i++) {
-    tm_char_forwards (kw, pos);
-    string ss= kw (0, pos);
-    if (!key_completions->contains (ss))
-      key_completions (ss)= db_keys ();
-    key_completions (ss) << k;
-    //cout << "Completions " << ss << " -> " << key_completions[ss] << LF;
-  }
-}
-
 void
 database_rep::indexate (db_atom val) {
   if (atom_indexed[val]) return;
   array<string> kws= compute_keywords (from_atom (val));
   //cout << "Indexate " << from_atom (val) << " -> " << kws << LF;
   for (int i=0; i<N(kws); i++) {
-    bool new_key= !key_encode->contains (kws[i]);
     db_key k= as_key (kws[i]);
     key_occurrences[k] << val;
-    if (new_key) add_completed_as (k);
+    // keywords are ranked by the number of values in which they occur
+    key_trie.insert (kws[i], k, 1);
   }
   atom_indexed[val]= true;
 }
 
 void
 database_rep::indexate_name (db_atom val) {
-  if (name_indexed[val]) return;
-  string s= atom_decode[val];
-  int pos= 0, n= N(s);
-  for (int i=0; i<MAX_PREFIX_LENGTH && pos<n; i++) {
-    tm_char_forwards (s, pos);
-    string ss= s (0, pos);
-    if (!name_completions->contains (ss))
-      name_completions (ss)= db_keys ();
-    name_completions (ss) << val;
-    //cout << "Name completions " << ss << " -> " << name_completions[ss] << LF;
-  }
-  name_indexed[val]= true;
+  // names are ranked by the number of fields in which they occur
+  name_trie.insert (atom_decode[val], val, 1);
 }
 
 /******************************************************************************
@@ -163,28 +259,20 @@ database_rep::encode_keywords_constraint (tree q) {
 }
 
 strings
-database_rep::compute_completions (string s) {
-  int pos=0, n=N(s);
-  for (int i=0; i<MAX_PREFIX_LENGTH && pos<n; i++)
-    tm_char_forwards (s, pos);
-  db_keys ks= key_completions (s (0, pos));
+database_rep::compute_completions (string s, bool fuzzy) {
+  db_keys ks= key_trie.complete (s, DB_MAX_COMPLETIONS, fuzzy);
   strings r;
   for (int i=0; i<N(ks); i++)
-    if (pos == n || starts (from_key (ks[i]), s))
-      r << from_key (ks[i]);
+    r << from_key (ks[i]);
   return r;
 }
 
 strings
-database_rep::compute_name_completions (string s) {
-  int pos=0, n=N(s);
-  for (int i=0; i<MAX_PREFIX_LENGTH && pos<n; i++)
-    tm_char_forwards (s, pos);
-  db_atoms vals= name_completions (s (0, pos));
+database_rep::compute_name_completions (string s, bool fuzzy) {
+  db_atoms vals= name_trie.complete (s, DB_MAX_COMPLETIONS, fuzzy);
   strings r;
   for (int i=0; i<N(vals); i++)
-    if (pos == n || starts (from_atom (vals[i]), s))
-      r << from_atom (vals[i]);
+    r << from_atom (vals[i]);
   return r;
 }
 
@@ -206,9 +294,10 @@ database_rep::normalize_query (tree q) {
           r << tree (TUPLE, "keywords", scm_quote (kws[j]));
         if (flag) {
           tree t (TUPLE, "keywords");
-          strings cs= compute_completions (kws[n]);
-          for (int k=0; k<N(cs); k++)
-            t << scm_quote (cs[k]);
+          db_keys ks= key_trie.complete (kws[n]);
+          merge_sort (ks);
+          for (int k=0; k<N(ks); k++)
+            t << scm_quote (from_key (ks[k]));
           r << t;
         }
       }
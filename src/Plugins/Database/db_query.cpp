@@ -11,6 +11,11 @@
 
 #include "Database/database.hpp"
 #include "analyze.hpp"
+#include <algorithm>
+
+// intersect with the ids of a constraint as long as these are not
+// much more numerous than the remaining candidates
+#define DB_INTERSECT_RATIO 8
 
 /******************************************************************************
 * Fast filtering of lines which satisfy a list of constraints
@@ -18,14 +23,13 @@
 
 bool
 database_rep::line_satisfies (db_line_nr nr, db_constraint c, db_time t) {
-  db_line& l= db[nr];
-  //cout << "    Testing " << l->id << ", " << l->attr << ", " << l->val << LF;
-  //cout << "    Testing " << from_atom (l->id) << ", " << from_atom (l->attr) << ", " << from_atom (l->val) << LF;
-  if ((t != 0) && (t < l->created || t >= l->expires)) return false;
+  //cout << "    Testing " << db_id[nr] << ", " << db_attr[nr] << ", " << db_val[nr] << LF;
+  if (!is_active (nr, t)) return false;
   db_atom attr= c[0];
-  if (l->attr != attr && attr != -1) return false;
+  if (db_attr[nr] != attr && attr != -1) return false;
+  db_atom val= db_val[nr];
   for (int j=1; j<N(c); j++)
-    if (l->val == c[j]) return true;
+    if (val == c[j]) return true;
   return false;
 }
 
@@ -88,15 +92,70 @@ database_rep::encode_constraints (tree ql) {
   return r;
 }
 
+/******************************************************************************
+* Intersecting the candidates with the ids which satisfy a constraint
+******************************************************************************/
+
+int
+database_rep::constraint_cost (db_constraint c) {
+  int r= 0;
+  for (int i=1; i<N(c); i++)
+    r += N (val_lines[c[i]]);
+  return r;
+}
+
+db_atoms
+database_rep::constraint_ids (db_constraint c, db_time t) {
+  // sorted list of the ids with a line which satisfies c at time t
+  db_atoms r;
+  db_atom attr= c[0];
+  for (int i=1; i<N(c); i++) {
+    db_line_nrs nrs= val_lines[c[i]];
+    for (int j=0; j<N(nrs); j++) {
+      db_line_nr nr= nrs[j];
+      if ((db_attr[nr] == attr || attr == -1) && is_active (nr, t))
+        r << db_id[nr];
+    }
+  }
+  std::sort (A(r), A(r) + N(r));
+  int n= (int) (std::unique (A(r), A(r) + N(r)) - A(r));
+  return range (r, 0, n);
+}
+
 db_atoms
 database_rep::filter (db_atoms ids, tree qt, db_time t, int limit) {
   //cout << "Query " << qt << "\n";
   db_constraints cs= encode_constraints (qt);
   //cout << "Encoded as " << cs << "\n";
-  if (N(cs) == 1 && N(cs) == 0) return db_atoms ();
+  if (N(cs) == 1 && N(cs[0]) == 0) return db_atoms ();
+  // handle the most selective constraints first
+  array<int> cost, order;
+  for (int i=0; i<N(cs); i++) {
+    cost << constraint_cost (cs[i]);
+    int j= N(order);
+    order << i;
+    for (; j>0 && cost[order[j-1]] > cost[i]; j--)
+      order[j]= order[j-1];
+    order[j]= i;
+  }
+  // intersect the candidates with the posting lists of the constraints
+  // which are selective enough; the candidates keep their order
+  int k= 0;
+  for (; k<N(order) && N(ids) > 0; k++) {
+    if (cost[order[k]] > DB_INTERSECT_RATIO * N(ids)) break;
+    db_atoms sel= constraint_ids (cs[order[k]], t);
+    db_atoms r;
+    for (int i=0; i<N(ids); i++)
+      if (std::binary_search (A(sel), A(sel) + N(sel), ids[i]))
+        r << ids[i];
+    ids= r;
+  }
+  // check the remaining constraints line by line
+  db_constraints rest;
+  for (; k<N(order); k++) rest << cs[order[k]];
   db_atoms r;
   for (int i=0; i<N(ids); i++)
-    if (id_satisfies (ids[i], cs, t)) {
+    if (id_satisfies (ids[i], rest, t)) {
       r << ids[i];
       if (N(r) >= limit) break;
     }
@@ -113,11 +172,7 @@ database_rep::compute_complexity (tree q) {
   db_constraint c= encode_constraint (q);
   if (N(c) == 1 && c[0] == -2) return 1000000000;
   if (N(c) <= 1) return 0;
-  int r=0;
-  for (int i=1; i<N(c); i++) {
-    db_atom val= c[i];
-    r += N (val_lines[val]);
-  }
+  int r= constraint_cost (c);
   //cout << "Return " << r << LF;
   return r;
 }
@@ -154,12 +209,12 @@ database_rep::ansatz (tree ql, db_time t) {
     db_line_nrs nrs= val_lines[val];
     //cout << "trying " << val << ", " << nrs << LF;
     for (int j=0; j<N(nrs); j++) {
-      db_line& l= db[nrs[j]];
-      //cout << "  line " << l->id << ", " << l->attr << ", " << l->val << LF;
-      if ((t == 0) || (l->created <= t && t < l->expires))
-        if (!idss->contains (l->id)) {
-          idss->insert (l->id);
-          idsl << l->id;
+      db_line_nr nr= nrs[j];
+      //cout << "  line " << db_id[nr] << ", " << db_attr[nr] << ", " << db_val[nr] << LF;
+      if (is_active (nr, t))
+        if (!idss->contains (db_id[nr])) {
+          idss->insert (db_id[nr]);
+          idsl << db_id[nr];
         }
     }
   }
@@ -178,10 +233,10 @@ database_rep::filter_modified (db_atoms ids, db_time t1, db_time t2) {
     db_line_nrs nrs= id_lines[id];
     bool modified= false;
     for (int j=0; j<N(nrs); j++) {
-      db_line& l= db[nrs[j]];
-      if (t1 > l->created || l->expires > t2) {
-        if (l->created >= t1 && l->created < t2) modified= true;
-        if (l->expires >= t1 && l->expires < t2) modified= true;
+      db_time created= db_created[nrs[j]], expires= db_expires[nrs[j]];
+      if (t1 > created || expires > t2) {
+        if (created >= t1 && created < t2) modified= true;
+        if (expires >= t1 && expires < t2) modified= true;
       }
     }
     if (modified) r << id;
@@ -47,10 +47,9 @@ database_rep::build_sort_tuples (db_atoms ids, db_atoms attrs, db_time t) {
     for (int a=0; a<N(attrs); a++) {
       string found;
       for (int j=0; j<N(nrs); j++) {
-        db_line& l= db[nrs[j]];
-        if ((t == 0) || (l->created <= t && t < l->expires))
-          if (l->attr == attrs[a])
-            found= from_atom (l->val);
+        db_line_nr nr= nrs[j];
+        if (is_active (nr, t) && db_attr[nr] == attrs[a])
+          found= from_atom (db_val[nr]);
       }
       e << found;
     }
@@ -53,6 +53,20 @@
 #include "PDFWriter/PDFTiledPattern.h"
 #include "PDFWriter/TiledPatternContentContext.h"
 #include "PDFWriter/PDFUsedFont.h"
+#include "PDFWriter/PDFParser.h"
+#include "PDFWriter/PDFArray.h"
+#include "PDFWriter/PDFObjectCast.h"
+#include "PDFWriter/PDFIndirectObjectReference.h"
+#include "PDFWriter/PDFDictionary.h"
+#include "PDFWriter/PDFStreamInput.h"
+#include "PDFWriter/PDFName.h"
+#include "PDFWriter/PDFInteger.h"
+#include "PDFWriter/PDFReal.h"
+#include "PDFWriter/PDFBoolean.h"
+#include "PDFWriter/PDFLiteralString.h"
+#include "PDFWriter/PDFHexString.h"
+#include "PDFWriter/PDFSymbol.h"
+#include "PDFWriter/MD5Generator.h"
  
 /******************************************************************************
  * pdf_hummus_renderer
@@ -64,6 +78,13 @@ typedef triple<int,int,int> rgb;
 typedef quartet<string,int,SI,SI> dest_data;
 typedef quintuple<string,int,SI,SI,int> outline_data;
 
+// Documents can be exported as several parts, each containing a range of
+// pages, which are merged afterwards.  The destinations and outline entries
+// of a part are saved next to it, since they may refer to other parts.
+#define PDF_COMPLETE 0 // a complete document
+#define PDF_PART     1 // a range of pages of a document
+#define PDF_MERGE    2 // pages copied from the parts of a document
+
 class pdf_image;
 class pdf_raw_image;
 class t3font;
@@ -73,6 +94,7 @@ class pdf_hummus_renderer_rep : public renderer_rep {
   
   static const int default_dpi= 72; // PDF initial coordinate system corresponds to 72 dpi
   bool		started;  // initialisation is OK
+  int       mode;     // complete document, part or merger of parts
   url       pdf_file_name;
   int       dpi;
   int       nr_pages;
@@ -124,6 +146,9 @@ class pdf_hummus_renderer_rep : public renderer_rep {
   int label_count;
   hashmap<string,string> metadata;
 
+  // resources copied from parts, indexed by a digest of their contents
+  hashmap<string,ObjectIDType> merged_resources;
+
   // outline support
   ObjectIDType outlineId;
   list<outline_data> outlines;
@@ -167,6 +192,12 @@ class pdf_hummus_renderer_rep : public renderer_rep {
   void end_page();
   
   int get_label_id(string label);
+  string dest_name (string label);
+  void save_part_info ();
+  bool load_part_info (url info, int offset);
+  void share_resources (PDFParser* parser, PDFDictionary* page_dict,
+                        ObjectIDTypeToObjectIDTypeMap& shared,
+                        hashmap<ObjectIDType,string>& fresh);
 
   // various internal routines
   void flush_images();
@@ -215,8 +246,10 @@ class pdf_hummus_renderer_rep : public renderer_rep {
   
 public:
   pdf_hummus_renderer_rep (url pdf_file_name, int dpi, int nr_pages,
-                           string ptype, bool landsc, double paper_w, double paper_h);
+                           string ptype, bool landsc, double paper_w, double paper_h,
+                           int mode= PDF_COMPLETE);
   ~pdf_hummus_renderer_rep ();
+  bool append_part (url part);
   bool is_printer ();
   bool is_started ();
   void next_page ();
@@ -283,8 +316,9 @@ void pdf_image_info (url image, int& w, int& h, PDFRectangle& cropBox, double (&
 
 pdf_hummus_renderer_rep::pdf_hummus_renderer_rep (
   url pdf_file_name2, int dpi2, int nr_pages2,
-  string page_type2, bool landscape2, double paper_w2, double paper_h2):
-    renderer_rep (false),
+  string page_type2, bool landscape2, double paper_w2, double paper_h2,
+  int mode2):
+    renderer_rep (false), mode (mode2),
     pdf_file_name (pdf_file_name2), dpi (dpi2),
     nr_pages (nr_pages2), page_type (page_type2),
     landscape (landscape2), paper_w (paper_w2), paper_h (paper_h2),
@@ -353,7 +387,8 @@ pdf_hummus_renderer_rep::pdf_hummus_renderer_rep (
 		objectsContext.EndIndirectObject();
 
 		// start real work
-		begin_page();
+		page= NULL;
+		if (mode != PDF_MERGE) begin_page();
 	}
 }
 
@@ -364,8 +399,11 @@ pdf_hummus_renderer_rep::~pdf_hummus_renderer_rep () {
   flush_images();
   flush_patterns();
   flush_glyphs();
-  flush_dests();
-  flush_outlines();
+  if (mode == PDF_PART) save_part_info();
+  else {
+    flush_dests();
+    flush_outlines();
+  }
   flush_fonts();
   flush_metadata();
  
@@ -2268,6 +2306,16 @@ int pdf_hummus_renderer_rep::get_label_id(string label)
   return label_id(label);
 }
 
+string
+pdf_hummus_renderer_rep::dest_name (string label) {
+  // the names of the destinations should not depend on the part
+  if (mode == PDF_COMPLETE) return "label" * as_string (get_label_id (label));
+  string r= "label-";
+  for (int i=0; i<N(label); i++)
+    r << as_hexadecimal ((int) (unsigned char) label[i], 2);
+  return r;
+}
+
 void
 pdf_hummus_renderer_rep::anchor (string label, SI x1, SI y1, SI x2, SI y2)
 {
@@ -2294,7 +2342,7 @@ pdf_hummus_renderer_rep::href (string label, SI x1, SI y1, SI x2, SI y2)
   dict << as_string(((double)default_dpi / dpi)*to_x(x2 + 5*pixel)) << " ";
   dict << as_string(((double)default_dpi / dpi)*to_y(y2 + 10*pixel)) << "]\r\n";
   if (starts (label, "#")) {
-    dict << "\t/Dest /label" << as_string(get_label_id(prepare_text (label))) << "\r\n";
+    dict << "\t/Dest /" << dest_name (prepare_text (label)) << "\r\n";
   }
   else {
     dict << "/A << /S /URI /URI (" << prepare_text (label) << ") >>\r\n";
@@ -2320,7 +2368,7 @@ pdf_hummus_renderer_rep::flush_dests()
     int dest_x = it->item.x3;
     int dest_y = it->item.x4;
     {
-      dict << "\t\t/label" << as_string(get_label_id(label)) << " [ " << as_string(page_id(dest_page)) << " 0 R /XYZ "
+      dict << "\t\t/" << dest_name (label) << " [ " << as_string(page_id(dest_page)) << " 0 R /XYZ "
            << as_string(((double)default_dpi / dpi)*dest_x) << " " << as_string(((double)default_dpi / dpi)*dest_y) << " null ]\r\n";
     }
     it = it->next;
@@ -2514,16 +2562,278 @@ pdf_hummus_renderer_rep::shadow (picture& pic, SI x1, SI y1, SI x2, SI y2) {
 }
 
 
+/******************************************************************************
+* documents exported in several parts
+******************************************************************************/
+
+static string
+hex_encode (string s) {
+  string r;
+  for (int i=0; i<N(s); i++)
+    r << as_hexadecimal ((int) (unsigned char) s[i], 2);
+  return r;
+}
+
+static string
+hex_decode (string s) {
+  string r;
+  for (int i=0; i+1<N(s); i+=2)
+    r << (char) from_hexadecimal (s (i, i+2));
+  return r;
+}
+
+void
+pdf_hummus_renderer_rep::save_part_info () {
+  string s;
+  for (list<dest_data> it= dests; !is_nil (it); it= it->next)
+    s << "dest " << hex_encode (it->item.x1) << " "
+      << as_string (it->item.x2) << " " << as_string (it->item.x3) << " "
+      << as_string (it->item.x4) << "\n";
+  for (list<outline_data> it= outlines; !is_nil (it); it= it->next)
+    s << "outline " << hex_encode (it->item.x1) << " "
+      << as_string (it->item.x2) << " " << as_string (it->item.x3) << " "
+      << as_string (it->item.x4) << " " << as_string (it->item.x5) << "\n";
+  if (save_string (glue (pdf_file_name, ".info"), s))
+    convert_error << "Failed to save links of " << pdf_file_name << "\n";
+}
+
+bool
+pdf_hummus_renderer_rep::load_part_info (url info, int offset) {
+  string s;
+  if (load_string (info, s, false)) return false;
+  array<string> lines= tokenize (s, "\n");
+  for (int i=0; i<N(lines); i++) {
+    array<string> f= tokenize (lines[i], " ");
+    if (N(f) == 5 && f[0] == "dest")
+      dests << dest_data (hex_decode (f[1]), offset + as_int (f[2]),
+                          as_int (f[3]), as_int (f[4]));
+    else if (N(f) == 6 && f[0] == "outline")
+      outlines << outline_data (hex_decode (f[1]), offset + as_int (f[2]),
+                                as_int (f[3]), as_int (f[4]), as_int (f[5]));
+  }
+  return true;
+}
+
+static std::string
+strip_subset_tag (const std::string& name) {
+  // subsets of the same font get different tags in different parts
+  if (name.size () > 7 && name[6] == '+') {
+    int i= 0;
+    while (i < 6 && name[i] >= 'A' && name[i] <= 'Z') i++;
+    if (i == 6) return name.substr (7);
+  }
+  return name;
+}
+
+static void
+digest_object (PDFParser* parser, PDFObject* obj, MD5Generator& md5,
+               hashmap<ObjectIDType,int>& visited) {
+  // accumulates a serialization of obj and of the objects it refers to,
+  // which does not depend on the object numbers in the part
+  switch (obj->GetType ()) {
+  case PDFObject::ePDFObjectBoolean:
+    md5.Accumulate (((PDFBoolean*) obj)->GetValue ()? "t": "f");
+    break;
+  case PDFObject::ePDFObjectLiteralString:
+    md5.Accumulate ("(" + ((PDFLiteralString*) obj)->GetValue () + ")");
+    break;
+  case PDFObject::ePDFObjectHexString:
+    md5.Accumulate ("<" + ((PDFHexString*) obj)->GetValue () + ">");
+    break;
+  case PDFObject::ePDFObjectNull:
+    md5.Accumulate ("n");
+    break;
+  case PDFObject::ePDFObjectName:
+    md5.Accumulate ("/" + ((PDFName*) obj)->GetValue () + " ");
+    break;
+  case PDFObject::ePDFObjectInteger:
+    md5.Accumulate ("i" + std::to_string (((PDFInteger*) obj)->GetValue ()));
+    break;
+  case PDFObject::ePDFObjectReal:
+    md5.Accumulate ("r" + std::to_string (((PDFReal*) obj)->GetValue ()));
+    break;
+  case PDFObject::ePDFObjectSymbol:
+    md5.Accumulate ("s" + ((PDFSymbol*) obj)->GetValue () + " ");
+    break;
+  case PDFObject::ePDFObjectArray: {
+    PDFArray* a= (PDFArray*) obj;
+    md5.Accumulate ("[");
+    for (unsigned long i=0; i<a->GetLength (); i++) {
+      RefCountPtr<PDFObject> item (a->QueryObject (i));
+      digest_object (parser, item.GetPtr (), md5, visited);
+    }
+    md5.Accumulate ("]");
+    break;
+  }
+  case PDFObject::ePDFObjectDictionary: {
+    MapIterator<PDFNameToPDFObjectMap> it=
+      ((PDFDictionary*) obj)->GetIterator ();
+    md5.Accumulate ("<<");
+    while (it.MoveNext ()) {
+      std::string key= it.GetKey ()->GetValue ();
+      PDFObject* val= it.GetValue ();
+      md5.Accumulate ("/" + key + " ");
+      if ((key == "BaseFont" || key == "FontName") &&
+          val->GetType () == PDFObject::ePDFObjectName)
+        md5.Accumulate (strip_subset_tag (((PDFName*) val)->GetValue ()));
+      else digest_object (parser, val, md5, visited);
+    }
+    md5.Accumulate (">>");
+    break;
+  }
+  case PDFObject::ePDFObjectIndirectObjectReference: {
+    ObjectIDType id= ((PDFIndirectObjectReference*) obj)->mObjectID;
+    if (visited->contains (id)) {
+      md5.Accumulate ("R" + std::to_string (visited[id]));
+      break;
+    }
+    int k= N(visited);
+    visited (id)= k;
+    RefCountPtr<PDFObject> target (parser->ParseNewObject (id));
+    if (target.GetPtr () == NULL) md5.Accumulate ("?");
+    else digest_object (parser, target.GetPtr (), md5, visited);
+    break;
+  }
+  case PDFObject::ePDFObjectStream: {
+    PDFStreamInput* stream= (PDFStreamInput*) obj;
+    RefCountPtr<PDFDictionary> dict (stream->QueryStreamDictionary ());
+    digest_object (parser, dict.GetPtr (), md5, visited);
+    IByteReader* reader= parser->StartReadingFromStreamForPlainCopying (stream);
+    if (reader == NULL) { md5.Accumulate ("?"); break; }
+    md5.Accumulate ("stream");
+    IOBasicTypes::Byte buf[4096];
+    while (reader->NotEnded ()) {
+      IOBasicTypes::LongBufferSizeType n= reader->Read (buf, sizeof (buf));
+      if (n == 0) break;
+      md5.Accumulate (buf, n);
+    }
+    delete reader;
+    break;
+  }
+  }
+}
+
+static string
+digest_object (PDFParser* parser, ObjectIDType id) {
+  MD5Generator md5;
+  hashmap<ObjectIDType,int> visited (-1);
+  PDFIndirectObjectReference ref (id, 0);
+  digest_object (parser, &ref, md5, visited);
+  const std::string& r= md5.ToHexString ();
+  return string (r.c_str ());
+}
+
+void
+pdf_hummus_renderer_rep::share_resources (PDFParser* parser,
+                                          PDFDictionary* page_dict,
+                                          ObjectIDTypeToObjectIDTypeMap& shared,
+                                          hashmap<ObjectIDType,string>& fresh) {
+  // resources of the page which are identical to resources copied from
+  // a previous part are mapped onto the latter instead of being copied
+  PDFObjectCastPtr<PDFDictionary> res
+    (parser->QueryDictionaryObject (page_dict, "Resources"));
+  if (!res) return;
+  const char* kinds[]= { "Font", "XObject", "Pattern", "ExtGState" };
+  for (const char* kind: kinds) {
+    PDFObjectCastPtr<PDFDictionary> dict
+      (parser->QueryDictionaryObject (res.GetPtr (), kind));
+    if (!dict) continue;
+    MapIterator<PDFNameToPDFObjectMap> it= dict->GetIterator ();
+    while (it.MoveNext ()) {
+      PDFObject* val= it.GetValue ();
+      if (val->GetType () != PDFObject::ePDFObjectIndirectObjectReference)
+        continue;
+      ObjectIDType id= ((PDFIndirectObjectReference*) val)->mObjectID;
+      if (shared.count (id) != 0 || fresh->contains (id)) continue;
+      string key= digest_object (parser, id);
+      if (merged_resources->contains (key)) shared[id]= merged_resources[key];
+      else fresh (id)= key;
+    }
+  }
+}
+
+bool
+pdf_hummus_renderer_rep::append_part (url part) {
+  // the pages are copied together with their link annotations,
+  // which refer to named destinations of the complete document
+  c_string name (concretize (part));
+  PDFDocumentCopyingContext* copyingContext=
+    pdfWriter.CreatePDFCopyingContext ((char*) name);
+  if (copyingContext == NULL) return false;
+  PDFParser* parser= copyingContext->GetSourceDocumentParser ();
+  DocumentContext& dc= pdfWriter.GetDocumentContext ();
+  int offset= page_num;
+  bool ok= true;
+  unsigned long n= parser->GetPagesCount ();
+
+  // fonts, images and patterns already copied from previous parts are shared
+  ObjectIDTypeToObjectIDTypeMap shared;
+  hashmap<ObjectIDType,string> fresh;
+  for (unsigned long i=0; i<n; i++) {
+    PDFObjectCastPtr<PDFDictionary> pageDict (parser->ParsePage (i));
+    if (!(!pageDict)) share_resources (parser, pageDict.GetPtr (), shared, fresh);
+  }
+  copyingContext->ReplaceSourceObjects (shared);
+
+  for (unsigned long i=0; ok && i<n; i++) {
+    PDFObjectCastPtr<PDFDictionary> pageDict (parser->ParsePage (i));
+    if (!pageDict) { ok= false; break; }
+    PDFObjectCastPtr<PDFArray> annots
+      (parser->QueryDictionaryObject (pageDict.GetPtr (), "Annots"));
+    if (!(!annots))
+      for (unsigned long j=0; j<annots->GetLength (); j++) {
+        RefCountPtr<PDFObject> obj (annots->QueryObject (j));
+        if (obj->GetType () != PDFObject::ePDFObjectIndirectObjectReference)
+          continue;
+        ObjectIDType id= ((PDFIndirectObjectReference*) obj.GetPtr ())->mObjectID;
+        EStatusCodeAndObjectIDType res= copyingContext->CopyObject (id);
+        if (res.first != PDFHummus::eSuccess) ok= false;
+        else dc.RegisterAnnotationReferenceForNextPageWrite (res.second);
+      }
+    EStatusCodeAndObjectIDType res= copyingContext->AppendPDFPageFromPDF (i);
+    if (res.first != PDFHummus::eSuccess) ok= false;
+    else page_id (page_num++)= res.second;
+  }
+
+  MapIterator<ObjectIDTypeToObjectIDTypeMap> it=
+    copyingContext->GetCopiedObjectsMappingIterator ();
+  while (it.MoveNext ())
+    if (fresh->contains (it.GetKey ()))
+      merged_resources (fresh[it.GetKey ()])= it.GetValue ();
+  delete copyingContext;
+  return ok && load_part_info (glue (part, ".info"), offset);
+}
+
 /******************************************************************************
 * user interface
 ******************************************************************************/
 
 renderer
 pdf_hummus_renderer (url pdf_file_name, int dpi, int nr_pages,
-                     string page_type, bool landscape, double paper_w, double paper_h)
+                     string page_type, bool landscape, double paper_w, double paper_h,
+                     bool part)
 {
   //cout << "Hummus print to " << pdf_file_name << " at " << dpi << " dpi\n";
   page_type= as_string (call ("standard-paper-size", object (page_type)));
   return tm_new<pdf_hummus_renderer_rep> (pdf_file_name, dpi, nr_pages,
-			  page_type, landscape, paper_w, paper_h);
+			  page_type, landscape, paper_w, paper_h,
+			  part? PDF_PART: PDF_COMPLETE);
+}
+
+bool
+pdf_hummus_merge (array<url> parts, url pdf_file_name, int dpi,
+                  hashmap<string,string> metadata) {
+  pdf_hummus_renderer_rep* ren=
+    tm_new<pdf_hummus_renderer_rep> (pdf_file_name, dpi, 0, "user",
+                                     false, 21.0, 29.7, PDF_MERGE);
+  bool ok= ren->is_started ();
+  for (int i=0; ok && i<N(parts); i++)
+    ok= ren->append_part (parts[i]);
+  iterator<string> it= iterate (metadata);
+  while (it->busy ()) {
+    string kind= it->next ();
+    ren->set_metadata (kind, metadata[kind]);
+  }
+  tm_delete (ren);
+  return ok;
 }
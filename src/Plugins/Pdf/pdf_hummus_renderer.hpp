@@ -19,7 +19,10 @@
 
 renderer pdf_hummus_renderer (url pdf_file_name, int dpi, int nr_pages= 1,
                               string page_type= "a4", bool landscape= false,
-                              double paper_w= 21.0, double paper_h= 29.7);
+                              double paper_w= 21.0, double paper_h= 29.7,
+                              bool part= false);
+bool pdf_hummus_merge (array<url> parts, url pdf_file_name, int dpi,
+                       hashmap<string,string> metadata);
 		  
 void hummus_pdf_image_size (url image, int& w, int& h);
 
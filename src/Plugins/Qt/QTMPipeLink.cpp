@@ -14,6 +14,7 @@
 #include "qt_gui.hpp"
 #include "QTMPipeLink.hpp"
 #include <QByteArray>
+#include <QTimer>
 
 static string
 debug_io_string (QByteArray s) {
@@ -42,12 +43,16 @@ END_SLOT
 QTMPipeLink::QTMPipeLink (string cmd2) : cmd (cmd2), outbuf (""), errbuf ("") {}
 
 QTMPipeLink::~QTMPipeLink () {
-  killProcess (1000);
+  killProcess (0);
 }
 
 bool
 QTMPipeLink::launchCmd () {
-  if (state () != QProcess::NotRunning) killProcess (1000);
+  if (state () != QProcess::NotRunning) {
+    // a previous instance is still within its grace period
+    kill ();
+    waitForFinished (1000);
+  }
   //FIXME: is UTF8 the right encoding here?
   QProcess::start(utf8_to_qstring(cmd));
   bool r= waitForStarted ();
@@ -70,10 +75,13 @@ void
 QTMPipeLink::feedBuf (ProcessChannel channel) {
   setReadChannel (channel);
   QByteArray tempout = QIODevice::readAll ();
-  if (channel == QProcess::StandardOutput) outbuf << tempout.constData ();
-  else errbuf << tempout.constData ();
+  if (tempout.size () == 0) return;
+  // append all bytes at once, including possible null characters
+  string s (tempout.constData (), (int) tempout.size ());
+  if (channel == QProcess::StandardOutput) outbuf << s;
+  else errbuf << s;
   if (DEBUG_IO)
-    debug_io << "[OUTPUT " << channel << "]" << debug_io_string (tempout.constData ()) << "\n";
+    debug_io << "[OUTPUT " << channel << "]" << debug_io_string (tempout) << "\n";
 }
 
 bool
@@ -90,8 +98,21 @@ QTMPipeLink::killProcess (int msecs) {
   (void) msecs;
   close ();
 #else
+  if (state () == QProcess::NotRunning) return;
   terminate ();
-  if (! waitForFinished (msecs)) kill ();
+  // kill the process later on if it ignores the request, without waiting
+  QTimer::singleShot (msecs, this, [this] () {
+    if (state () != QProcess::NotRunning) kill (); });
 #endif
 }
 
+void
+QTMPipeLink::finishProcess (int msecs) {
+  // wait for a terminating process, but not longer than msecs
+  if (state () == QProcess::NotRunning) return;
+  if (!waitForFinished (msecs)) {
+    kill ();
+    waitForFinished (100);
+  }
+}
+
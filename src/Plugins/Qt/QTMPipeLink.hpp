@@ -41,6 +41,7 @@ public:
   void feedBuf (ProcessChannel);
   bool listenChannel (ProcessChannel, int msecs);
   void killProcess (int msecs);
+  void finishProcess (int msecs);
 };
 
 #endif // QTM_PIPE_LINK
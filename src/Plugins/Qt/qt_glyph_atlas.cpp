@@ -0,0 +1,200 @@
+
+/******************************************************************************
+* MODULE     : qt_glyph_atlas.cpp
+* DESCRIPTION: Bounded atlas of rasterized glyphs for the Qt renderer
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "qt_glyph_atlas.hpp"
+#include "boot.hpp"
+#include "analyze.hpp"
+#include <string.h>
+
+/******************************************************************************
+* Pages of the atlas
+******************************************************************************/
+
+glyph_page_rep::glyph_page_rep (int w, int h):
+  im (new QImage (w, h, QImage::Format_Alpha8)), stamp (0), top (0) {}
+
+glyph_page_rep::~glyph_page_rep () {
+  delete im;
+}
+
+/******************************************************************************
+* Allocation of space for new glyphs
+******************************************************************************/
+
+qt_glyph_atlas_rep::qt_glyph_atlas_rep (int budget2):
+  budget (budget2), used (0), clock (0) {}
+
+qt_glyph_atlas_rep::~qt_glyph_atlas_rep () {
+  clear ();
+}
+
+void
+qt_glyph_atlas_rep::evict (int nr) {
+  glyph_page_rep* pg= pages[nr];
+  for (int i=0; i<N(pg->keys); i++)
+    glyphs->reset (pg->keys[i]);
+  used -= pg->im->width () * pg->im->height ();
+  tm_delete (pg);
+  pages[nr]= NULL;
+}
+
+void
+qt_glyph_atlas_rep::reserve (int bytes) {
+  while (used + bytes > budget) {
+    int best= -1;
+    for (int i=0; i<N(pages); i++)
+      if (pages[i] != NULL)
+        if (best < 0 || pages[i]->stamp < pages[best]->stamp)
+          best= i;
+    if (best < 0) return;
+    evict (best);
+  }
+}
+
+int
+qt_glyph_atlas_rep::new_page (int w, int h) {
+  reserve (w * h);
+  glyph_page_rep* pg= tm_new<glyph_page_rep> (w, h);
+  used += w * h;
+  for (int i=0; i<N(pages); i++)
+    if (pages[i] == NULL) {
+      pages[i]= pg;
+      return i;
+    }
+  pages << pg;
+  return N(pages) - 1;
+}
+
+int
+qt_glyph_atlas_rep::allocate (int w, int h, int& x, int& y) {
+  // Glyphs which are too large get a page of their own
+  if (w > GLYPH_PAGE_SIZE || h > GLYPH_PAGE_SIZE) {
+    int nr= new_page (w, h);
+    pages[nr]->top= h;
+    x= y= 0;
+    return nr;
+  }
+
+  // Try to find room on an existing shelf of a similar height
+  for (int nr=0; nr<N(pages); nr++) {
+    glyph_page_rep* pg= pages[nr];
+    if (pg == NULL || pg->im->width () != GLYPH_PAGE_SIZE) continue;
+    for (int s=0; s<N(pg->shelf_h); s++)
+      if (pg->shelf_h[s] >= h && pg->shelf_h[s] <= h + (h >> 2) + 2 &&
+          pg->shelf_x[s] + w <= GLYPH_PAGE_SIZE) {
+        x= pg->shelf_x[s];
+        y= pg->shelf_y[s];
+        pg->shelf_x[s] += w;
+        return nr;
+      }
+  }
+
+  // Otherwise open a new shelf, if necessary on a new page
+  int sh= std::min ((h + 3) & ~3, GLYPH_PAGE_SIZE);
+  int nr;
+  for (nr=0; nr<N(pages); nr++)
+    if (pages[nr] != NULL &&
+        pages[nr]->im->width () == GLYPH_PAGE_SIZE &&
+        pages[nr]->top + sh <= GLYPH_PAGE_SIZE)
+      break;
+  if (nr == N(pages)) nr= new_page (GLYPH_PAGE_SIZE, GLYPH_PAGE_SIZE);
+  glyph_page_rep* pg= pages[nr];
+  pg->shelf_y << pg->top;
+  pg->shelf_h << sh;
+  pg->shelf_x << w;
+  x= 0;
+  y= pg->top;
+  pg->top += sh;
+  return nr;
+}
+
+/******************************************************************************
+* Retrieving glyphs
+******************************************************************************/
+
+atlas_glyph
+qt_glyph_atlas_rep::get (int c, font_glyphs fng, int sf) {
+  basic_character xc (c, fng, sf, 0, 0);
+  atlas_glyph ag= glyphs [xc];
+  if (!is_nil (ag)) {
+    if (ag->page >= 0) pages[ag->page]->stamp= ++clock;
+    return ag;
+  }
+
+  SI xo, yo;
+  glyph pre_gl= fng->get (c);
+  if (is_nil (pre_gl)) return ag;
+  glyph gl= shrink (pre_gl, sf, sf, xo, yo);
+  int w= gl->width, h= gl->height;
+  if (w <= 0 || h <= 0) {
+    ag= atlas_glyph (-1, 0, 0, 0, 0, xo, yo);
+    glyphs (xc)= ag;
+    return ag;
+  }
+
+  int x, y, nr= allocate (w, h, x, y);
+  glyph_page_rep* pg= pages[nr];
+  for (int j=0; j<h; j++) {
+    uchar* row= pg->im->scanLine (y + j) + x;
+    if (gl->depth == 1)
+      for (int i=0; i<w; i++) row[i]= (uchar) gl->get_1 (i, j);
+    else memcpy (row, gl->raster + j*w, w);
+  }
+  pg->keys << xc;
+  pg->stamp= ++clock;
+  ag= atlas_glyph (nr, x, y, w, h, xo, yo);
+  glyphs (xc)= ag;
+  return ag;
+}
+
+void
+qt_glyph_atlas_rep::colour (atlas_glyph ag, const QRgb* lut, QImage& im) {
+  // colour the glyph row by row into the top left corner of im
+  QImage* page= pages[ag->page]->im;
+  for (int j=0; j<ag->h; j++) {
+    const uchar* src= page->constScanLine (ag->y + j) + ag->x;
+    QRgb* dest= (QRgb*) im.scanLine (j);
+    for (int i=0; i<ag->w; i++) dest[i]= lut[src[i]];
+  }
+}
+
+QImage
+qt_glyph_atlas_rep::image (atlas_glyph ag, const QRgb* lut) {
+  // a new image with the coloured glyph, which is not written to afterwards
+  QImage im (ag->w, ag->h, QImage::Format_ARGB32_Premultiplied);
+  colour (ag, lut, im);
+  return im;
+}
+
+void
+qt_glyph_atlas_rep::clear () {
+  for (int i=0; i<N(pages); i++)
+    if (pages[i] != NULL) tm_delete (pages[i]);
+  pages= array<glyph_page_rep*> ();
+  glyphs= hashmap<basic_character,atlas_glyph> ();
+  used= 0;
+}
+
+/******************************************************************************
+* The global atlas
+******************************************************************************/
+
+qt_glyph_atlas_rep*
+the_glyph_atlas () {
+  static qt_glyph_atlas_rep* atlas= NULL;
+  if (atlas == NULL) {
+    // budget in megabytes
+    int mb= as_int (get_user_preference ("glyph cache size", "32"));
+    mb= std::max (1, std::min (mb, 1024));
+    atlas= tm_new<qt_glyph_atlas_rep> (mb << 20);
+  }
+  return atlas;
+}
@@ -0,0 +1,82 @@
+
+/******************************************************************************
+* MODULE     : qt_glyph_atlas.hpp
+* DESCRIPTION: Bounded atlas of rasterized glyphs for the Qt renderer
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#ifndef QT_GLYPH_ATLAS_HPP
+#define QT_GLYPH_ATLAS_HPP
+
+#include "basic_renderer.hpp"
+#include <QImage>
+
+/******************************************************************************
+* The glyphs are shrunk once for each shrinking factor and their coverage
+* is stored without colour on 8 bit pages, packed into shelves. Colours are
+* only applied when the glyphs are drawn. When the total size of the pages
+* exceeds the budget, the least recently used pages are released together
+* with all glyphs on them. Glyphs which are recorded into pictures are
+* coloured into images of their own: pictures keep shallow copies of the
+* images, which would be detached (copied) when reusing a shared buffer.
+******************************************************************************/
+
+#define GLYPH_PAGE_SIZE 512
+
+struct atlas_glyph_rep: concrete_struct {
+  int page;    // page of the atlas
+  int x, y;    // position on the page
+  int w, h;    // size in pixels
+  SI  xo, yo;  // origin of the shrunk glyph
+  atlas_glyph_rep (int page2, int x2, int y2, int w2, int h2,
+                   SI xo2, SI yo2):
+    page (page2), x (x2), y (y2), w (w2), h (h2), xo (xo2), yo (yo2) {}
+};
+
+class atlas_glyph {
+  CONCRETE_NULL(atlas_glyph);
+  atlas_glyph (int page, int x, int y, int w, int h, SI xo, SI yo):
+    rep (tm_new<atlas_glyph_rep> (page, x, y, w, h, xo, yo)) {}
+};
+CONCRETE_NULL_CODE(atlas_glyph);
+
+struct glyph_page_rep {
+  QImage*    im;        // 8 bit coverage of the glyphs
+  int        stamp;     // last time a glyph on the page was drawn
+  int        top;       // first row which is not yet in a shelf
+  array<int> shelf_y;   // vertical positions of the shelves
+  array<int> shelf_h;   // heights of the shelves
+  array<int> shelf_x;   // first free column on each shelf
+  array<basic_character> keys; // the glyphs on the page
+  glyph_page_rep (int w, int h);
+  ~glyph_page_rep ();
+};
+
+class qt_glyph_atlas_rep {
+  int budget;                  // maximal size of the pages in bytes
+  int used;                    // current size of the pages in bytes
+  int clock;                   // for the least recently used pages
+  array<glyph_page_rep*> pages;
+  hashmap<basic_character,atlas_glyph> glyphs;
+
+  void reserve (int bytes);
+  void evict (int nr);
+  int  new_page (int w, int h);
+  int  allocate (int w, int h, int& x, int& y);
+
+public:
+  qt_glyph_atlas_rep (int budget);
+  ~qt_glyph_atlas_rep ();
+  atlas_glyph get (int c, font_glyphs fng, int sf);
+  void colour (atlas_glyph ag, const QRgb* lut, QImage& im);
+  QImage image (atlas_glyph ag, const QRgb* lut);
+  void clear ();
+};
+
+qt_glyph_atlas_rep* the_glyph_atlas ();
+
+#endif // defined QT_GLYPH_ATLAS_HPP
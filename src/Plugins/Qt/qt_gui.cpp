@@ -1040,8 +1040,7 @@ command_queue::~command_queue() { clear_pending(); /* implicit */ }
 void command_queue::launch(object cmd, string name, time_t when) {
 
 /*    if (the_view == nullptr) {
-        *mPendingCommands.getPushElement() = command(cmd, when, name);
-        mPendingCommands.notifyPush();
+        mPendingCommands.push(command(cmd, when, name));
         lapse = texmacs_time();
         the_gui->need_update();
         wait = true;
@@ -1079,8 +1078,7 @@ void command_queue::launch(object cmd, string name, time_t when) {
 
 void
 command_queue::exec(object cmd, string name) {
-    /**mPendingCommands.getPushElement() = command(cmd, (((time_t) texmacs_time()) - 1000000000), name);
-    mPendingCommands.notifyPush();
+    /*mPendingCommands.push(command(cmd, (((time_t) texmacs_time()) - 1000000000), name));
     lapse = texmacs_time();
     the_gui->need_update();
     wait = true;*/
@@ -1090,8 +1088,7 @@ command_queue::exec(object cmd, string name) {
 void
 command_queue::exec_pause(object cmd, string name) {
     /*qDebug() << "exec_pause " << QString::fromStdString(std::string(name.data(), N(name)));
-    *mPendingCommands.getPushElement() = command(cmd, ((time_t) texmacs_time()), name);
-    mPendingCommands.notifyPush();
+    mPendingCommands.push(command(cmd, ((time_t) texmacs_time()), name));
     lapse = texmacs_time();
     the_gui->need_update();
     wait = true;*/
@@ -1105,17 +1102,15 @@ command_queue::exec_pending() {
         return;
     }
 
-    int n = mPendingCommands.getCurrentSize();
-    for (int i = 0; i < n; i++) {
-        command cmd = *mPendingCommands.getPopElement();
-        mPendingCommands.notifyPop();
+    command cmd;
+    while (mPendingCommands.tryPop(cmd)) {
         mCommands << cmd;
     }
 
     array<command> commands = mCommands;
     mCommands = array<command>(0);
 
-    n = N(commands);
+    int n = N(commands);
     for (int i = 0; i < n; i++) {
         time_t now = texmacs_time();
         if ((now - commands[i].start_time) < 0) {
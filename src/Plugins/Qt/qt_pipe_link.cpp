@@ -45,6 +45,7 @@ public:
   bool    is_readable (int channel);
   void    interrupt ();
   void    stop ();
+  int     process_id ();
   void    feed (int channel);
 };
 
@@ -145,10 +146,16 @@ qt_pipe_link_rep::interrupt () {
 
 void
 qt_pipe_link_rep::stop () {
-  PipeLink.killProcess (0);
+  PipeLink.killProcess (get_plugin_grace_period ());
   alive= false;
 }
 
+int
+qt_pipe_link_rep::process_id () {
+  if (PipeLink.state () == QProcess::NotRunning) return -1;
+  return (int) PipeLink.processId ();
+}
+
 /******************************************************************************
 * Main builder function for qt_pipe_links
 ******************************************************************************/
@@ -164,11 +171,18 @@ make_pipe_link (string cmd) {
 
 void
 close_all_pipes () {
+  // all sessions share a single grace period
+  time_t until= texmacs_time () + get_plugin_grace_period ();
   iterator<pointer> it= iterate (pipe_link_set);
   while (it->busy()) {
     qt_pipe_link_rep* con= (qt_pipe_link_rep*) it->next();
     if (con->alive) con->stop ();
   }
+  it= iterate (pipe_link_set);
+  while (it->busy()) {
+    qt_pipe_link_rep* con= (qt_pipe_link_rep*) it->next();
+    con->PipeLink.finishProcess (std::max ((int) (until - texmacs_time ()), 0));
+  }
 }
 
 void
@@ -10,6 +10,7 @@
 ******************************************************************************/
 
 #include "qt_renderer.hpp"
+#include "qt_glyph_atlas.hpp"
 #include "analyze.hpp"
 #include "image_files.hpp"
 #include "qt_utilities.hpp"
@@ -24,29 +25,6 @@
 #include <QPainterPath>
 #include <QPixmap>
 
-/******************************************************************************
-* Qt images
-******************************************************************************/
-
-struct qt_image_rep: concrete_struct {
-    QTMImage *img;
-    SI xo,yo;
-    int w,h;
-    qt_image_rep (QTMImage* img2, SI xo2, SI yo2, int w2, int h2):
-            img (img2), xo (xo2), yo (yo2), w (w2), h (h2) {};
-    ~qt_image_rep() { delete img; };
-    friend class qt_image;
-};
-
-class qt_image {
-    CONCRETE_NULL(qt_image);
-    qt_image (QTMImage* img2, SI xo2, SI yo2, int w2, int h2):
-            rep (tm_new<qt_image_rep> (img2, xo2, yo2, w2, h2)) {};
-    // qt_image ();
-};
-
-CONCRETE_NULL_CODE(qt_image);
-
 /******************************************************************************
  * Qt pixmaps
  ******************************************************************************/
@@ -74,8 +52,8 @@ CONCRETE_NULL_CODE(qt_pixmap);
 * Global support variables for all qt_renderers
 ******************************************************************************/
 
-// bitmaps of all characters
-static hashmap<basic_character,qt_image> character_image;
+// buffer for drawing coloured glyphs from the atlas
+static QImage glyph_buffer;
 // image cache
 static hashmap<string,qt_pixmap> images;
 
@@ -85,7 +63,8 @@ static hashmap<string,qt_pixmap> images;
 ** Qt exit function
 */
 void del_obj_qt_renderer(void)  {
-    character_image= hashmap<basic_character,qt_image> ();
+    the_glyph_atlas ()->clear ();
+    glyph_buffer= QImage ();
     images= hashmap<string,qt_pixmap>() ;
 }
 
@@ -441,9 +420,15 @@ qt_renderer_rep::draw_triangle (SI x1, SI y1, SI x2, SI y2, SI x3, SI y3) {
 * Image rendering
 ******************************************************************************/
 
+static inline bool
+is_recording (QPainter* p) {
+    // recorded pictures may be replayed on worker threads, on which pixmaps
+    // cannot be used, so that they have to be converted into images first
+    return p->device () != NULL && p->device ()->devType () == QInternal::Picture;
+}
+
 void
 qt_renderer_rep::draw_clipped (QImage *im, int w, int h, SI x, SI y) {
-    (void) w; (void) h;
     int x1=cx1-ox, y1=cy2-oy, x2= cx2-ox, y2= cy1-oy;
     decode (x , y );
     decode (x1, y1);
@@ -451,7 +436,7 @@ qt_renderer_rep::draw_clipped (QImage *im, int w, int h, SI x, SI y) {
     y--; // top-left origin to bottom-left origin conversion
     // clear(x1,y1,x2,y2);
     //painter->setRenderHints (0);
-    painter->drawImage (x, y, *im);
+    painter->drawImage (x, y, *im, 0, 0, w, h);
 }
 
 void
@@ -464,7 +449,10 @@ qt_renderer_rep::draw_clipped (QTMPixmapOrImage *im, int w, int h, SI x, SI y) {
     y--; // top-left origin to bottom-left origin conversion
     // clear(x1,y1,x2,y2);
     //painter->setRenderHints (0);
-    painter->drawPixmap (x, y, w, h, *(im->QPixmap_ptr ()));
+    if (is_recording (painter))
+        painter->drawImage (QRect (x, y, w, h), im->QPixmap_ptr ()->toImage ());
+    else
+        painter->drawPixmap (x, y, w, h, *(im->QPixmap_ptr ()));
 }
 
 void
@@ -511,6 +499,25 @@ qt_renderer_rep::draw_bis (int c, font_glyphs fng, SI x, SI y) {
     delete im;
 }
 
+static const QRgb*
+glyph_colors (color fgc, int nr_cols) {
+    // premultiplied colours for all possible values of the glyph coverage
+    static QRgb  lut[256];
+    static color lut_col= 0;
+    static int   lut_nr = 0;
+    static bool  lut_rev= false;
+    bool rev= get_reverse_colors ();
+    if (fgc != lut_col || nr_cols != lut_nr || rev != lut_rev) {
+        int r, g, b, a;
+        get_rgb (fgc, r, g, b, a);
+        if (rev) reverse (r, g, b);
+        for (int col=0; col<256; col++)
+            lut[col]= qPremultiply (qRgba (r, g, b, (a*col)/nr_cols));
+        lut_col= fgc; lut_nr= nr_cols; lut_rev= rev;
+    }
+    return lut;
+}
+
 void
 qt_renderer_rep::draw (int c, font_glyphs fng, SI x, SI y) {
     if (pen->get_type () == pencil_brush) {
@@ -518,78 +525,30 @@ qt_renderer_rep::draw (int c, font_glyphs fng, SI x, SI y) {
         return;
     }
 
-    // get the pixmap
-    color fgc= pen->get_color ();
-    basic_character xc (c, fng, std_shrinkf, fgc, 0);
-    qt_image mi = character_image [xc];
-    if (is_nil(mi)) {
-        int r, g, b, a;
-        get_rgb (fgc, r, g, b, a);
-        if (get_reverse_colors ()) reverse (r, g, b);
-        SI xo, yo;
-        glyph pre_gl= fng->get (c); if (is_nil (pre_gl)) return;
-        glyph gl= shrink (pre_gl, std_shrinkf, std_shrinkf, xo, yo);
-        int i, j, w= gl->width, h= gl->height;
-#ifdef QTMPIXMAPS
-        QTMPixmapOrImage* im= new QTMPixmapOrImage (w, h);
-    if (!headless_mode) {
-      int nr_cols= std_shrinkf*std_shrinkf;
-      if (nr_cols >= 64) nr_cols= 64;
-
-      im->fill (Qt::transparent);
-      QPainter pp(im->QPixmap_ptr ());
-      QPen pen(painter->pen());
-      QBrush br(pen.color());
-      pp.setPen(Qt::NoPen);
-      for (j=0; j<h; j++)
-        for (i=0; i<w; i++) {
-          int col = gl->get_x (i, j);
-          br.setColor (QColor (r, g, b, (a*col)/nr_cols));
-          pp.fillRect (i, j, 1, 1, br);
-        }
-      pp.end();
-    }
-    else {
-      QImage* aux= im->QImage_ptr ();
-      int nr_cols= std_shrinkf*std_shrinkf;
-      if (nr_cols >= 64) nr_cols= 64;
-      im->fill (Qt::transparent);
-      for (j=0; j<h; j++)
-        for (i=0; i<w; i++) {
-          int col = gl->get_x (i, j);
-          aux->setPixel (i, j, qRgba (r, g, b, (a*col)/nr_cols));
-        }
-    }
-#else
-        QTMImage *im= new QImage (w, h, QImage::Format_ARGB32);
-        //QTMImage *im= new QImage (w, h, QImage::Format_ARGB32_Premultiplied);
-        {
-            int nr_cols= std_shrinkf*std_shrinkf;
-            if (nr_cols >= 64) nr_cols= 64;
-
-            // the following line is disabled because
-            // it causes a crash on Qt/X11 4.4.3
-            //im->fill (Qt::transparent);
-
-            for (j=0; j<h; j++)
-                for (i=0; i<w; i++) {
-                    int col = gl->get_x (i, j);
-                    im->setPixel (i, j, qRgba (r, g, b, (a*col)/nr_cols));
-                }
-        }
-#endif
-        qt_image mi2 (im, xo, yo, w, h);
-        mi = mi2;
-        //[im release]; // qt_image retains im
-        character_image (xc)= mi;
-        // FIXME: we must release the image at some point
-        //        (this should be ok now, see qt_image)
+    // get the glyph from the atlas
+    atlas_glyph ag= the_glyph_atlas ()->get (c, fng, std_shrinkf);
+    if (is_nil (ag) || ag->w == 0 || ag->h == 0) return;
+    int w= ag->w, h= ag->h;
+    SI  xx= x- ag->xo*std_shrinkf, yy= y+ ag->yo*std_shrinkf;
+
+    // colour it
+    int nr_cols= std_shrinkf*std_shrinkf;
+    if (nr_cols >= 64) nr_cols= 64;
+    const QRgb* lut= glyph_colors (pen->get_color (), nr_cols);
+    if (is_recording (painter)) {
+        // the picture shares the image, so we leave the buffer alone
+        QImage im= the_glyph_atlas ()->image (ag, lut);
+        draw_clipped (&im, w, h, xx, yy);
+        return;
     }
+    if (glyph_buffer.width () < w || glyph_buffer.height () < h)
+        glyph_buffer= QImage (std::max (w, glyph_buffer.width ()),
+                              std::max (h, glyph_buffer.height ()),
+                              QImage::Format_ARGB32_Premultiplied);
+    the_glyph_atlas ()->colour (ag, lut, glyph_buffer);
 
     // draw the character
-    //cout << (char)c << ": " << cx1/256 << ","  << cy1/256 << ","
-    //<< cx2/256 << ","  << cy2/256 << LF;
-    draw_clipped (mi->img, mi->w, mi->h, x- mi->xo*std_shrinkf, y+ mi->yo*std_shrinkf);
+    draw_clipped (&glyph_buffer, w, h, xx, yy);
 }
 
 void
@@ -732,6 +691,8 @@ qt_renderer_rep::put_shadow (renderer ren, SI x1, SI y1, SI x2, SI y2) {
         //    painter->setCompositionMode(QPainter::CompositionMode_Source);
         if (headless_mode)
             painter->drawImage (rect, *(shadow->px.QImage_ptr ()), rect);
+        else if (is_recording (painter))
+            painter->drawImage (rect, shadow->px.QPixmap_ptr ()->toImage (), rect);
         else
             painter->drawPixmap (rect, *(shadow->px.QPixmap_ptr ()), rect);
         //  XCopyArea (dpy, shadow->win, win, gc, x1, y2, x2-x1, y1-y2, x1, y2);
@@ -803,15 +764,14 @@ qt_proxy_renderer_rep::get_shadow (renderer ren, SI x1, SI y1, SI x2, SI y2) {
         shadow->painter->setClipRect(rect);
 
         //    shadow->painter->setCompositionMode(QPainter::CompositionMode_Source);
-        if (headless_mode) {
-            QImage *_image = static_cast<QImage*>(painter->device());
-            if (_image)
-                shadow->painter->drawImage (rect, *_image, rect);
-        } else {
-            QPixmap *_pixmap = static_cast<QPixmap*>(painter->device());
-            if (_pixmap)
-                shadow->painter->drawPixmap (rect, *_pixmap, rect);
-        }
+        // the device may be a pixmap, an image (a tile of the document)
+        // or a recorded picture, whose contents cannot be read back
+        QPaintDevice *device = painter->device();
+        int type = (device == NULL? QInternal::UnknownDevice: device->devType ());
+        if (type == QInternal::Image)
+            shadow->painter->drawImage (rect, *static_cast<QImage*>(device), rect);
+        else if (type == QInternal::Pixmap)
+            shadow->painter->drawPixmap (rect, *static_cast<QPixmap*>(device), rect);
         //    cout << "qt_shadow_renderer_rep::get_shadow "
         //         << rectangle(x1,y2,x2,y1) << LF;
         //  XCopyArea (dpy, win, shadow->win, gc, x1, y2, x2-x1, y1-y2, x1, y2);
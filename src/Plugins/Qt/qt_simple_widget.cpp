@@ -37,7 +37,8 @@ extern const QX11Info *qt_x11Info (const QPaintDevice *pd);
 
 
 qt_simple_widget_rep::qt_simple_widget_rep ()
-  : qt_widget_rep (simple_widget),  sequencer (0) {
+  : qt_widget_rep (simple_widget),  sequencer (0),
+    invalidated_all (true), zoom_factor (1.0) {
     assert(last_created_widget == nullptr);
     last_created_widget = this;
   //backingPixmap= headless_mode ? NULL : new QPixmap ();
@@ -163,7 +164,7 @@ qt_simple_widget_rep::send (slot s, blackbox val) {
 
   switch (s) {
     case SLOT_INVALIDATE:
-   /*{
+    {
       check_type<coord4>(val, s);
       coord4 p= open_box<coord4> (val);
       
@@ -184,11 +185,11 @@ qt_simple_widget_rep::send (slot s, blackbox val) {
       }
     }
       break;
-      */
+      
     case SLOT_INVALIDATE_ALL:
     {
-      //check_type_void (val, s);
-      //invalidate_all ();
+      check_type_void (val, s);
+      invalidate_all ();
     }
       break;
       
@@ -224,6 +225,7 @@ qt_simple_widget_rep::send (slot s, blackbox val) {
     {
       check_type<double> (val, s);
       double new_zoom = open_box<double> (val);
+      zoom_factor = new_zoom;
      // canvas()->tm_widget()->handle_set_zoom_factor (new_zoom); // todo : uncomment this
     }
       break;
@@ -419,6 +421,8 @@ qt_simple_widget_rep::invalidate_rect (int x1, int y1, int x2, int y2) {
 
 void
 qt_simple_widget_rep::invalidate_all () {
+  invalidated_all = true;
+  if (canvas() == nullptr) return;
   QSize sz = canvas()->surface().size();
   // QPoint pt = QAbstractScrollArea::viewport()->pos();
   //cout << "invalidate all " << LF;
@@ -496,26 +500,16 @@ qt_simple_widget_rep::repaint_invalid_regions (basic_renderer_rep *ren) {
       if (area (lub) < 1.2 * area (invalid_regions))
         invalid_regions= rectangles (lub);
 
-      coord2 pt_or = from_qpoint(backing_pos);
-      SI ox = -pt_or.x1;
-      SI oy = -pt_or.x2;
-      
       rectangles rects = invalid_regions;
       invalid_regions = rectangles();
       
       while (!is_nil (rects)) {
-        rectangle r = copy (rects->item);
         rectangle r0 = rects->item;
         QRect qr = QRect (r0->x1 / retina_factor, r0->y1 / retina_factor,
                           (r0->x2 - r0->x1) / retina_factor,
                           (r0->y2 - r0->y1) / retina_factor);
         //cout << "repainting " << r0 << "\n";
-        ren->set_origin (ox, oy);
-        ren->encode (r->x1, r->y1);
-        ren->encode (r->x2, r->y2);
-        ren->set_clipping (r->x1, r->y2, r->x2, r->y1);
-        handle_repaint (ren, r->x1, r->y2, r->x2, r->y1);
-        if (gui_interrupted ()) {
+        if (!repaint_rect (ren, backing_pos, r0->x1, r0->y1, r0->x2, r0->y2)) {
           //cout << "interrupted repainting of  " << r0 << "\n";
           //ren->set_pencil (green);
           //ren->line (r->x1, r->y1, r->x2, r->y2);
@@ -533,6 +527,29 @@ qt_simple_widget_rep::repaint_invalid_regions (basic_renderer_rep *ren) {
   // canvas()->surface()->repaint (qrgn);
 }
 
+/*
+ Repaints the rectangle (x1, y1)--(x2, y2), given in device pixels, of a
+ surface whose upper left corner lies at position pos in the document.
+ This is used both for the backing store above and for the tiles of
+ texmacs::DocumentWidget, which are positioned independently of the
+ current scroll origin. Returns false if the repaint has been interrupted.
+ */
+
+bool
+qt_simple_widget_rep::repaint_rect (basic_renderer_rep *ren, QPoint pos,
+                                    int x1, int y1, int x2, int y2) {
+  coord2 pt_or = from_qpoint (pos);
+  SI ox = -pt_or.x1;
+  SI oy = -pt_or.x2;
+  rectangle r = rectangle (x1, y1, x2, y2);
+  ren->set_origin (ox, oy);
+  ren->encode (r->x1, r->y1);
+  ren->encode (r->x2, r->y2);
+  ren->set_clipping (r->x1, r->y2, r->x2, r->y1);
+  handle_repaint (ren, r->x1, r->y2, r->x2, r->y1);
+  return !gui_interrupted ();
+}
+
 qt_simple_widget_rep *qt_simple_widget_rep::last_created_widget;
 hashset<pointer> qt_simple_widget_rep::all_widgets;
 
@@ -98,12 +98,16 @@ public:
   rectangles   invalid_regions;
   // QPixmap*     backingPixmap;
   QPoint       backing_pos;
+  bool         invalidated_all; // set by invalidate_all, cleared by the canvas
+  double       zoom_factor;
 
 
   void invalidate_rect (int x1, int y1, int x2, int y2);
   void invalidate_all ();
   bool is_invalid ();
   void repaint_invalid_regions (basic_renderer_rep *renderer);
+  bool repaint_rect (basic_renderer_rep *renderer, QPoint pos,
+                     int x1, int y1, int x2, int y2);
   // basic_renderer get_renderer();
   
   
@@ -495,6 +495,8 @@
   (serialize-texmacs tree_to_texmacs (string tree))
   (parse-texmacs-snippet texmacs_to_tree (tree string))
   (serialize-texmacs-snippet tree_to_texmacs (string tree))
+  (parse-texmacs-binary texmacs_binary_to_tree (tree string))
+  (serialize-texmacs-binary tree_to_texmacs_binary (string tree))
   (texmacs->stm tree_to_scheme (string tree))
   (stm->texmacs scheme_document_to_tree (tree string))
   (stm-snippet->texmacs scheme_to_tree (tree string))
@@ -640,6 +642,8 @@
   (tmdb-inspect-history inspect_history (void url string))
   (tmdb-get-completions get_completions (array_string url string))
   (tmdb-get-name-completions get_name_completions (array_string url string))
+  (tmdb-get-fuzzy-completions get_fuzzy_completions (array_string url string))
+  (tmdb-get-fuzzy-name-completions get_fuzzy_name_completions (array_string url string))
 
   ;; SQL interface
   (supports-sql? sqlite3_present (bool))
@@ -661,12 +665,14 @@
   ;; connections to extern systems
   (connection-start connection_start (string string string))
   (connection-status connection_status (int string string))
+  (connection-statistics connection_statistics (tree string string))
   (connection-write-string connection_write (void string string string))
   (connection-write connection_write (void string string content))
   (connection-cmd connection_cmd (tree string string string))
   (connection-eval connection_eval (tree string string content))
   (connection-interrupt connection_interrupt (void string string))
   (connection-stop connection_stop (void string string))
+  (set-plugin-grace-period set_plugin_grace_period (void int))
 
   ;; widgets
   (widget-printer printer_widget (widget command url))
@@ -755,6 +761,9 @@
   (buffer-import buffer_import (bool url url string))
   (buffer-load buffer_load (bool url))
   (buffer-export buffer_export (bool url url string))
+  (buffer-autosave buffer_autosave (bool url url string))
+  (buffer-autosave-cancel cancel_background_save (void url))
+  (buffer-autosave-failed? background_save_failed (bool url))
   (buffer-save buffer_save (bool url))
   (tree-import-loaded import_loaded_tree (tree string url string))
   (tree-import import_tree (tree url string))
@@ -333,6 +333,7 @@
   (cpp-nr-pages nr_pages (int))
   (print-to-file print_to_file (void url))
   (print-pages-to-file print_to_file (void url string string))
+  (print-part-to-file print_part_to_file (void url string string))
   (print print_buffer (void))
   (print-pages print_buffer (void string string))
   (print-snippet print_snippet (array_int url content bool))
@@ -5893,6 +5893,32 @@ tmg_serialize_texmacs_snippet (tmscm arg1) {
   return scheme().string_to_tmscm (out);
 }
 
+tmscm
+tmg_parse_texmacs_binary (tmscm arg1) {
+  TMSCM_ASSERT_STRING (arg1, TMSCM_ARG1, "parse-texmacs-binary");
+
+  string in1= arg1->to_string();
+
+  // TMSCM_DEFER_INTS;
+  tree out= texmacs_binary_to_tree (in1);
+  // TMSCM_ALLOW_INTS;
+
+  return tree_to_tmscm (out);
+}
+
+tmscm
+tmg_serialize_texmacs_binary (tmscm arg1) {
+  TMSCM_ASSERT_TREE (arg1, TMSCM_ARG1, "serialize-texmacs-binary");
+
+  tree in1= arg1->to_tree();
+
+  // TMSCM_DEFER_INTS;
+  string out= tree_to_texmacs_binary (in1);
+  // TMSCM_ALLOW_INTS;
+
+  return scheme().string_to_tmscm (out);
+}
+
 tmscm
 tmg_texmacs_2stm (tmscm arg1) {
   TMSCM_ASSERT_TREE (arg1, TMSCM_ARG1, "texmacs->stm");
@@ -7799,6 +7825,36 @@ tmg_tmdb_get_name_completions (tmscm arg1, tmscm arg2) {
   return array_string_to_tmscm (out);
 }
 
+tmscm
+tmg_tmdb_get_fuzzy_completions (tmscm arg1, tmscm arg2) {
+  TMSCM_ASSERT_URL (arg1, TMSCM_ARG1, "tmdb-get-fuzzy-completions");
+  TMSCM_ASSERT_STRING (arg2, TMSCM_ARG2, "tmdb-get-fuzzy-completions");
+
+  url in1= arg1->to_url();
+  string in2= arg2->to_string();
+
+  // TMSCM_DEFER_INTS;
+  array_string out= get_fuzzy_completions (in1, in2);
+  // TMSCM_ALLOW_INTS;
+
+  return array_string_to_tmscm (out);
+}
+
+tmscm
+tmg_tmdb_get_fuzzy_name_completions (tmscm arg1, tmscm arg2) {
+  TMSCM_ASSERT_URL (arg1, TMSCM_ARG1, "tmdb-get-fuzzy-name-completions");
+  TMSCM_ASSERT_STRING (arg2, TMSCM_ARG2, "tmdb-get-fuzzy-name-completions");
+
+  url in1= arg1->to_url();
+  string in2= arg2->to_string();
+
+  // TMSCM_DEFER_INTS;
+  array_string out= get_fuzzy_name_completions (in1, in2);
+  // TMSCM_ALLOW_INTS;
+
+  return array_string_to_tmscm (out);
+}
+
 tmscm
 tmg_supports_sqlP () {
   // TMSCM_DEFER_INTS;
@@ -7988,6 +8044,21 @@ tmg_connection_status (tmscm arg1, tmscm arg2) {
   return scheme().int_to_tmscm (out);
 }
 
+tmscm
+tmg_connection_statistics (tmscm arg1, tmscm arg2) {
+  TMSCM_ASSERT_STRING (arg1, TMSCM_ARG1, "connection-statistics");
+  TMSCM_ASSERT_STRING (arg2, TMSCM_ARG2, "connection-statistics");
+
+  string in1= arg1->to_string();
+  string in2= arg2->to_string();
+
+  // TMSCM_DEFER_INTS;
+  tree out= connection_statistics (in1, in2);
+  // TMSCM_ALLOW_INTS;
+
+  return tree_to_tmscm (out);
+}
+
 tmscm
 tmg_connection_write_string (tmscm arg1, tmscm arg2, tmscm arg3) {
   TMSCM_ASSERT_STRING (arg1, TMSCM_ARG1, "connection-write-string");
@@ -8086,6 +8157,19 @@ tmg_connection_stop (tmscm arg1, tmscm arg2) {
   return scheme().tmscm_unspefied();
 }
 
+tmscm
+tmg_set_plugin_grace_period (tmscm arg1) {
+  TMSCM_ASSERT_INT (arg1, TMSCM_ARG1, "set-plugin-grace-period");
+
+  int in1= arg1->to_int();
+
+  // TMSCM_DEFER_INTS;
+  set_plugin_grace_period (in1);
+  // TMSCM_ALLOW_INTS;
+
+  return scheme().tmscm_unspefied();
+}
+
 tmscm
 tmg_widget_printer (tmscm arg1, tmscm arg2) {
   TMSCM_ASSERT_COMMAND (arg1, TMSCM_ARG1, "widget-printer");
@@ -9248,6 +9332,49 @@ tmg_buffer_export (tmscm arg1, tmscm arg2, tmscm arg3) {
   return scheme().bool_to_tmscm (out);
 }
 
+tmscm
+tmg_buffer_autosave (tmscm arg1, tmscm arg2, tmscm arg3) {
+  TMSCM_ASSERT_URL (arg1, TMSCM_ARG1, "buffer-autosave");
+  TMSCM_ASSERT_URL (arg2, TMSCM_ARG2, "buffer-autosave");
+  TMSCM_ASSERT_STRING (arg3, TMSCM_ARG3, "buffer-autosave");
+
+  url in1= arg1->to_url();
+  url in2= arg2->to_url();
+  string in3= arg3->to_string();
+
+  // TMSCM_DEFER_INTS;
+  bool out= buffer_autosave (in1, in2, in3);
+  // TMSCM_ALLOW_INTS;
+
+  return scheme().bool_to_tmscm (out);
+}
+
+tmscm
+tmg_buffer_autosave_cancel (tmscm arg1) {
+  TMSCM_ASSERT_URL (arg1, TMSCM_ARG1, "buffer-autosave-cancel");
+
+  url in1= arg1->to_url();
+
+  // TMSCM_DEFER_INTS;
+  cancel_background_save (in1);
+  // TMSCM_ALLOW_INTS;
+
+  return scheme().tmscm_unspefied();
+}
+
+tmscm
+tmg_buffer_autosave_failedP (tmscm arg1) {
+  TMSCM_ASSERT_URL (arg1, TMSCM_ARG1, "buffer-autosave-failed?");
+
+  url in1= arg1->to_url();
+
+  // TMSCM_DEFER_INTS;
+  bool out= background_save_failed (in1);
+  // TMSCM_ALLOW_INTS;
+
+  return scheme().bool_to_tmscm (out);
+}
+
 tmscm
 tmg_buffer_save (tmscm arg1) {
   TMSCM_ASSERT_URL (arg1, TMSCM_ARG1, "buffer-save");
@@ -10576,6 +10703,8 @@ initialize_glue_basic () {
   tmscm_install_procedure ("serialize-texmacs",  tmg_serialize_texmacs, 1, 0, 0);
   tmscm_install_procedure ("parse-texmacs-snippet",  tmg_parse_texmacs_snippet, 1, 0, 0);
   tmscm_install_procedure ("serialize-texmacs-snippet",  tmg_serialize_texmacs_snippet, 1, 0, 0);
+  tmscm_install_procedure ("parse-texmacs-binary",  tmg_parse_texmacs_binary, 1, 0, 0);
+  tmscm_install_procedure ("serialize-texmacs-binary",  tmg_serialize_texmacs_binary, 1, 0, 0);
   tmscm_install_procedure ("texmacs->stm",  tmg_texmacs_2stm, 1, 0, 0);
   tmscm_install_procedure ("stm->texmacs",  tmg_stm_2texmacs, 1, 0, 0);
   tmscm_install_procedure ("stm-snippet->texmacs",  tmg_stm_snippet_2texmacs, 1, 0, 0);
@@ -10711,6 +10840,8 @@ initialize_glue_basic () {
   tmscm_install_procedure ("tmdb-inspect-history",  tmg_tmdb_inspect_history, 2, 0, 0);
   tmscm_install_procedure ("tmdb-get-completions",  tmg_tmdb_get_completions, 2, 0, 0);
   tmscm_install_procedure ("tmdb-get-name-completions",  tmg_tmdb_get_name_completions, 2, 0, 0);
+  tmscm_install_procedure ("tmdb-get-fuzzy-completions",  tmg_tmdb_get_fuzzy_completions, 2, 0, 0);
+  tmscm_install_procedure ("tmdb-get-fuzzy-name-completions",  tmg_tmdb_get_fuzzy_name_completions, 2, 0, 0);
   tmscm_install_procedure ("supports-sql?",  tmg_supports_sqlP, 0, 0, 0);
   tmscm_install_procedure ("sql-exec",  tmg_sql_exec, 2, 0, 0);
   tmscm_install_procedure ("sql-quote",  tmg_sql_quote, 1, 0, 0);
@@ -10726,12 +10857,14 @@ initialize_glue_basic () {
   tmscm_install_procedure ("enter-secure-mode",  tmg_enter_secure_mode, 1, 0, 0);
   tmscm_install_procedure ("connection-start",  tmg_connection_start, 2, 0, 0);
   tmscm_install_procedure ("connection-status",  tmg_connection_status, 2, 0, 0);
+  tmscm_install_procedure ("connection-statistics",  tmg_connection_statistics, 2, 0, 0);
   tmscm_install_procedure ("connection-write-string",  tmg_connection_write_string, 3, 0, 0);
   tmscm_install_procedure ("connection-write",  tmg_connection_write, 3, 0, 0);
   tmscm_install_procedure ("connection-cmd",  tmg_connection_cmd, 3, 0, 0);
   tmscm_install_procedure ("connection-eval",  tmg_connection_eval, 3, 0, 0);
   tmscm_install_procedure ("connection-interrupt",  tmg_connection_interrupt, 2, 0, 0);
   tmscm_install_procedure ("connection-stop",  tmg_connection_stop, 2, 0, 0);
+  tmscm_install_procedure ("set-plugin-grace-period",  tmg_set_plugin_grace_period, 1, 0, 0);
   tmscm_install_procedure ("widget-printer",  tmg_widget_printer, 2, 0, 0);
   tmscm_install_procedure ("widget-color-picker",  tmg_widget_color_picker, 3, 0, 0);
   tmscm_install_procedure ("widget-extend",  tmg_widget_extend, 2, 0, 0);
@@ -10812,6 +10945,9 @@ initialize_glue_basic () {
   tmscm_install_procedure ("buffer-import",  tmg_buffer_import, 3, 0, 0);
   tmscm_install_procedure ("buffer-load",  tmg_buffer_load, 1, 0, 0);
   tmscm_install_procedure ("buffer-export",  tmg_buffer_export, 3, 0, 0);
+  tmscm_install_procedure ("buffer-autosave",  tmg_buffer_autosave, 3, 0, 0);
+  tmscm_install_procedure ("buffer-autosave-cancel",  tmg_buffer_autosave_cancel, 1, 0, 0);
+  tmscm_install_procedure ("buffer-autosave-failed?",  tmg_buffer_autosave_failedP, 1, 0, 0);
   tmscm_install_procedure ("buffer-save",  tmg_buffer_save, 1, 0, 0);
   tmscm_install_procedure ("tree-import-loaded",  tmg_tree_import_loaded, 3, 0, 0);
   tmscm_install_procedure ("tree-import",  tmg_tree_import, 2, 0, 0);
@@ -3287,6 +3287,23 @@ tmg_print_pages_to_file (tmscm arg1, tmscm arg2, tmscm arg3) {
   return scheme().tmscm_unspefied();
 }
 
+tmscm
+tmg_print_part_to_file (tmscm arg1, tmscm arg2, tmscm arg3) {
+  TMSCM_ASSERT_URL (arg1, TMSCM_ARG1, "print-part-to-file");
+  TMSCM_ASSERT_STRING (arg2, TMSCM_ARG2, "print-part-to-file");
+  TMSCM_ASSERT_STRING (arg3, TMSCM_ARG3, "print-part-to-file");
+
+  url in1= arg1->to_url();
+  string in2= arg2->to_string();
+  string in3= arg3->to_string();
+
+  // TMSCM_DEFER_INTS;
+  get_current_editor()->print_part_to_file (in1, in2, in3);
+  // TMSCM_ALLOW_INTS;
+
+  return scheme().tmscm_unspefied();
+}
+
 tmscm
 tmg_print () {
   // TMSCM_DEFER_INTS;
@@ -3889,6 +3906,7 @@ initialize_glue_editor () {
   tmscm_install_procedure ("cpp-nr-pages",  tmg_cpp_nr_pages, 0, 0, 0);
   tmscm_install_procedure ("print-to-file",  tmg_print_to_file, 1, 0, 0);
   tmscm_install_procedure ("print-pages-to-file",  tmg_print_pages_to_file, 3, 0, 0);
+  tmscm_install_procedure ("print-part-to-file",  tmg_print_part_to_file, 3, 0, 0);
   tmscm_install_procedure ("print",  tmg_print, 0, 0, 0);
   tmscm_install_procedure ("print-pages",  tmg_print_pages, 2, 0, 0);
   tmscm_install_procedure ("print-snippet",  tmg_print_snippet, 3, 0, 0);
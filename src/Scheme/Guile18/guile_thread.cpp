@@ -61,11 +61,10 @@ void guile_log_function(const char *cmsg, int len) {
 void texmacs::guile_thread::run() {
 
     while (true) {
-        std::function<void()> f = *mQueue.getPopElement();
-        if (mQueue.isDestroyed()) {
+        std::function<void()> f;
+        if (!mQueue.pop(f)) {
             break;
         }
-        mQueue.notifyPop();
 
         mGuileNoThread.addToLaunchQueue(f, "guile_thread::run");
     }
@@ -100,8 +99,7 @@ void texmacs::guile_thread::addToLaunchQueue(std::function<void()> f, std::strin
         return;
     }
 
-    *mQueue.getPushElement() = f;
-    mQueue.notifyPush();
+    mQueue.push(f);
 }
 
 void* texmacs::guile_no_thread::c_guile_run_function(void *data) {
@@ -17,6 +17,7 @@
 #include <unordered_map>
 
 std::unique_ptr<texmacs::abstract_scheme> global_scheme;
+std::string global_scheme_name;
 
 void texmacs::abstract_scheme::protected_call (object cmd) {
 #ifdef USE_EXCEPTIONS
@@ -23,6 +23,7 @@ inline void initialize_scheme () {
 #if SINGLE_SCHEME_INSTANCE
 
 extern std::unique_ptr<texmacs::abstract_scheme> global_scheme;
+extern std::string global_scheme_name;
 
 inline texmacs::abstract_scheme &scheme() {
     return *global_scheme;
@@ -30,6 +31,7 @@ inline texmacs::abstract_scheme &scheme() {
 
 inline void use_scheme(std::string scheme_name) {
     global_scheme = std::unique_ptr<texmacs::abstract_scheme>(texmacs::make_scheme(scheme_name));
+    global_scheme_name = scheme_name;
 }
 
 inline tm_ostream& operator << (tm_ostream& out, object obj) {
@@ -0,0 +1,332 @@
+
+/******************************************************************************
+* MODULE     : memo_store.cpp
+* DESCRIPTION: persistent memorization of style evaluations
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "memo_store.hpp"
+#include "iterator.hpp"
+#include "analyze.hpp"
+#include "file.hpp"
+#include "convert.hpp"
+#include "hashset.hpp"
+#include "merge_sort.hpp"
+#include "modification.hpp"
+
+#define MEMO_MAX_ENTRIES 4096
+
+/******************************************************************************
+* Digests of the contents of trees and environments
+******************************************************************************/
+
+// 64 bit FNV-1a digests, computed in two independent ways
+struct memo_hash {
+  unsigned long long h1, h2;
+  inline memo_hash (): h1 (0xcbf29ce484222325ULL), h2 (0x84222325cbf29ce4ULL) {}
+  inline void feed (unsigned int x) {
+    h1= (h1 ^ x) * 0x100000001b3ULL;
+    h2= (h2 + x) * 0xff51afd7ed558ccdULL;
+    h2 ^= h2 >> 29;
+  }
+};
+
+static void
+digest (memo_hash& h, tree t) {
+  if (is_atomic (t)) {
+    int i, n= N(t->label);
+    h.feed (0xffffffff);
+    h.feed ((unsigned int) n);
+    for (i=0; i<n; i++)
+      h.feed ((unsigned char) t->label[i]);
+  }
+  else {
+    int i, n= N(t);
+    h.feed ((unsigned int) L(t));
+    h.feed ((unsigned int) n);
+    for (i=0; i<n; i++)
+      digest (h, t[i]);
+  }
+}
+
+static void
+digest (memo_hash& h, hashmap<string,tree> env) {
+  // The digest does not depend on the order of the entries
+  unsigned long long s1= 0, s2= 0;
+  iterator<string> it= iterate (env);
+  while (it->busy ()) {
+    string key= it->next ();
+    memo_hash e;
+    digest (e, tree (key));
+    digest (e, env [key]);
+    s1 += e.h1;
+    s2 += e.h2;
+  }
+  h.feed ((unsigned int) N(env));
+  h.feed ((unsigned int) s1); h.feed ((unsigned int) (s1 >> 32));
+  h.feed ((unsigned int) s2); h.feed ((unsigned int) (s2 >> 32));
+}
+
+static string
+as_string (memo_hash h) {
+  return as_hexadecimal ((int) (h.h1 >> 32), 8) *
+         as_hexadecimal ((int) h.h1, 8) *
+         as_hexadecimal ((int) (h.h2 >> 32), 8) *
+         as_hexadecimal ((int) h.h2, 8);
+}
+
+string
+memo_digest (tree t) {
+  memo_hash h;
+  digest (h, t);
+  return as_string (h);
+}
+
+string
+memo_digest (hashmap<string,tree> env) {
+  memo_hash h;
+  digest (h, env);
+  return as_string (h);
+}
+
+static string
+memo_tree_digest (tree t) {
+  // Trees of documents are only modified through the observers, which
+  // renew the modification stamp, so that the digest of the document
+  // remains valid as long as the stamp does not change
+  static tree   last_tree;
+  static int    last_stamp= -1;
+  static string last_digest;
+  bool attached= ip_attached (obtain_ip (t));
+  if (attached && strong_equal (t, last_tree) &&
+      last_stamp == modification_stamp)
+    return last_digest;
+  string d= memo_digest (t);
+  if (attached) {
+    last_tree  = t;
+    last_stamp = modification_stamp;
+    last_digest= d;
+  }
+  return d;
+}
+
+string
+memo_key (tree style, tree t, string state) {
+  memo_hash h;
+  digest (h, style);
+  digest (h, tree (memo_tree_digest (t)));
+  digest (h, tree (state));
+  return as_string (h);
+}
+
+/******************************************************************************
+* Dependencies of evaluations
+******************************************************************************/
+
+static tree
+memo_input (tree name, hashmap<string,tree> env,
+            hashmap<string,tree> lref, hashmap<string,tree> gref) {
+  // variables are identified by their names, references by (tuple key),
+  // or by (tuple key "local") when they are only looked up locally
+  if (is_atomic (name)) return env [name->label];
+  string key= name[0]->label;
+  if (N(name) == 2) return lref [key];
+  return lref->contains (key)? lref [key]: gref [key];
+}
+
+tree
+memo_dependencies (hashmap<string,bool> vars, hashmap<string,bool> refs,
+                   hashmap<string,bool> local_refs,
+                   hashmap<string,tree> env,
+                   hashmap<string,tree> lref, hashmap<string,tree> gref) {
+  tree deps (COLLECTION);
+  iterator<string> it= iterate (vars);
+  while (it->busy ()) {
+    tree name (it->next ());
+    deps << tree (ASSOCIATE, name,
+                  memo_digest (memo_input (name, env, lref, gref)));
+  }
+  it= iterate (refs);
+  while (it->busy ()) {
+    tree name (TUPLE, it->next ());
+    deps << tree (ASSOCIATE, name,
+                  memo_digest (memo_input (name, env, lref, gref)));
+  }
+  it= iterate (local_refs);
+  while (it->busy ()) {
+    tree name (TUPLE, it->next (), "local");
+    deps << tree (ASSOCIATE, name,
+                  memo_digest (memo_input (name, env, lref, gref)));
+  }
+  return deps;
+}
+
+static bool
+memo_valid (tree deps, hashmap<string,tree> env,
+            hashmap<string,tree> lref, hashmap<string,tree> gref) {
+  for (int i=0; i<N(deps); i++) {
+    tree val= memo_input (deps[i][0], env, lref, gref);
+    if (memo_digest (val) != deps[i][1]->label) return false;
+  }
+  return true;
+}
+
+static bool
+is_memo_entry (tree t) {
+  if (!is_func (t, ASSOCIATE, 2) || !is_atomic (t[0])) return false;
+  if (!is_func (t[1], TUPLE, 2) || L(t[1][1]) != COLLECTION) return false;
+  tree deps= t[1][1];
+  for (int i=0; i<N(deps); i++)
+    if (!is_func (deps[i], ASSOCIATE, 2) || !is_atomic (deps[i][1]) ||
+        !(is_atomic (deps[i][0]) ||
+          (is_func (deps[i][0], TUPLE, 1) && is_atomic (deps[i][0][0])) ||
+          (is_func (deps[i][0], TUPLE, 2) && is_atomic (deps[i][0][0]) &&
+           deps[i][0][1] == "local")))
+      return false;
+  return true;
+}
+
+/******************************************************************************
+* Storing the results on disk
+*******************************************************************************
+* The results are kept in memory and only written to disk in one batch by
+* memo_flush, when buffers are closed and when quitting.  Each entry has a
+* stamp which is renewed whenever it is used; when a store is full, the
+* least recently used quarter of its entries is discarded.  The entries
+* are written in the order of their stamps, so that this order survives
+* from one session to another.
+******************************************************************************/
+
+static hashmap<string,tree> memo_void (UNINIT);
+static hashmap<string,hashmap<string,tree> > memo_stores (memo_void);
+static hashmap<string,int> memo_stamps_void (0);
+static hashmap<string,hashmap<string,int> > memo_stamps (memo_stamps_void);
+static hashset<string> memo_dirty;
+static int memo_clock= 0;
+
+static url
+memo_dir () {
+  return url ("$TEXMACS_HOME_PATH/system/cache/memo");
+}
+
+static url
+memo_file (string sd) {
+  return memo_dir () * url (sd * ".scm");
+}
+
+static hashmap<string,tree>
+memo_load (string sd) {
+  if (!memo_stores->contains (sd)) {
+    hashmap<string,tree> h (UNINIT);
+    hashmap<string,int> st (0);
+    string s;
+    url name= memo_file (sd);
+    if (exists (name) && !load_string (name, s, false)) {
+      tree p= scheme_to_tree (s);
+      if (is_func (p, COLLECTION))
+        for (int i=0; i<N(p); i++)
+          if (is_memo_entry (p[i])) {
+            h (p[i][0]->label)= p[i][1];
+            st (p[i][0]->label)= ++memo_clock;
+          }
+    }
+    memo_stores (sd)= h;
+    memo_stamps (sd)= st;
+  }
+  return memo_stores [sd];
+}
+
+static void
+memo_evict (string sd) {
+  // discard the least recently used quarter of the entries
+  hashmap<string,tree> h= memo_stores [sd];
+  hashmap<string,int> st= memo_stamps [sd];
+  array<int> a;
+  iterator<string> it= iterate (st);
+  while (it->busy ()) a << st [it->next ()];
+  merge_sort (a);
+  int limit= a[N(a) / 4];
+  array<string> old;
+  it= iterate (st);
+  while (it->busy ()) {
+    string key= it->next ();
+    if (st [key] < limit) old << key;
+  }
+  for (int i=0; i<N(old); i++) {
+    h->reset (old[i]);
+    st->reset (old[i]);
+  }
+}
+
+static void
+memo_save (string sd) {
+  hashmap<string,tree> h= memo_stores [sd];
+  hashmap<string,int> st= memo_stamps [sd];
+  hashmap<int,string> keys ("");
+  array<int> a;
+  iterator<string> it= iterate (st);
+  while (it->busy ()) {
+    string key= it->next ();
+    keys (st [key])= key;
+    a << st [key];
+  }
+  merge_sort (a);
+  tree p (COLLECTION);
+  for (int i=0; i<N(a); i++)
+    p << tree (ASSOCIATE, keys [a[i]], h [keys [a[i]]]);
+  if (!exists (memo_dir ())) mkdir (memo_dir ());
+  save_string (memo_file (sd), tree_to_scheme (p));
+}
+
+bool
+memo_lookup (tree style, string key, hashmap<string,tree> env,
+             hashmap<string,tree> lref, hashmap<string,tree> gref, tree& r) {
+  string sd= memo_digest (style);
+  hashmap<string,tree> h= memo_load (sd);
+  if (!h->contains (key)) return false;
+  tree e= h [key];
+  if (!memo_valid (e[1], env, lref, gref)) return false;
+  memo_stamps [sd] (key)= ++memo_clock;
+  memo_dirty->insert (sd);
+  r= e[0];
+  return true;
+}
+
+void
+memo_remember (tree style, string key, tree r, tree deps) {
+  string sd= memo_digest (style);
+  hashmap<string,tree> h= memo_load (sd);
+  if (!h->contains (key) && N(h) >= MEMO_MAX_ENTRIES) memo_evict (sd);
+  h (key)= tuple (r, deps);
+  memo_stamps [sd] (key)= ++memo_clock;
+  memo_dirty->insert (sd);
+}
+
+void
+memo_flush () {
+  iterator<string> it= iterate (memo_dirty);
+  while (it->busy ()) {
+    string sd= it->next ();
+    if (memo_stores->contains (sd)) memo_save (sd);
+  }
+  memo_dirty= hashset<string> ();
+}
+
+void
+memo_unload () {
+  memo_flush ();
+  memo_stores= hashmap<string,hashmap<string,tree> > (memo_void);
+  memo_stamps= hashmap<string,hashmap<string,int> > (memo_stamps_void);
+}
+
+void
+memo_invalidate () {
+  memo_stores= hashmap<string,hashmap<string,tree> > (memo_void);
+  memo_stamps= hashmap<string,hashmap<string,int> > (memo_stamps_void);
+  memo_dirty= hashset<string> ();
+  remove (memo_dir () * url_wildcard ("*.scm"));
+}
@@ -0,0 +1,45 @@
+
+/******************************************************************************
+* MODULE     : memo_store.hpp
+* DESCRIPTION: persistent memorization of style evaluations
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#ifndef MEMO_STORE_H
+#define MEMO_STORE_H
+#include "tree.hpp"
+#include "hashmap.hpp"
+
+/******************************************************************************
+* Contrary to the memorizers, which identify trees and environments by
+* their addresses, the memo store identifies them by their contents, so
+* that the results of evaluations can be kept on disk from one session to
+* another. A result is found back using the style, the evaluated tree and
+* the state of the environment which is not kept in variables, such as the
+* font and the magnification. It is only valid if the environment variables
+* and references which were read during the evaluation still have the same
+* values. The results are stored per style in
+* $TEXMACS_HOME_PATH/system/cache/memo.
+******************************************************************************/
+
+string memo_digest (tree t);
+string memo_digest (hashmap<string,tree> h);
+string memo_key (tree style, tree t, string state);
+tree   memo_dependencies (hashmap<string,bool> vars, hashmap<string,bool> refs,
+                          hashmap<string,bool> local_refs,
+                          hashmap<string,tree> env,
+                          hashmap<string,tree> lref, hashmap<string,tree> gref);
+
+bool memo_lookup (tree style, string key, hashmap<string,tree> env,
+                  hashmap<string,tree> lref, hashmap<string,tree> gref,
+                  tree& r);
+void memo_remember (tree style, string key, tree r, tree deps);
+void memo_flush ();
+void memo_unload ();
+void memo_invalidate ();
+
+#endif // defined MEMO_STORE_H
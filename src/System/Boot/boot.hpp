@@ -20,6 +20,7 @@ extern int  install_status;
 extern bool use_which;
 extern bool use_locate;
 extern bool headless_mode;
+extern bool helper_mode;
 
 string get_setting (string var, string def= "");
 void   set_setting (string var, string val);
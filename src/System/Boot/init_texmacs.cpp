@@ -217,9 +217,13 @@ init_user_dirs () {
 * Boot locks
 ******************************************************************************/
 
+// helper processes run next to an interactive TeXmacs, which holds the lock
+bool helper_mode= false;
+
 static void
 acquire_boot_lock () {
   //cout << "Acquire lock\n";
+  if (helper_mode) return;
   url lock_file= "$TEXMACS_HOME_PATH/system/boot_lock";
   if (exists (lock_file)) {
     remove (url ("$TEXMACS_HOME_PATH/system/settings.scm"));
@@ -233,6 +237,7 @@ acquire_boot_lock () {
 void
 release_boot_lock () {
   //cout << "Release lock\n";
+  if (helper_mode) return;
   url lock_file= "$TEXMACS_HOME_PATH/system/boot_lock";
   remove (lock_file);
 }
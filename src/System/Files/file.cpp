@@ -186,6 +186,270 @@ append_string(url u, string s, bool fatal) {
     return err;
 }
 
+/******************************************************************************
+* Memory mapped files
+******************************************************************************/
+
+mapped_file_rep::mapped_file_rep (url u):
+  data (NULL), size (0), error (true), handle (NULL)
+{
+  url r= resolve (u);
+  if (is_none (r) || is_rooted_web (r) || is_rooted_tmfs (r)) {
+    error= load_string (u, buffer, false);
+    data = buffer.data ();
+    size = N(buffer);
+    return;
+  }
+  string name= concretize (r);
+  QFile* qfile= new QFile (QString::fromStdString (std::string (name.data (), N(name))));
+  if (qfile->open (QIODevice::ReadOnly)) {
+    qint64 n= qfile->size ();
+    uchar* p= (n > 0 && n < 0x7fffffff)? qfile->map (0, n): NULL;
+    if (p != NULL) {
+      handle= (void*) qfile;
+      data  = (const char*) p;
+      size  = (int) n;
+      error = false;
+      return;
+    }
+  }
+  delete qfile;
+  error= load_string (u, buffer, false);
+  data = buffer.data ();
+  size = N(buffer);
+}
+
+mapped_file_rep::mapped_file_rep (string s):
+  data (NULL), size (N(s)), error (false), handle (NULL), buffer (s)
+{
+  data= buffer.data ();
+}
+
+mapped_file_rep::~mapped_file_rep () {
+  if (handle != NULL) {
+    QFile* qfile= (QFile*) handle;
+    qfile->unmap ((uchar*) data);
+    delete qfile;
+  }
+}
+
+/******************************************************************************
+* Files which replace their destination once they are complete
+******************************************************************************/
+
+#include <QSaveFile>
+#include <thread>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <set>
+#include "Utils/ThreadSafeQueue.hpp"
+
+static void
+invalidate_cached_file (url r) {
+  string name= concretize (r);
+  cache_reset ("file_cache", name);
+  cache_reset ("doc_cache", name);
+  declare_out_of_date (url_parent (r));
+}
+
+file_writer_rep::file_writer_rep (url u2):
+  error (true), handle (NULL), u (u2)
+{
+  url r= u;
+  if (!is_rooted_name (r)) r= resolve (r, "");
+  if (!is_rooted_name (r)) return;
+  u= r;
+  string name= concretize (r);
+  QSaveFile* qfile= new QSaveFile (QString::fromStdString (std::string (name.data (), N(name))));
+  if (qfile->open (QIODevice::WriteOnly)) {
+    handle= (void*) qfile;
+    error = false;
+  }
+  else delete qfile;
+}
+
+file_writer_rep::~file_writer_rep () {
+  if (handle != NULL) {
+    QSaveFile* qfile= (QSaveFile*) handle;
+    qfile->cancelWriting ();
+    delete qfile;
+  }
+}
+
+void
+file_writer_rep::write (const char* s, int n) {
+  if (error || n == 0) return;
+  QSaveFile* qfile= (QSaveFile*) handle;
+  if (qfile->write (s, n) != n) error= true;
+}
+
+bool
+file_writer_rep::commit () {
+  if (handle == NULL) return true;
+  QSaveFile* qfile= (QSaveFile*) handle;
+  if (error) qfile->cancelWriting ();
+  else error= !qfile->commit ();
+  delete qfile;
+  handle= NULL;
+  if (!error) invalidate_cached_file (u);
+  return error;
+}
+
+struct background_save {
+  std::string name;  // the concrete file name
+  std::string data;  // the contents
+  std::function<string ()> produce; // the contents, if not yet known
+  long        nr;    // the number of the job
+};
+
+struct background_state {
+  std::mutex lock;
+  std::condition_variable done;           // notified when a job is finished
+  long counter= 0;                        // number of the last job
+  std::map<std::string,int>  pending;     // unfinished jobs for each file
+  std::map<std::string,long> cancelled;   // jobs up to this number are skipped
+  std::set<std::string>      failed;      // files whose last write failed
+};
+
+static texmacs::thread_safe_queue<background_save*, 16>&
+background_jobs () {
+  // never destroyed, since the saving thread may still wait for jobs
+  static auto* jobs= new texmacs::thread_safe_queue<background_save*, 16> ();
+  return *jobs;
+}
+
+static background_state&
+background_status () {
+  static auto* st= new background_state ();
+  return *st;
+}
+
+static void
+background_saver () {
+  background_state& st= background_status ();
+  background_save* job;
+  while (background_jobs ().pop (job)) {
+    bool skip;
+    {
+      std::lock_guard<std::mutex> guard (st.lock);
+      auto it= st.cancelled.find (job->name);
+      skip= it != st.cancelled.end () && job->nr <= it->second;
+    }
+    bool ok= true;
+    if (!skip) {
+      if (job->produce) {
+        string s= job->produce ();
+        job->data.assign (s.data (), N(s));
+      }
+      QSaveFile qfile (QString::fromStdString (job->name));
+      qint64 n= (qint64) job->data.size ();
+      ok= qfile.open (QIODevice::WriteOnly) &&
+          qfile.write (job->data.data (), n) == n &&
+          qfile.commit ();
+      if (!ok) qWarning () << "Background save failed for"
+                           << QString::fromStdString (job->name);
+    }
+    {
+      std::lock_guard<std::mutex> guard (st.lock);
+      if (!skip) {
+        if (ok) st.failed.erase (job->name);
+        else st.failed.insert (job->name);
+      }
+      if (--st.pending[job->name] == 0) st.pending.erase (job->name);
+      st.done.notify_all ();
+    }
+    delete job;
+  }
+}
+
+static bool
+background_name (url u, string& name) {
+  // Only plain local files are written in the background; urls and strings
+  // are not shared with the saving thread, since they are not thread safe
+  url r= u;
+  if (!is_rooted_name (r)) r= resolve (r, "");
+  if (is_rooted_tmfs (u) || !is_rooted_name (r)) return false;
+  name= concretize (r);
+  return true;
+}
+
+static void
+push_background_save (string name, background_save* job) {
+  job->name= std::string (name.data (), N(name));
+  background_state& st= background_status ();
+  {
+    std::lock_guard<std::mutex> guard (st.lock);
+    job->nr= ++st.counter;
+    st.pending[job->name]++;
+  }
+  static std::once_flag started;
+  std::call_once (started, [] () { std::thread (background_saver).detach (); });
+  background_jobs ().push (job);
+}
+
+void
+save_string_in_background (url u, string s) {
+  string name;
+  if (!background_name (u, name)) {
+    (void) save_string (u, s, false);
+    return;
+  }
+  background_save* job= new background_save ();
+  job->data= std::string (s.data (), N(s));
+  invalidate_cached_file (url_system (name));
+  if (N(s) <= 10000 && (do_cache_file (name) || do_cache_doc (name)))
+    cache_set (do_cache_doc (name)? "doc_cache": "file_cache", name, s);
+  push_background_save (name, job);
+}
+
+void
+save_string_in_background (url u, std::function<string ()> produce) {
+  // produce is run in the saving thread, so that it must not share any
+  // strings or trees with the other threads; it is destroyed there too
+  string name;
+  if (!background_name (u, name)) {
+    (void) save_string (u, produce (), false);
+    return;
+  }
+  background_save* job= new background_save ();
+  job->produce.swap (produce);
+  invalidate_cached_file (url_system (name));
+  push_background_save (name, job);
+}
+
+void
+cancel_background_save (url u) {
+  // skip the writes to u which are still queued and wait for the one which
+  // may be in progress, so that u can be removed or written synchronously
+  string name;
+  if (!background_name (u, name)) return;
+  std::string key (name.data (), N(name));
+  background_state& st= background_status ();
+  std::unique_lock<std::mutex> lock (st.lock);
+  st.cancelled[key]= st.counter;
+  st.done.wait (lock, [&st, &key] () { return st.pending.count (key) == 0; });
+  st.cancelled.erase (key);
+  st.failed.erase (key);
+}
+
+bool
+background_save_failed (url u) {
+  string name;
+  if (!background_name (u, name)) return false;
+  background_state& st= background_status ();
+  std::lock_guard<std::mutex> guard (st.lock);
+  return st.failed.count (std::string (name.data (), N(name))) != 0;
+}
+
+void
+finish_background_saves () {
+  background_state& st= background_status ();
+  std::unique_lock<std::mutex> lock (st.lock);
+  st.done.wait (lock, [&st] () { return st.pending.empty (); });
+}
+
 /******************************************************************************
 * Getting attributes of a file
 ******************************************************************************/
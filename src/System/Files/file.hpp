@@ -14,6 +14,7 @@
 #include "url.hpp"
 #include "sys_utils.hpp"
 #include "analyze.hpp"
+#include <functional>
 
 /**
  * Load the url to a string, and return a boolean indicator
@@ -25,6 +26,72 @@ bool load_string (url file_name, string& s, bool fatal);
 bool save_string (url file_name, string s, bool fatal=false);
 bool append_string (url u, string s, bool fatal= false);
 
+/******************************************************************************
+* Read only memory mapped files. The data remain valid as long as the
+* mapped_file is alive. When the file cannot be mapped, its contents
+* are loaded into memory instead. A mapped_file can also be constructed
+* from a string, in order to share the code which reads from it.
+******************************************************************************/
+
+class mapped_file_rep: concrete_struct {
+public:
+  const char* data;
+  int         size;
+  bool        error;
+private:
+  void*       handle;  // the underlying QFile, if mapped
+  string      buffer;  // the contents, if not mapped
+
+public:
+  mapped_file_rep (url u);
+  mapped_file_rep (string s);
+  ~mapped_file_rep ();
+  friend class mapped_file;
+};
+
+class mapped_file {
+  CONCRETE(mapped_file);
+  inline mapped_file (url u): rep (tm_new<mapped_file_rep> (u)) {}
+  inline mapped_file (string s): rep (tm_new<mapped_file_rep> (s)) {}
+};
+CONCRETE_CODE(mapped_file);
+
+/******************************************************************************
+* Files which are written piece by piece. The destination is only replaced
+* by the new contents when the file_writer is committed, so that it is never
+* left incomplete. Saving in the background copies the string and writes
+* it from another thread, again replacing the destination at once. Queued
+* writes to a file can be cancelled before removing it, and all of them
+* are finished before quitting.
+******************************************************************************/
+
+class file_writer_rep: concrete_struct {
+public:
+  bool        error;
+private:
+  void*       handle;  // the underlying QSaveFile
+  url         u;       // the destination
+
+public:
+  file_writer_rep (url u);
+  ~file_writer_rep ();
+  void write (const char* s, int n);
+  bool commit ();
+  friend class file_writer;
+};
+
+class file_writer {
+  CONCRETE(file_writer);
+  inline file_writer (url u): rep (tm_new<file_writer_rep> (u)) {}
+};
+CONCRETE_CODE(file_writer);
+
+void save_string_in_background (url u, string s);
+void save_string_in_background (url u, std::function<string ()> produce);
+void cancel_background_save (url u);
+bool background_save_failed (url u);
+void finish_background_saves ();
+
 bool is_of_type (url name, string filter);
 bool is_regular (url name);
 bool is_directory (url name);
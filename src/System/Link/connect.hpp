@@ -24,6 +24,7 @@ void   connection_interrupt (string name, string session);
 void   connection_stop (string name, string session);
 void   connection_stop_all ();
 int    connection_status (string name, string session);
+tree   connection_statistics (string name, string session);
 tree   connection_eval (string name, string session, string s);
 tree   connection_eval (string name, string session, tree t);
 tree   connection_cmd (string name, string session, string s);
@@ -17,6 +17,7 @@
 ******************************************************************************/
 
 #include "connect.hpp"
+#include "process_supervisor.hpp"
 #include "socket_notifier.hpp"
 #include "iterator.hpp"
 #include "convert.hpp"
@@ -108,18 +109,14 @@ void
 connection_rep::read (int channel) {
   if (channel == LINK_OUT) {
     string s= ln->read (LINK_OUT);
-    int i, n= N(s);
-    for (i=0; i<n; i++)
-      if (tm_in->put (s[i])) {
-        status= WAITING_FOR_INPUT;
-        if (DEBUG_IO) debug_io << LF << HRULE;
-      }
+    if (tm_in->put (s)) {
+      status= WAITING_FOR_INPUT;
+      if (DEBUG_IO) debug_io << LF << HRULE;
+    }
   }
   else if (channel == LINK_ERR) {
     string s= ln->read (LINK_ERR);
-    int i, n= N(s);
-    for (i=0; i<n; i++)
-      (void) tm_err->put (s[i]);
+    (void) tm_err->put (s);
   }
   if (!ln->alive) {
     tm_in ->eof ();
@@ -313,6 +310,14 @@ connection_status (string name, string session) {
   return con->status;
 }
 
+tree
+connection_statistics (string name, string session) {
+  // the cpu time and memory used by the plugin process of the session
+  connection con= connection (name * "-" * session);
+  if (is_nil (con)) return tree (TUPLE);
+  return process_statistics (con->ln->process_id ());
+}
+
 /******************************************************************************
 * Evaluation interface (using a specific connection)
 ******************************************************************************/
@@ -0,0 +1,151 @@
+
+/******************************************************************************
+* MODULE     : link_reader.cpp
+* DESCRIPTION: Event driven reading of data from pipes and sockets
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* Output of plugins is read in large chunks from non blocking descriptors,
+* until the kernel has nothing more to offer.  The chunks are appended
+* directly to the pending output of the link.  When this pending output
+* exceeds LINK_MAX_PENDING, reading stops, so that a plugin which produces
+* output faster than TeXmacs can handle it blocks on its next write.
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "link_reader.hpp"
+
+#ifndef OS_MINGW
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+/******************************************************************************
+* Reading and writing
+******************************************************************************/
+
+bool
+link_set_nonblocking (int fd) {
+  int flags= fcntl (fd, F_GETFL, 0);
+  if (flags == -1) return false;
+  return fcntl (fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+bool
+link_wait_writable (int fd, int msecs) {
+  struct pollfd pfd;
+  pfd.fd     = fd;
+  pfd.events = POLLOUT;
+  pfd.revents= 0;
+  int nr= poll (&pfd, 1, msecs);
+  return nr > 0 && (pfd.revents & POLLOUT) != 0;
+}
+
+int
+link_read_available (int fd, string& buf, bool is_socket) {
+  static char chunk[LINK_CHUNK_SIZE];
+  while (N(buf) < LINK_MAX_PENDING) {
+    int r= (is_socket?
+            (int) recv (fd, chunk, LINK_CHUNK_SIZE, 0):
+            (int) ::read (fd, chunk, LINK_CHUNK_SIZE));
+    if (r > 0) {
+      int n= N(buf);
+      buf->resize (n + r);
+      memcpy (&buf[n], chunk, r);
+      // a short read means that the kernel buffer has been emptied
+      if (r < LINK_CHUNK_SIZE) return LINK_READ_AGAIN;
+    }
+    else if (r == 0) return LINK_READ_EOF;
+    else if (errno == EINTR) continue;
+    else if (errno == EAGAIN || errno == EWOULDBLOCK) return LINK_READ_AGAIN;
+    else return LINK_READ_ERROR;
+  }
+  return LINK_READ_FULL;
+}
+
+/******************************************************************************
+* Polling
+******************************************************************************/
+
+link_poller::link_poller (): rep (tm_new<link_poller_rep> ()) {}
+
+link_poller_rep::link_poller_rep (): epfd (-1) {
+#ifdef __linux__
+  epfd= epoll_create1 (EPOLL_CLOEXEC);
+#endif
+}
+
+link_poller_rep::~link_poller_rep () {
+  if (epfd != -1) close (epfd);
+}
+
+void
+link_poller_rep::add (int fd) {
+  fds << fd;
+#ifdef __linux__
+  if (epfd == -1) return;
+  struct epoll_event ev;
+  memset (&ev, 0, sizeof (ev));
+  ev.events = EPOLLIN;
+  ev.data.fd= fd;
+  if (epoll_ctl (epfd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+    // descriptors like regular files cannot be watched using epoll
+    close (epfd);
+    epfd= -1;
+  }
+#endif
+}
+
+void
+link_poller_rep::remove (int fd) {
+  array<int> r;
+  for (int i=0; i<N(fds); i++)
+    if (fds[i] != fd) r << fds[i];
+  fds= r;
+#ifdef __linux__
+  if (epfd != -1) {
+    struct epoll_event ev;
+    memset (&ev, 0, sizeof (ev));
+    (void) epoll_ctl (epfd, EPOLL_CTL_DEL, fd, &ev);
+  }
+#endif
+}
+
+int
+link_poller_rep::wait (int msecs) {
+  ready= array<int> ();
+  if (N(fds) == 0) return 0;
+#ifdef __linux__
+  if (epfd != -1) {
+    struct epoll_event evs[16];
+    int nr= epoll_wait (epfd, evs, 16, msecs);
+    for (int i=0; i<nr; i++)
+      // hang ups and errors are reported by the subsequent read
+      ready << evs[i].data.fd;
+    return N(ready);
+  }
+#endif
+  int n= N(fds);
+  STACK_NEW_ARRAY (pfds, struct pollfd, n);
+  for (int i=0; i<n; i++) {
+    pfds[i].fd     = fds[i];
+    pfds[i].events = POLLIN;
+    pfds[i].revents= 0;
+  }
+  int nr= poll (pfds, n, msecs);
+  for (int i=0; i<n && nr>0; i++)
+    if (pfds[i].revents != 0) ready << pfds[i].fd;
+  STACK_DELETE_ARRAY (pfds);
+  return N(ready);
+}
+
+#endif // !defined OS_MINGW
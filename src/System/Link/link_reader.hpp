@@ -0,0 +1,52 @@
+
+/******************************************************************************
+* MODULE     : link_reader.hpp
+* DESCRIPTION: Event driven reading of data from pipes and sockets
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#ifndef LINK_READER_H
+#define LINK_READER_H
+#include "string.hpp"
+#include "array.hpp"
+
+#define LINK_CHUNK_SIZE   65536      // size of a single read
+#define LINK_MAX_PENDING  (1 << 24)  // stop reading beyond this much output
+
+#define LINK_READ_AGAIN   0          // no more data for the moment
+#define LINK_READ_FULL    1          // the pending output is too large
+#define LINK_READ_EOF     2          // the other end has been closed
+#define LINK_READ_ERROR   3          // reading failed
+
+bool link_set_nonblocking (int fd);
+bool link_wait_writable (int fd, int msecs);
+int  link_read_available (int fd, string& buf, bool is_socket= false);
+
+/******************************************************************************
+* Waiting for several file descriptors at once
+******************************************************************************/
+
+class link_poller;
+struct link_poller_rep: concrete_struct {
+  int        epfd;   // epoll instance or -1 when falling back to poll
+  array<int> fds;    // the watched file descriptors
+  array<int> ready;  // the readable descriptors after the last wait
+
+  link_poller_rep ();
+  ~link_poller_rep ();
+  void add (int fd);
+  void remove (int fd);
+  int  wait (int msecs);
+};
+
+class link_poller {
+  CONCRETE(link_poller);
+  link_poller ();
+};
+CONCRETE_CODE(link_poller);
+
+#endif // defined LINK_READER_H
@@ -15,6 +15,8 @@
 
 #include "tm_link.hpp"
 #include "socket_notifier.hpp"
+#include "link_reader.hpp"
+#include "process_supervisor.hpp"
 #include "sys_utils.hpp"
 #include "hashset.hpp"
 #include "iterator.hpp"
@@ -61,8 +63,10 @@ struct pipe_link_rep: tm_link_rep {
 
   string outbuf;        // pending output from plugin
   string errbuf;        // pending errors from plugin
+  bool   throttled;     // reading suspended until the output is consumed
 
   socket_notifier snout, snerr;
+  link_poller     poller;
   
 public:
   pipe_link_rep (string cmd);
@@ -75,18 +79,22 @@ public:
   void    listen (int msecs);
   void    interrupt ();
   void    stop ();
+  int     process_id ();
 
-  void    feed (int channel);
+  bool    feed (int channel);
+  void    throttle (bool flag);
 };
 
 pipe_link_rep::pipe_link_rep (string cmd2): cmd (cmd2) {
   pipe_link_set->insert ((pointer) this);
+  pid    = -1;
   in     = pp_in [0]= pp_in [1]= -1;
   out    = pp_out[0]= pp_out[1]= -1;
   err    = pp_err[0]= pp_err[1]= -1;
   outbuf = "";
   errbuf = "";
   alive  = false;
+  throttled= false;
 }
 
 pipe_link_rep::~pipe_link_rep () {
@@ -102,17 +110,16 @@ make_pipe_link (string cmd) {
 void
 close_all_pipes () {
 #ifndef OS_MINGW
+  // all sessions share a single grace period
   iterator<pointer> it= iterate (pipe_link_set);
   while (it->busy()) {
     pipe_link_rep* con= (pipe_link_rep*) it->next();
     if (con->alive) {
-      if (-1 != killpg(con->pid,SIGTERM)) {
-sleep(2);
-        killpg(con->pid,SIGKILL);
-      }
+      terminate_process (con->pid, true, get_plugin_grace_period ());
       con->alive= false;
     }
   }
+  finish_processes (get_plugin_grace_period ());
 #endif
 }
 
@@ -177,6 +184,12 @@ pipe_link_rep::start () {
     close (pp_err [OUT]);
 
     alive= true;
+    throttled= false;
+    link_set_nonblocking (out);
+    link_set_nonblocking (err);
+    poller= link_poller ();
+    poller->add (out);
+    poller->add (err);
     snout = socket_notifier (out, &pipe_callback, this, NULL);
     snerr = socket_notifier (err, &pipe_callback, this, NULL);
     add_notifier (snout);
@@ -189,11 +202,7 @@ pipe_link_rep::start () {
       r= ::read (out, outbuf, 1024);
       if (r == 1 && outbuf[0] == TERMCHAR) return "ok";
       alive= false;
-      if (-1 != killpg(pid,SIGTERM)) {
-        sleep(2);
-        killpg(pid,SIGKILL);
-      }
-      wait (NULL);
+      terminate_process (pid, true, get_plugin_grace_period ());
       if (r == -1) return "Error: the application does not reply";
       else
         return "Error: the application did not send its usual startup banner";
@@ -233,34 +242,44 @@ pipe_link_rep::write (string s, int channel) {
 #endif
 }
 
-void
+bool
 pipe_link_rep::feed (int channel) {
+  // returns true when new data arrived or when the link died
 #ifndef OS_MINGW
-  if ((!alive) || ((channel != LINK_OUT) && (channel != LINK_ERR))) return;
-  int r;
-  char tempout[1024];
-  if (channel == LINK_OUT) r = ::read (out, tempout, 1024);
-  else r = ::read (err, tempout, 1024);
-  if (r == -1) {
-    io_error << "Read failed for '" << cmd << "'\n";
-    wait (NULL);
-  }
-  else if (r == 0) {
-    if (-1 != killpg(pid,SIGTERM)) {
-      sleep(2);
-      killpg(pid,SIGKILL);
-    }
-
+  if ((!alive) || ((channel != LINK_OUT) && (channel != LINK_ERR)))
+    return false;
+  string& buf= (channel == LINK_OUT? outbuf: errbuf);
+  int n= N(buf);
+  int r= link_read_available (channel == LINK_OUT? out: err, buf);
+  if (DEBUG_IO && N(buf) > n) debug_io << debug_io_string (buf (n, N(buf)));
+  if (r == LINK_READ_ERROR || r == LINK_READ_EOF) {
+    if (r == LINK_READ_ERROR) io_error << "Read failed for '" << cmd << "'\n";
+    terminate_process (pid, true, get_plugin_grace_period ());
     alive= false;
     remove_notifier (snout);      
     remove_notifier (snerr);      
+    return true;
+  }
+  else if (r == LINK_READ_FULL) throttle (true);
+  return N(buf) > n;
+#else
+  return false;
+#endif
+}
+
+void
+pipe_link_rep::throttle (bool flag) {
+  // while throttled, the plugin blocks as soon as the pipe is full
+  if (flag == throttled || !alive) return;
+  throttled= flag;
+  if (flag) {
+    remove_notifier (snout);
+    remove_notifier (snerr);
   }
   else {
-    if (DEBUG_IO) debug_io << debug_io_string (string (tempout, r));
-    if (channel == LINK_OUT) outbuf << string (tempout, r);
-    else errbuf << string (tempout, r);
+    add_notifier (snout);
+    add_notifier (snerr);
   }
-#endif
 }
 
 string&
@@ -273,36 +292,33 @@ pipe_link_rep::watch (int channel) {
 
 string
 pipe_link_rep::read (int channel) {
+  string r;
   if (channel == LINK_OUT) {
-    string r= outbuf;
+    r= outbuf;
     outbuf= "";
-    return r;
   }
   else if (channel == LINK_ERR) {
-    string r= errbuf;
+    r= errbuf;
     errbuf= "";
-    return r;
   }
-  else return string("");
+  if (throttled && N(outbuf) < LINK_MAX_PENDING && N(errbuf) < LINK_MAX_PENDING)
+    throttle (false);
+  return r;
 }
 
 void
 pipe_link_rep::listen (int msecs) {
   if (!alive) return;
+#ifndef OS_MINGW
   time_t wait_until= texmacs_time () + msecs;
   while ((outbuf == "") && (errbuf == "")) {
-    fd_set rfds;
-    FD_ZERO (&rfds);
-    FD_SET (out, &rfds);
-    FD_SET (err, &rfds);
-    struct timeval tv;
-    tv.tv_sec  = msecs / 1000;
-    tv.tv_usec = 1000 * (msecs % 1000);
-    int nr= select (max (out, err) + 1, &rfds, NULL, NULL, &tv);
-    if (nr != 0 && FD_ISSET (out, &rfds)) feed (LINK_OUT);
-    if (nr != 0 && FD_ISSET (err, &rfds)) feed (LINK_ERR);
-    if (texmacs_time () - wait_until > 0) break;
+    int left= std::max ((int) (wait_until - texmacs_time ()), 0);
+    int nr= poller->wait (left);
+    for (int i=0; i<nr && alive; i++)
+      feed (poller->ready[i] == out? LINK_OUT: LINK_ERR);
+    if (!alive || texmacs_time () - wait_until >= 0) break;
   }
+#endif
 }
 
 void
@@ -317,20 +333,20 @@ void
 pipe_link_rep::stop () {
 #ifndef OS_MINGW
   if (!alive) return;
-  if (-1 != killpg(pid,SIGTERM)) {
-    sleep(2);
-    killpg(pid,SIGKILL);
-  }
-  alive= false;    
+  terminate_process (pid, true, get_plugin_grace_period ());
   close (in);
   alive= false;
-  wait (NULL);
 
   remove_notifier (snout);
   remove_notifier (snerr);
 #endif
 }
 
+int
+pipe_link_rep::process_id () {
+  return pid;
+}
+
 /******************************************************************************
 * Call back for new information on pipe
 ******************************************************************************/
@@ -341,29 +357,13 @@ void pipe_callback (void *obj, void *info) {
   pipe_link_rep* con= (pipe_link_rep*) obj;  
   bool busy= true;
   bool news= false;
-  while (busy) {
-    fd_set rfds;
-    FD_ZERO (&rfds);
-    int max_fd= max (con->err, con->out) + 1;
-    FD_SET (con->out, &rfds);
-    FD_SET (con->err, &rfds);
-  
-    struct timeval tv;
-    tv.tv_sec  = 0;
-    tv.tv_usec = 0;
-    select (max_fd, &rfds, NULL, NULL, &tv);
-
+  while (busy && con->alive && !con->throttled) {
+    // each feed drains its descriptor, so this rarely takes two rounds
+    int nr= con->poller->wait (0);
     busy= false;
-    if (con->alive && FD_ISSET (con->out, &rfds)) {
-      //cout << "pipe_callback OUT" << LF;
-      con->feed (LINK_OUT);
-      busy= news= true;
-    }
-    if (con->alive && FD_ISSET (con->err, &rfds)) {
-      //cout << "pipe_callback ERR" << LF;
-      con->feed (LINK_ERR);
-      busy= news= true;
-    }
+    for (int i=0; i<nr && con->alive; i++)
+      if (con->feed (con->poller->ready[i] == con->out? LINK_OUT: LINK_ERR))
+        busy= news= true;
   }
   /* FIXME: find out the appropriate place to call the callback
      Currently, the callback is called in tm_server_rep::interpose_handler */
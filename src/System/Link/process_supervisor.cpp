@@ -0,0 +1,302 @@
+
+/******************************************************************************
+* MODULE     : process_supervisor.cpp
+* DESCRIPTION: Background termination and reaping of plugin processes
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* Plugin processes which should stop receive SIGTERM at once.  A background
+* thread then waits for them to exit, using a pidfd on Linux and polling
+* otherwise, reaps them and sends SIGKILL to those which are still alive
+* after their grace period.  The resource usage of the reaped processes is
+* kept for the statistics of their sessions.  Since Qt reaps the children
+* it started itself, the supervisor only waits for the processes which were
+* handed to it, and never uses a SIGCHLD handler or waits for any child.
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "process_supervisor.hpp"
+#include "tm_link.hpp"
+
+static int plugin_grace_period= PROCESS_GRACE_PERIOD;
+
+void
+set_plugin_grace_period (int msecs) {
+  plugin_grace_period= std::max (msecs, 0);
+}
+
+int
+get_plugin_grace_period () {
+  return plugin_grace_period;
+}
+
+tree
+process_statistics (int pid) {
+  process_stats st;
+  if (!get_process_stats (pid, st)) return tree (TUPLE);
+  return tree (TUPLE, st.running? "running": "finished",
+               as_string (st.cpu), as_string (st.memory));
+}
+
+#ifndef OS_MINGW
+
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <condition_variable>
+
+#define SUPERVISOR_POLL     50   // delay between two checks without pidfd
+#define SUPERVISOR_HISTORY  64   // number of finished processes remembered
+
+typedef std::chrono::steady_clock supervisor_clock;
+
+struct supervised_process {
+  int  pid;      // the supervised process
+  int  pidfd;    // becomes readable when the process exits, or -1
+  bool group;    // also kill the other processes in its group
+  bool reaped;   // the process itself has been reaped
+  bool killed;   // SIGKILL has been sent
+  supervisor_clock::time_point deadline;  // when to send SIGKILL
+};
+
+struct finished_process {
+  int           pid;
+  process_stats st;
+};
+
+struct supervisor_state {
+  std::mutex lock;
+  std::condition_variable idle;           // notified when all processes left
+  std::vector<supervised_process> jobs;
+  std::vector<finished_process> history;
+  int wake[2];                            // pipe for waking up the thread
+};
+
+static supervisor_state*
+make_supervisor () {
+  supervisor_state* s= new supervisor_state ();
+  if (pipe (s->wake) == 0)
+    for (int i=0; i<2; i++) {
+      fcntl (s->wake[i], F_SETFL, fcntl (s->wake[i], F_GETFL) | O_NONBLOCK);
+      fcntl (s->wake[i], F_SETFD, FD_CLOEXEC);
+    }
+  else s->wake[0]= s->wake[1]= -1;
+  return s;
+}
+
+static supervisor_state&
+supervisor () {
+  // never destroyed, since the supervising thread may outlive exit ()
+  static supervisor_state* s= make_supervisor ();
+  return *s;
+}
+
+/******************************************************************************
+* The supervising thread
+******************************************************************************/
+
+static void
+kill_supervised (supervised_process& p) {
+  if (p.group && (!p.reaped || killpg (p.pid, 0) == 0)) killpg (p.pid, SIGKILL);
+  else if (!p.reaped) kill (p.pid, SIGKILL);
+  p.killed= true;
+}
+
+static void
+reap_supervised (supervisor_state& s, supervised_process& p) {
+  int status;
+  struct rusage ru;
+  int r= wait4 (p.pid, &status, WNOHANG, &ru);
+  if (r == 0 || (r == -1 && errno != ECHILD)) return;
+  p.reaped= true;
+  finished_process f;
+  f.pid       = p.pid;
+  f.st.running= false;
+  f.st.cpu    = f.st.memory= 0.0;
+  if (r == p.pid) {
+    f.st.cpu= ru.ru_utime.tv_sec + ru.ru_stime.tv_sec +
+              (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000000.0;
+#ifdef __APPLE__
+    f.st.memory= ru.ru_maxrss / 1024.0;
+#else
+    f.st.memory= (double) ru.ru_maxrss;
+#endif
+  }
+  if (s.history.size () >= SUPERVISOR_HISTORY)
+    s.history.erase (s.history.begin ());
+  s.history.push_back (f);
+}
+
+static int
+update_supervised (supervisor_state& s) {
+  // returns the delay in milliseconds until the next necessary check
+  int timeout= -1;
+  auto now= supervisor_clock::now ();
+  for (size_t i=0; i<s.jobs.size (); ) {
+    supervised_process& p= s.jobs[i];
+    if (!p.reaped) reap_supervised (s, p);
+    // once the leader has been reaped, its pid may be reused by an unrelated
+    // group as soon as the original group is empty, so the group is only
+    // signalled as long as it has been found alive at each check
+    if (p.reaped && p.group && killpg (p.pid, 0) == -1) p.group= false;
+    if (!p.killed && now >= p.deadline) kill_supervised (p);
+    if (p.reaped && (p.killed || !p.group)) {
+      if (p.pidfd != -1) close (p.pidfd);
+      s.jobs.erase (s.jobs.begin () + i);
+      continue;
+    }
+    int delay= -1;
+    if (!p.killed) {
+      auto left= p.deadline - now;
+      delay= (int) std::chrono::ceil<std::chrono::milliseconds> (left).count ();
+    }
+    if (p.reaped || p.pidfd == -1)
+      delay= (delay == -1? SUPERVISOR_POLL: std::min (delay, SUPERVISOR_POLL));
+    if (delay != -1) timeout= (timeout == -1? delay: std::min (timeout, delay));
+    i++;
+  }
+  if (s.jobs.empty ()) s.idle.notify_all ();
+  return timeout;
+}
+
+static void
+supervise () {
+  supervisor_state& s= supervisor ();
+  std::vector<struct pollfd> fds;
+  while (true) {
+    int timeout;
+    fds.clear ();
+    {
+      std::lock_guard<std::mutex> guard (s.lock);
+      timeout= update_supervised (s);
+      struct pollfd pfd;
+      pfd.fd= s.wake[0];
+      pfd.events= POLLIN;
+      pfd.revents= 0;
+      fds.push_back (pfd);
+      for (size_t i=0; i<s.jobs.size (); i++)
+        if (!s.jobs[i].reaped && s.jobs[i].pidfd != -1) {
+          pfd.fd= s.jobs[i].pidfd;
+          fds.push_back (pfd);
+        }
+    }
+    if (poll (fds.data (), fds.size (), timeout) > 0 && fds[0].revents != 0) {
+      char buf[64];
+      while (read (s.wake[0], buf, sizeof (buf)) > 0) {}
+    }
+  }
+}
+
+/******************************************************************************
+* Interface
+******************************************************************************/
+
+void
+terminate_process (int pid, bool group, int grace) {
+  if (pid <= 0) return;
+  if (group) killpg (pid, SIGTERM);
+  else kill (pid, SIGTERM);
+  supervisor_state& s= supervisor ();
+  static std::once_flag started;
+  std::call_once (started, [] () { std::thread (supervise).detach (); });
+  {
+    std::lock_guard<std::mutex> guard (s.lock);
+    for (size_t i=0; i<s.jobs.size (); i++)
+      if (s.jobs[i].pid == pid) return;
+    supervised_process p;
+    p.pid     = pid;
+    p.pidfd   = -1;
+    p.group   = group;
+    p.reaped  = false;
+    p.killed  = false;
+    p.deadline= supervisor_clock::now () + std::chrono::milliseconds (grace);
+#if defined (__linux__) && defined (SYS_pidfd_open)
+    p.pidfd= (int) syscall (SYS_pidfd_open, pid, 0);
+#endif
+    s.jobs.push_back (p);
+  }
+  if (s.wake[1] != -1) {
+    int r= write (s.wake[1], "!", 1);
+    (void) r;
+  }
+}
+
+void
+finish_processes (int msecs) {
+  // used when quitting: wait for the processes which are shutting down,
+  // but not longer than msecs, and kill the remaining ones
+  supervisor_state& s= supervisor ();
+  std::unique_lock<std::mutex> lock (s.lock);
+  s.idle.wait_for (lock, std::chrono::milliseconds (msecs),
+                   [&s] () { return s.jobs.empty (); });
+  for (size_t i=0; i<s.jobs.size (); i++)
+    if (!s.jobs[i].killed) kill_supervised (s.jobs[i]);
+}
+
+bool
+get_process_stats (int pid, process_stats& st) {
+  if (pid <= 0) return false;
+  {
+    supervisor_state& s= supervisor ();
+    std::lock_guard<std::mutex> guard (s.lock);
+    for (int i= (int) s.history.size () - 1; i >= 0; i--)
+      if (s.history[i].pid == pid) {
+        st= s.history[i].st;
+        return true;
+      }
+  }
+#ifdef __linux__
+  char name[64];
+  unsigned long utime, stime;
+  long pages, resident;
+  snprintf (name, sizeof (name), "/proc/%d/stat", pid);
+  FILE* f= fopen (name, "r");
+  if (f == NULL) return false;
+  // skip the command name, which may contain spaces, up to its last ')'
+  int c, last= 0, pos= 0;
+  while ((c= fgetc (f)) != EOF) { pos++; if (c == ')') last= pos; }
+  bool ok= last > 0 && fseek (f, last, SEEK_SET) == 0 &&
+    fscanf (f, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+            &utime, &stime) == 2;
+  fclose (f);
+  if (!ok) return false;
+  snprintf (name, sizeof (name), "/proc/%d/statm", pid);
+  f= fopen (name, "r");
+  if (f == NULL) return false;
+  ok= fscanf (f, "%ld %ld", &pages, &resident) == 2;
+  fclose (f);
+  if (!ok) return false;
+  st.running= true;
+  st.cpu    = (double) (utime + stime) / sysconf (_SC_CLK_TCK);
+  st.memory = (double) resident * (sysconf (_SC_PAGESIZE) / 1024);
+  return true;
+#else
+  return false;
+#endif
+}
+
+#else
+
+void terminate_process (int pid, bool group, int grace) {
+  (void) pid; (void) group; (void) grace; }
+void finish_processes (int msecs) { (void) msecs; }
+bool get_process_stats (int pid, process_stats& st) {
+  (void) pid; (void) st; return false; }
+
+#endif // !defined OS_MINGW
@@ -0,0 +1,29 @@
+
+/******************************************************************************
+* MODULE     : process_supervisor.hpp
+* DESCRIPTION: Background termination and reaping of plugin processes
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#ifndef PROCESS_SUPERVISOR_H
+#define PROCESS_SUPERVISOR_H
+#include "tree.hpp"
+
+#define PROCESS_GRACE_PERIOD 2000   // default delay before SIGKILL in ms
+
+struct process_stats {
+  bool   running;   // the process has not yet been reaped
+  double cpu;       // user and system time in seconds
+  double memory;    // resident memory in kilobytes, the peak once finished
+};
+
+void terminate_process (int pid, bool group, int grace);
+void finish_processes (int msecs);
+bool get_process_stats (int pid, process_stats& st);
+tree process_statistics (int pid);
+
+#endif // defined PROCESS_SUPERVISOR_H
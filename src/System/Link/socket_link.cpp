@@ -12,6 +12,7 @@
 #ifndef QTTEXMACS
 
 #include "socket_link.hpp"
+#include "link_reader.hpp"
 #include "sys_utils.hpp"
 #include "hashset.hpp"
 #include "iterator.hpp"
@@ -48,6 +49,13 @@ socket_link_rep::socket_link_rep (string host2, int port2, int type2, int fd):
   io     = fd;
   outbuf = "";
   alive  = (fd != -1);
+  throttled= false;
+#ifndef WIN32
+  if (alive) {
+    link_set_nonblocking (io);
+    poller->add (io);
+  }
+#endif
   if (type == SOCKET_SERVER) {
     sn = socket_notifier (io, &socket_callback, this, NULL);  
     add_notifier (sn);
@@ -190,6 +198,11 @@ socket_link_rep::start () {
     return "Error: non working connection to '" * where * "'";
 #endif
   alive = true;
+  throttled= false;
+#ifndef WIN32
+  poller= link_poller ();
+  poller->add (io);
+#endif
   sn = socket_notifier (io, &socket_callback, this, NULL);  
   add_notifier (sn);
   return "ok";
@@ -221,6 +234,12 @@ send_all (int s, char *buf, int *len) {
 
   while (total < *len) {
     n= send (s, buf + total, bytes_left, 0);
+#ifndef WIN32
+    // the socket is non blocking, so wait until the peer catches up
+    if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK) &&
+        link_wait_writable (s, 10000)) continue;
+    if (n == -1 && errno == EINTR) continue;
+#endif
     if (n == -1) break;
     total += n;
     bytes_left -= n;
@@ -242,27 +261,49 @@ socket_link_rep::write (string s, int channel) {
   }
 }
 
-void
+bool
 socket_link_rep::feed (int channel) {
+  // returns true when new data arrived or when the link died
 #ifdef WIN32
   using namespace wsoc;
 #endif
-  if ((!alive) || (channel != LINK_OUT)) return;
+  if ((!alive) || (channel != LINK_OUT)) return false;
+#ifdef WIN32
+  int n= N(outbuf);
   char tempout[1024];
   int r= recv (io, tempout, 1024, 0);
-  if (r <= 0) {
-    if (r == 0) debug_io << host << ":" << port << "' hung up\n";
+  if (r > 0) {
+    if (DEBUG_IO) debug_io << debug_io_string (string (tempout, r));
+    outbuf << string (tempout, r);
+  }
+  r= (r > 0? LINK_READ_AGAIN: (r == 0? LINK_READ_EOF: LINK_READ_ERROR));
+#else
+  int n= N(outbuf);
+  int r= link_read_available (io, outbuf, true);
+  if (DEBUG_IO && N(outbuf) > n)
+    debug_io << debug_io_string (outbuf (n, N(outbuf)));
+#endif
+  if (r == LINK_READ_EOF || r == LINK_READ_ERROR) {
+    if (r == LINK_READ_EOF) debug_io << host << ":" << port << "' hung up\n";
     else io_warning << "TeXmacs] read failed from '" << host
                     << ":" << port << "'\n";
     stop ();
+    return true;
   }
-  else if (r != 0) {
-    if (DEBUG_IO) debug_io << debug_io_string (string (tempout, r));
-    outbuf << string (tempout, r);
+  if (r == LINK_READ_FULL) throttle (true);
 #ifdef QT_CPU_FIX
-    tm_wake_up ();
+  if (N(outbuf) > n) tm_wake_up ();
 #endif
-  }
+  return N(outbuf) > n;
+}
+
+void
+socket_link_rep::throttle (bool flag) {
+  // while throttled, the peer blocks as soon as the socket buffers are full
+  if (flag == throttled || !alive) return;
+  throttled= flag;
+  if (flag) remove_notifier (sn);
+  else add_notifier (sn);
 }
 
 string&
@@ -277,6 +318,7 @@ socket_link_rep::read (int channel) {
   if (channel == LINK_OUT) {
     string r= outbuf;
     outbuf= "";
+    if (throttled) throttle (false);
     return r;
   }
   else return "";
@@ -288,6 +330,7 @@ socket_link_rep::listen (int msecs) {
   using namespace wsoc;
 #endif
   if (!alive) return;
+#ifdef WIN32
   fd_set rfds;
   FD_ZERO (&rfds);
   FD_SET (io, &rfds);
@@ -296,6 +339,9 @@ socket_link_rep::listen (int msecs) {
   tv.tv_usec = 1000 * (msecs % 1000);
   int nr= select (io+1, &rfds, NULL, NULL, &tv);
   if (nr != 0 && FD_ISSET (io, &rfds)) feed (LINK_OUT);
+#else
+  if (poller->wait (msecs) > 0) feed (LINK_OUT);
+#endif
 }
 
 void
@@ -343,6 +389,7 @@ socket_callback (void *obj, void* info) {
   }
   bool busy= true;
   bool news= false;
+#ifdef WIN32
   while (busy) {
     fd_set rfds;
     FD_ZERO (&rfds);
@@ -356,12 +403,18 @@ socket_callback (void *obj, void* info) {
 
     busy= false;
     if (con->alive && FD_ISSET (con->io, &rfds)) {
-      //cout << "socket_callback OUT" << LF;
       con->feed (LINK_OUT);
       busy= news= true;
       if (!con->alive) break;
     }
   }
+#else
+  while (busy && con->alive && !con->throttled) {
+    busy= false;
+    if (con->poller->wait (0) > 0 && con->feed (LINK_OUT))
+      busy= news= true;
+  }
+#endif
   if (!is_nil (con->feed_cmd) && news)
     con->feed_cmd->apply ();
 }
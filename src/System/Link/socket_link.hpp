@@ -13,6 +13,7 @@
 #define SOCKET_LINK_H
 #include "tm_link.hpp"
 #include "socket_notifier.hpp"
+#include "link_reader.hpp"
 
 /******************************************************************************
 * The socket_link class
@@ -24,8 +25,10 @@ struct socket_link_rep: tm_link_rep {
   int    type;          // socket type
   int    io;            // file descriptor for data going to the child
   string outbuf;        // pending output from plugin
+  bool   throttled;     // reading suspended until the output is consumed
 
   socket_notifier sn;
+  link_poller     poller;
   
 public:
   socket_link_rep (string host, int port, int type, int fd);
@@ -39,7 +42,8 @@ public:
   void    interrupt ();
   void    stop ();
 
-  void    feed (int channel);
+  bool    feed (int channel);
+  void    throttle (bool flag);
 };
 
 #endif // SOCKET_LINK_H
@@ -54,6 +54,7 @@ public:
   virtual void    listen (int msecs) = 0;
   virtual void    interrupt () = 0;
   virtual void    stop () = 0;
+  virtual int     process_id () { return -1; }
 
   void write_packet (string s, int channel);
   bool complete_packet (int channel);
@@ -89,5 +90,7 @@ void process_all_pipes ();
 void close_all_sockets ();
 void close_all_servers ();
 int  number_of_servers ();
+void set_plugin_grace_period (int msecs);
+int  get_plugin_grace_period ();
 
 #endif // TM_LINK_H
@@ -13,41 +13,196 @@
 #include "file.hpp"
 #include "convert.hpp"
 #include "iterator.hpp"
+#include <string.h>
 
 /******************************************************************************
-* Caching routines
+* Cache files.
+* A cache file starts with CACHE_MAGIC and is followed by records, which
+* consist of the lengths of the key and the value as 32 bit little endian
+* integers, followed by the encoded key and value. A record whose value
+* has length CACHE_REMOVED marks the removal of its key. Later records
+* override earlier ones. When loading a cache, we only map the file into
+* memory. The offsets of the records of the keys are looked up when the
+* cache is first used, and the keys are not copied, but refer to the
+* mapped data; the values are decoded when they are first needed. When
+* saving a cache, the changed entries are appended to the file, which is
+* only rewritten from scratch when it contains too many obsolete records.
 ******************************************************************************/
 
-static hashmap<tree,tree> cache_data ("?");
+#define CACHE_MAGIC "%-%-tm-cache-binary-1-%-%\n"
+#define CACHE_REMOVED (-1)
+#define CACHE_GARBAGE 1024
+
+struct cache_key {
+  const char* s;  // the encoded key
+  int         n;  // its length
+  inline cache_key (): s (NULL), n (0) {}
+  inline cache_key (const char* s2, int n2): s (s2), n (n2) {}
+};
+
+inline int
+hash (cache_key k) {
+  int h= 0;
+  for (int i=0; i<k.n; i++) h= (h<<9) + (h>>23) + ((int) k.s[i]);
+  return h;
+}
+
+inline bool
+operator == (cache_key k1, cache_key k2) {
+  return k1.n == k2.n && memcmp (k1.s, k2.s, k1.n) == 0;
+}
+
+inline bool
+operator != (cache_key k1, cache_key k2) {
+  return !(k1 == k2);
+}
+
+inline tm_ostream&
+operator << (tm_ostream& out, cache_key k) {
+  return out << string (k.s, k.n);
+}
+
+struct cache_file {
+  mapped_file                  mf;       // the contents of the file
+  flat_hashmap<cache_key,int>  index;    // offsets of the records of the keys
+  int                          garbage;  // number of obsolete records
+  bool                         rewrite;  // rewrite instead of appending
+  bool                         scanned;  // whether index has been computed
+  cache_file (mapped_file mf2):
+    mf (mf2), index (-1), garbage (0), rewrite (false), scanned (false) {}
+};
+
+static flat_hashmap<tree,tree> cache_data ("?");
+static hashmap<string,cache_file*> cache_files (NULL);
+static hashset<tree> cache_dirty;
 static hashset<string> cache_loaded;
 static hashset<string> cache_changed;
 static hashmap<string,bool> cache_valid (false);
 
+static string
+cache_encode (tree t) {
+  if (is_atomic (t)) return "a" * t->label;
+  else return "s" * tree_to_scheme (t);
+}
+
+static tree
+cache_decode (const char* s, int n) {
+  if (n > 0 && s[0] == 'a') return tree (string (s+1, n-1));
+  if (n > 0 && s[0] == 's') return scheme_to_tree (string (s+1, n-1));
+  return "";
+}
+
+static int
+cache_read_int (const char* s) {
+  const unsigned char* u= (const unsigned char*) s;
+  return (int) (((unsigned int) u[0]) | (((unsigned int) u[1]) << 8) |
+                (((unsigned int) u[2]) << 16) | (((unsigned int) u[3]) << 24));
+}
+
+static void
+cache_write_int (string& out, int i) {
+  unsigned int u= (unsigned int) i;
+  for (int k=0; k<4; k++) out << (char) ((u >> (8*k)) & 255);
+}
+
+static void
+cache_write_record (string& out, tree key, tree val, bool removed) {
+  string k= cache_encode (key);
+  string v= removed? string (""): cache_encode (val);
+  cache_write_int (out, N(k));
+  cache_write_int (out, removed? CACHE_REMOVED: N(v));
+  out << k << v;
+}
+
+static void
+cache_scan (cache_file* cf) {
+  const char* d= cf->mf->data;
+  int pos= strlen (CACHE_MAGIC), n= cf->mf->size;
+  while (pos + 8 <= n) {
+    int kl= cache_read_int (d + pos), vl= cache_read_int (d + pos + 4);
+    int next= pos + 8 + kl + (vl == CACHE_REMOVED? 0: vl);
+    if (kl < 0 || vl < CACHE_REMOVED || next > n || next <= pos) break;
+    cache_key key (d + pos + 8, kl);
+    if (cf->index->contains (key)) cf->garbage++;
+    if (vl == CACHE_REMOVED) {
+      cf->index->reset (key);
+      cf->garbage++;
+    }
+    else cf->index (key)= pos;
+    pos= next;
+  }
+  // a truncated file is rewritten at the next save
+  if (pos != n) cf->rewrite= true;
+  cf->scanned= true;
+}
+
+static cache_file*
+cache_index (string buffer) {
+  cache_file* cf= cache_files [buffer];
+  if (cf != NULL && !cf->scanned) cache_scan (cf);
+  return cf;
+}
+
+static bool
+cache_fetch (string buffer, tree key, tree ckey) {
+  cache_file* cf= cache_index (buffer);
+  if (cf == NULL) return false;
+  string s= cache_encode (key);
+  cache_key k (s.data (), N(s));
+  if (!cf->index->contains (k)) return false;
+  const char* d= cf->mf->data + cf->index [k];
+  int kl= cache_read_int (d), vl= cache_read_int (d + 4);
+  cache_data (ckey)= cache_decode (d + 8 + kl, vl);
+  return true;
+}
+
+static void
+cache_forget (string buffer, tree key) {
+  cache_file* cf= cache_index (buffer);
+  if (cf == NULL) return;
+  string s= cache_encode (key);
+  cache_key k (s.data (), N(s));
+  if (cf->index->contains (k)) {
+    cf->index->reset (k);
+    cf->garbage++;
+  }
+}
+
+/******************************************************************************
+* Caching routines
+******************************************************************************/
+
 void
 cache_set (string buffer, tree key, tree t) {
   tree ckey= tuple (buffer, key);
-  if (cache_data[ckey] != t) {
+  if (!is_cached (buffer, key) || cache_data[ckey] != t) {
+    cache_forget (buffer, key);
     cache_data (ckey)= t;
+    cache_dirty->insert (ckey);
     cache_changed->insert (buffer);
   }
 }
 
 void
 cache_reset (string buffer, tree key) {
+  if (!is_cached (buffer, key)) return;
   tree ckey= tuple (buffer, key);
+  cache_forget (buffer, key);
   cache_data->reset (ckey);
+  cache_dirty->insert (ckey);
   cache_changed->insert (buffer);
 }
 
 bool
 is_cached (string buffer, tree key) {
   tree ckey= tuple (buffer, key);
-  return cache_data->contains (ckey);
+  return cache_data->contains (ckey) || cache_fetch (buffer, key, ckey);
 }
 
 tree
 cache_get (string buffer, tree key) {
   tree ckey= tuple (buffer, key);
+  if (!cache_data->contains (ckey)) cache_fetch (buffer, key, ckey);
   return cache_data [ckey];
 }
 
@@ -155,69 +310,121 @@ do_cache_doc (string name) {
 * Saving and loading the cache to/from disk
 ******************************************************************************/
 
+static url
+cache_url (string buffer) {
+  return texmacs_home_path * url ("system/cache/" * buffer);
+}
+
+static void
+cache_rewrite (string buffer, cache_file* cf) {
+  string out= CACHE_MAGIC;
+  iterator<cache_key> it= iterate (cf->index);
+  while (it->busy ()) {
+    cache_key k= it->next ();
+    const char* d= cf->mf->data + cf->index [k];
+    int kl= cache_read_int (d), vl= cache_read_int (d + 4);
+    if (cache_data->contains (tuple (buffer, cache_decode (d + 8, kl))))
+      continue;
+    out << string (d, 8 + kl + vl);
+  }
+  iterator<tree> jt= iterate (cache_data);
+  while (jt->busy ()) {
+    tree ckey= jt->next ();
+    if (ckey[0] == buffer)
+      cache_write_record (out, ckey[1], cache_data [ckey], false);
+  }
+  // the file is no longer mapped while it is replaced, since mapped files
+  // cannot be replaced or truncated on all systems
+  cf->mf     = mapped_file (out);
+  cf->index  = flat_hashmap<cache_key,int> (-1);
+  cf->garbage= 0;
+  cf->scanned= false;
+  file_writer fw (cache_url (buffer));
+  fw->write (out.data (), N(out));
+  if (fw->commit () && save_string (cache_url (buffer), out)) return;
+  cf->rewrite= false;
+}
+
+static void
+cache_append (string buffer) {
+  string out;
+  iterator<tree> it= iterate (cache_dirty);
+  while (it->busy ()) {
+    tree ckey= it->next ();
+    if (ckey[0] == buffer) {
+      bool removed= !cache_data->contains (ckey);
+      cache_write_record (out, ckey[1], cache_data [ckey], removed);
+    }
+  }
+  if (N(out) != 0) (void) append_string (cache_url (buffer), out);
+}
+
 void
 cache_save (string buffer) {
   if (cache_changed->contains (buffer)) {
-    url cache_file= texmacs_home_path * url ("system/cache/" * buffer);
-    string cached;
-    iterator<tree> it= iterate (cache_data);
-    if (buffer == "file_cache" || buffer == "doc_cache") {
-      while (it->busy ()) {
-        tree ckey= it->next ();
-        if (ckey[0] == buffer) {
-          cached << ckey[1]->label << "\n";
-          cached << cache_data [ckey]->label << "\n";
-          cached << "%-%-tm-cache-%-%\n";
-        }
-      }
+    cache_load (buffer);
+    cache_file* cf= cache_index (buffer);
+    cache_changed->remove (buffer);
+    if (cf->garbage > CACHE_GARBAGE && cf->garbage > N(cf->index))
+      cf->rewrite= true;
+    if (cf->rewrite || !exists (cache_url (buffer)))
+      cache_rewrite (buffer, cf);
+    else cache_append (buffer);
+    hashset<tree> dirty;
+    iterator<tree> it= iterate (cache_dirty);
+    while (it->busy ()) {
+      tree ckey= it->next ();
+      if (ckey[0] != buffer) dirty->insert (ckey);
     }
-    else {
-      cached << "(tuple\n";
-      while (it->busy ()) {
-        tree ckey= it->next ();
-        if (ckey[0] == buffer) {
-          cached << tree_to_scheme (ckey[1]) << " ";
-          cached << tree_to_scheme (cache_data [ckey]) << "\n";
-        }
-      }
-      cached << ")";
+    cache_dirty= dirty;
+  }
+}
+
+static void
+cache_load_text (string buffer, string cached) {
+  // caches in the former text format, which are converted at the next save
+  if (buffer == "file_cache" || buffer == "doc_cache") {
+    int i=0, n= N(cached);
+    while (i<n) {
+      int start= i;
+      while (i<n && cached[i] != '\n') i++;
+      string key= cached (start, i);
+      i++; start= i;
+      while (i<n && (cached[i] != '\n' ||
+                     !test (cached, i+1, "%-%-tm-cache-%-%"))) i++;
+      string im= cached (start, i);
+      i++;
+      while (i<n && cached[i] != '\n') i++;
+      i++;
+      //cout << "key= " << key << "\n----------------------\n";
+      //cout << "im= " << im << "\n----------------------\n";
+      cache_data (tuple (buffer, key))= im;
     }
-    (void) save_string (cache_file, cached);
-    cache_changed->remove (buffer);
   }
+  else {
+    tree t= scheme_to_tree (cached);
+    for (int i=0; i<N(t)-1; i+=2)
+      cache_data (tuple (buffer, t[i]))= t[i+1];
+  }
+  cache_changed->insert (buffer);
 }
 
 void
 cache_load (string buffer) {
   if (!cache_loaded->contains (buffer)) {
-    url cache_file = texmacs_home_path * url ("system/cache/" * buffer);
-    //cout << "cache_file "<< cache_file << LF;
-    string cached;
-    if (!load_string (cache_file, cached, false)) {
-      if (buffer == "file_cache" || buffer == "doc_cache") {
-        int i=0, n= N(cached);
-        while (i<n) {
-          int start= i;
-          while (i<n && cached[i] != '\n') i++;
-          string key= cached (start, i);
-          i++; start= i;
-          while (i<n && (cached[i] != '\n' ||
-                         !test (cached, i+1, "%-%-tm-cache-%-%"))) i++;
-          string im= cached (start, i);
-          i++;
-          while (i<n && cached[i] != '\n') i++;
-          i++;
-          //cout << "key= " << key << "\n----------------------\n";
-          //cout << "im= " << im << "\n----------------------\n";
-          cache_data (tuple (buffer, key))= im;
-        }
-      }
-      else {
-        tree t= scheme_to_tree (cached);
-        for (int i=0; i<N(t)-1; i+=2)
-          cache_data (tuple (buffer, t[i]))= t[i+1];
-      }
+    mapped_file mf (cache_url (buffer));
+    //cout << "cache_file "<< cache_url (buffer) << LF;
+    int m= strlen (CACHE_MAGIC);
+    cache_file* cf;
+    if (!mf->error && mf->size >= m && memcmp (mf->data, CACHE_MAGIC, m) == 0)
+      cf= tm_new<cache_file> (mf);
+    else {
+      if (!mf->error && mf->size > 0)
+        cache_load_text (buffer, string (mf->data, mf->size));
+      cf= tm_new<cache_file> (mapped_file (string ("")));
+      cf->rewrite= true;
     }
+    cache_files (buffer)= cf;
     cache_loaded->insert (buffer);
   }
 }
@@ -234,7 +441,11 @@ cache_memorize () {
 
 void
 cache_refresh () {
-  cache_data   = hashmap<tree,tree> ("?");
+  iterator<string> it= iterate (cache_files);
+  while (it->busy ()) tm_delete (cache_files [it->next ()]);
+  cache_files  = hashmap<string,cache_file*> (NULL);
+  cache_data   = flat_hashmap<tree,tree> ("?");
+  cache_dirty  = hashset<tree> ();
   cache_loaded = hashset<string> ();
   cache_changed= hashset<string> ();
   cache_load ("file_cache");
@@ -5,6 +5,8 @@
 *              of allocations for each fixed size divisible by
 *              a word legth up to MAX_FAST. Otherwise,
 *              usual memory allocation is used.
+*              Each thread owns its own free lists, so that the
+*              fast path does not need any locking.
 * ASSUMPTIONS: The word size of the computer is 4.
 *              Otherwise, change WORD_LENGTH.
 * COPYRIGHT  : (C) 1999  Joris van der Hoeven
@@ -15,19 +17,242 @@
 ******************************************************************************/
 
 #include "fast_alloc.hpp"
+#include <atomic>
+#include <mutex>
+#include <new>
+
+#define NR_SIZES ((MAX_FAST / WORD_LENGTH) + 1)
+#define ind(ptr) (*((void **) ptr))
+
+/******************************************************************************
+* Per thread allocation caches
+******************************************************************************/
+
+/* Statistics are only written by the owning thread, but may be read by
+   mem_used and mem_info from any thread, hence the relaxed atomics. */
+
+typedef std::atomic<long> alloc_counter;
+
+static inline void
+add (alloc_counter& c, long n) {
+  c.store (c.load (std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+struct alloc_cache {
+  void*         alloc_table[NR_SIZES]; // free lists by size / WORD_LENGTH
+  char*         alloc_mem;             // current block
+  size_t        alloc_remains;         // remaining bytes in current block
+  alloc_counter fast_chunks;           // number of allocated blocks
+  alloc_counter alloc_left;            // copy of alloc_remains for statistics
+  alloc_counter large_uses;            // bytes allocated with malloc
+  alloc_counter free_bytes;            // bytes on the free lists
+  alloc_cache*  next;                  // all caches ever created
+  alloc_cache*  next_idle;             // caches of terminated threads
+};
+
+static std::mutex    alloc_mutex;
+static alloc_cache*  all_caches = NULL;
+static alloc_cache*  idle_caches= NULL;
+static thread_local  alloc_cache* the_cache= NULL;
+
+/* When a thread terminates, its cache (including its free lists) is handed
+   over to the next thread which starts allocating memory. Caches are never
+   released, so that blocks freed by other threads remain valid. */
+
+struct alloc_cache_guard {
+  ~alloc_cache_guard () {
+    if (the_cache == NULL) return;
+    std::lock_guard<std::mutex> lock (alloc_mutex);
+    the_cache->next_idle= idle_caches;
+    idle_caches= the_cache;
+    the_cache= NULL;
+  }
+};
+
+static thread_local alloc_cache_guard the_cache_guard;
+
+static alloc_cache*
+new_cache () {
+  (void) &the_cache_guard; // ensure that the guard is constructed
+  std::lock_guard<std::mutex> lock (alloc_mutex);
+  if (idle_caches != NULL) {
+    alloc_cache* c= idle_caches;
+    idle_caches= c->next_idle;
+    c->next_idle= NULL;
+    return c;
+  }
+  alloc_cache* c= (alloc_cache*) safe_malloc (sizeof (alloc_cache));
+  for (int i=0; i<NR_SIZES; i++) c->alloc_table[i]= NULL;
+  c->alloc_mem= NULL;
+  c->alloc_remains= 0;
+  new (&c->fast_chunks) alloc_counter (0);
+  new (&c->alloc_left) alloc_counter (0);
+  new (&c->large_uses) alloc_counter (0);
+  new (&c->free_bytes) alloc_counter (0);
+  c->next= all_caches;
+  c->next_idle= NULL;
+  all_caches= c;
+  return c;
+}
+
+static inline alloc_cache*
+get_cache () {
+  if (the_cache == NULL) the_cache= new_cache ();
+  return the_cache;
+}
+
+/******************************************************************************
+* Slow allocation
+******************************************************************************/
+
+void*
+safe_malloc (size_t sz) {
+  void* ptr= malloc (sz);
+  if (ptr==NULL) {
+    cerr << "Fatal error: out of memory\n";
+    abort ();
+  }
+  return ptr;
+}
+
+static void*
+enlarge_malloc (alloc_cache* c, size_t sz) {
+  if (c->alloc_remains<sz) {
+    c->alloc_mem    = (char *) safe_malloc (BLOCK_SIZE);
+    c->alloc_remains= BLOCK_SIZE;
+    add (c->fast_chunks, 1);
+  }
+  void* ptr= c->alloc_mem;
+  c->alloc_mem    += sz;
+  c->alloc_remains-= sz;
+  c->alloc_left.store (c->alloc_remains, std::memory_order_relaxed);
+  return ptr;
+}
+
+void*
+enlarge_malloc (size_t sz) {
+  return enlarge_malloc (get_cache (), sz);
+}
+
+/******************************************************************************
+* Fast allocation
+******************************************************************************/
+
+static inline void*
+pop (alloc_cache* c, size_t sz) {
+  void*& head= c->alloc_table[sz / WORD_LENGTH];
+  void* ptr= head;
+  if (ptr == NULL) return enlarge_malloc (c, sz);
+  head= ind (ptr);
+  add (c->free_bytes, -((long) sz));
+  return ptr;
+}
+
+static inline void
+push (alloc_cache* c, void* ptr, size_t sz) {
+  void*& head= c->alloc_table[sz / WORD_LENGTH];
+  ind (ptr)= head;
+  head= ptr;
+  add (c->free_bytes, (long) sz);
+}
+
+void*
+fast_alloc (size_t sz) {
+  sz= (sz+WORD_LENGTH_INC)&WORD_MASK;
+  alloc_cache* c= get_cache ();
+  if (sz<MAX_FAST) return pop (c, sz);
+  add (c->large_uses, (long) sz);
+  return safe_malloc (sz);
+}
+
+void
+fast_free (void* ptr, size_t sz) {
+  sz= (sz+WORD_LENGTH_INC)&WORD_MASK;
+  alloc_cache* c= get_cache ();
+  if (sz<MAX_FAST) push (c, ptr, sz);
+  else {
+    add (c->large_uses, -((long) sz));
+    free (ptr);
+  }
+}
+
+void*
+fast_new (size_t s) {
+  void* ptr;
+  s= (s+ WORD_LENGTH + WORD_LENGTH_INC) & WORD_MASK;
+  alloc_cache* c= get_cache ();
+  if (s<MAX_FAST) ptr= pop (c, s);
+  else {
+    ptr= safe_malloc (s);
+    add (c->large_uses, (long) s);
+  }
+  *((size_t *) ptr)= s;
+  return (void*) (((char*) ptr)+ WORD_LENGTH);
+}
+
+void
+fast_delete (void* ptr) {
+  ptr= (void*) (((char*) ptr)- WORD_LENGTH);
+  size_t s= *((size_t *) ptr);
+  alloc_cache* c= get_cache ();
+  if (s<MAX_FAST) push (c, ptr, s);
+  else {
+    add (c->large_uses, -((long) s));
+    free (ptr);
+  }
+}
+
+/******************************************************************************
+* Debugging
+******************************************************************************/
+
+void*
+alloc_check (const char *msg, void *ptr, size_t* sp) {
+  size_t s= *(((size_t*) ptr) - 1);
+  if (s < WORD_LENGTH || (s & WORD_LENGTH_INC) != 0) {
+    cerr << msg << ": invalid block size " << (int) s << "\n";
+    abort ();
+  }
+  if (sp != NULL) *sp= s;
+  return ptr;
+}
 
 /******************************************************************************
 * Statistics
 ******************************************************************************/
 
+static void
+collect (long& chunks, long& remains, long& large, long& free_bytes) {
+  chunks= remains= large= free_bytes= 0;
+  std::lock_guard<std::mutex> lock (alloc_mutex);
+  for (alloc_cache* c= all_caches; c != NULL; c= c->next) {
+    chunks    += c->fast_chunks.load (std::memory_order_relaxed);
+    remains   += c->alloc_left.load (std::memory_order_relaxed);
+    large     += c->large_uses.load (std::memory_order_relaxed);
+    free_bytes+= c->free_bytes.load (std::memory_order_relaxed);
+  }
+}
+
 int
 mem_used () {
-    return 0;
+  long chunks, remains, large, free_bytes;
+  collect (chunks, remains, large, free_bytes);
+  long chunks_use= BLOCK_SIZE*chunks - remains;
+  return (int) (chunks_use - free_bytes + large);
 }
 
 void
 mem_info () {
-    // todo
+  long chunks, remains, large, free_bytes;
+  collect (chunks, remains, large, free_bytes);
+  long chunks_use= BLOCK_SIZE*chunks - remains;
+  long total_use = chunks_use + large;
+  long used_use  = total_use - free_bytes;
+  cout << "\n---------------- memory statistics ----------------\n";
+  cout << "Fast chunks   : " << (int) chunks_use << " bytes\n";
+  cout << "Free on chunks: " << (int) remains << " bytes\n";
+  cout << "Large chunks  : " << (int) large << " bytes\n";
+  cout << "Total allocated memory : " << (int) total_use << " bytes\n";
+  cout << "Free memory            : " << (int) free_bytes << " bytes\n";
+  cout << "Used memory            : " << (int) used_use << " bytes\n";
 }
-
-
@@ -11,7 +11,6 @@
 
 #ifndef FAST_ALLOC_H
 #define FAST_ALLOC_H
-#define NO_FAST_ALLOC
 
 #include "tm_config.h"
 #include "tm_configure.hpp"
@@ -18,6 +18,8 @@
 #include "dictionary.hpp"
 #include "new_document.hpp"
 #include "merge_sort.hpp"
+#include "memo_store.hpp"
+#include "Texmacs/tmbin.hpp"
 
 array<tm_buffer> bufs;
 
@@ -81,6 +83,7 @@ remove_buffer (tm_buffer buf) {
         bufs[i]= bufs[i+1];
       bufs->resize (n-1);
       tm_delete (buf);
+      memo_unload ();
       return;
     }
 }
@@ -437,6 +440,14 @@ attach_subformat (tree t, url u, string fm) {
   return change_doc_attr (t2, "style", tree ("code"));
 }
 
+static tree
+register_links (tree t, url u) {
+  tree links= extract (t, "links");
+  if (N (links) != 0)
+    (void) call ("register-link-locations", object (u), object (links));
+  return t;
+}
+
 tree
 import_loaded_tree (string s, url u, string fm) {
   set_file_focus (u);
@@ -444,17 +455,28 @@ import_loaded_tree (string s, url u, string fm) {
   if (fm == "generic") fm= get_format (s, suffix (u));
   if (fm == "texmacs" && starts (s, "(document (TeXmacs")) fm= "stm";
   if (fm == "verbatim" && starts (s, "(document (TeXmacs")) fm= "stm";
+  if (fm == "tmb" || is_texmacs_binary (s))
+    return register_links (texmacs_binary_to_tree (s), u);
   tree t= generic_to_tree (s, fm * "-document");
-  tree links= extract (t, "links");
-  if (N (links) != 0)
-    (void) call ("register-link-locations", object (u), object (links));
-  return attach_subformat (t, u, fm);
+  return attach_subformat (register_links (t, u), u, fm);
 }
 
 tree
 import_tree (url u, string fm) {
   u= resolve (u, "fr");
   set_file_focus (u);
+  if (!is_none (u) && (fm == "tmb" || (fm == "generic" && suffix (u) == "tmb"))) {
+    // binary documents are decoded straight from the memory mapped file
+    tree t= texmacs_binary_to_tree (u);
+    if (is_func (t, LABEL_ERROR)) return "error";
+    return register_links (t, u);
+  }
+  if (!is_none (u) &&
+      (fm == "texmacs" || (fm == "generic" && suffix (u) == "tm"))) {
+    // so are documents in the TeXmacs format
+    tree t= texmacs_document_to_tree (u);
+    if (!is_func (t, LABEL_ERROR)) return register_links (t, u);
+  }
   string s;
   if (is_none (u) || load_string (u, s, false)) return "error";
   return import_loaded_tree (s, u, fm);
@@ -528,23 +550,15 @@ export_tree (tree doc, url u, string fm) {
       }
   // END hook
   if (fm == "generic") fm= "verbatim";
+  if (fm == "tmb") return save_string (u, tree_to_texmacs_binary (aux));
+  if (fm == "texmacs" && is_rooted_name (u)) return tree_to_texmacs (aux, u);
   string s= tree_to_generic (aux, fm * "-document");
   if (s == "* error: unknown format *") return true;
   return save_string (u, s);
 }
 
-bool
-buffer_export (url name, url dest, string fm) {
-  tm_view vw= concrete_view (get_recent_view (name));
-  TM_ASSERT (vw != NULL, "view expected");
-
-  if (fm == "postscript" || fm == "pdf") {
-    int old_stamp= last_modified (dest, false);
-    vw->ed->print_to_file (dest);
-    int new_stamp= last_modified (dest, false);
-    return new_stamp <= old_stamp;
-  }
-
+static tree
+export_document (tm_view vw, string fm) {
   tree body= subtree (the_et, vw->buf->rp);
   if (fm == "verbatim")
     body= vw->ed->exec_verbatim (body);
@@ -564,8 +578,46 @@ buffer_export (url name, url dest, string fm) {
   tree links= as_tree (call ("get-link-locations", arg1, arg2));
   if (N (links) != 0)
     doc << compound ("links", links);
-  
-  return export_tree (doc, dest, fm);
+  return doc;
+}
+
+bool
+buffer_export (url name, url dest, string fm) {
+  tm_view vw= concrete_view (get_recent_view (name));
+  TM_ASSERT (vw != NULL, "view expected");
+
+  if (fm == "postscript" || fm == "pdf") {
+    int old_stamp= last_modified (dest, false);
+    vw->ed->print_to_file (dest);
+    int new_stamp= last_modified (dest, false);
+    return new_stamp <= old_stamp;
+  }
+
+  return export_tree (export_document (vw, fm), dest, fm);
+}
+
+bool
+buffer_autosave (url name, url dest, string fm) {
+  // Trees cannot be shared with other threads, so that the saving thread
+  // serializes a private snapshot of the document
+  if (fm != "texmacs" || !is_rooted_name (dest))
+    return buffer_export (name, dest, fm);
+  tm_view vw= concrete_view (get_recent_view (name));
+  TM_ASSERT (vw != NULL, "view expected");
+  tree doc= export_document (vw, fm);
+  tree init= extract (doc, "initial");
+  for (int i=0; i<N(init); i++)
+    if (is_func (init[i], ASSOCIATE, 2) && init[i][0] == "encryption")
+      return export_tree (doc, dest, fm);
+  // In rescue mode TeXmacs exits right after autosaving, and failures of
+  // the previous background write are reported by writing synchronously
+  if (in_rescue_mode () || background_save_failed (dest)) {
+    cancel_background_save (dest);
+    return export_tree (doc, dest, fm);
+  }
+  save_string_in_background (dest, [snapshot= texmacs_snapshot (doc)] () {
+    return texmacs_snapshot_to_string (snapshot); });
+  return false;
 }
 
 tree
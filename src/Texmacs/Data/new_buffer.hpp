@@ -100,6 +100,7 @@ bool buffer_has_name (url name);
 bool buffer_import (url name, url src, string fm);
 bool buffer_load (url name);
 bool buffer_export (url name, url dest, string fm);
+bool buffer_autosave (url name, url dest, string fm);
 bool buffer_save (url name);
 tree import_loaded_tree (string s, url u, string fm);
 tree import_tree (url u, string fm);
@@ -173,6 +173,7 @@ tm_failure (const char* msg) {
 
   //cerr << "Autosaving...\n";
   call ("autosave-all");
+  finish_background_saves ();
   //cerr << "Closing pipes...\n";
   close_all_pipes ();
   call ("quit-TeXmacs-scheme");
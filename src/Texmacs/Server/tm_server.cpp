@@ -22,6 +22,7 @@
 #include "tm_link.hpp"
 #include "socket_notifier.hpp"
 #include "new_style.hpp"
+#include "memo_store.hpp"
 #include "Database/database.hpp"
 
 server* the_server= NULL;
@@ -248,6 +249,8 @@ tm_server_rep::is_yes (string s) {
 void
 tm_server_rep::quit () {
   close_all_pipes ();
+  memo_flush ();
+  finish_background_saves ();
   call ("quit-TeXmacs-scheme");
   clear_pending_commands ();
 #ifdef QTTEXMACS
@@ -518,6 +518,8 @@ TeXmacs_main (int argc, char** argv) {
 #if defined(X11TEXMACS) && defined(MACOSX_EXTENSIONS)
   finalize_mac_application ();
 #endif
+
+  release_interned_strings ();
   
   if (DEBUG_STD) debug_boot << "Good bye...\n";
 }
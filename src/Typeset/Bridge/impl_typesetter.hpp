@@ -12,6 +12,7 @@
 #ifndef IMPL_TYPESETTER_H
 #define IMPL_TYPESETTER_H
 #include "Bridge/bridge.hpp"
+#include "Page/new_breaker.hpp"
 
 class typesetter_rep {
 public:
@@ -28,6 +29,7 @@ public:
   SI x1, y1, x2, y2;
   hashmap<string,tree> old_patch;
   bool paper;
+  break_cache page_breaks; // page breaks of the previous run
 
 public:
   typesetter_rep (edit_env& env, tree et, path ip);
@@ -44,6 +46,7 @@ public:
   void determine_page_references (box b);
   box  typeset ();
   box  typeset (SI& x1, SI& y1, SI& x2, SI& y2);
+  box  typeset_pages ();
 };
 
 #endif // defined IMPL_TYPESETTER_H
@@ -17,7 +17,7 @@
 ******************************************************************************/
 
 typesetter_rep::typesetter_rep (edit_env& env2, tree et, path ip):
-  env (env2), old_patch (UNINIT)
+  env (env2), old_patch (UNINIT), page_breaks (true)
 {
   paper= (env->get_string (PAGE_MEDIUM) == "paper");
   br= make_bridge (this, et, ip);
@@ -165,7 +165,7 @@ typesetter_rep::typeset () {
     env->touched  = hashmap<string,bool> (false);
   }
   br->typeset (PROCESSED+ WANTED_PARAGRAPH);
-  pager ppp= tm_new<pager_rep> (br->ip, env, l);
+  pager ppp= tm_new<pager_rep> (br->ip, env, l, page_breaks);
   box rb= ppp->make_pages ();
   if (env->complete && paper) determine_page_references (rb);
   tm_delete (ppp);
@@ -194,6 +194,17 @@ typesetter_rep::typeset (SI& x1b, SI& y1b, SI& x2b, SI& y2b) {
   return b;
 }
 
+box
+typesetter_rep::typeset_pages () {
+  // Assemble the lines of the last run into pages once more, for instance
+  // with different margins, borders or headers. The lines themselves only
+  // depend on the text width, so they can be reused as they are.
+  pager ppp= tm_new<pager_rep> (br->ip, env, l, break_cache (true));
+  box rb= ppp->make_pages ();
+  tm_delete (ppp);
+  return rb;
+}
+
 /******************************************************************************
 * Event notification
 ******************************************************************************/
@@ -274,6 +285,30 @@ typeset (typesetter ttt, SI& x1, SI& y1, SI& x2, SI& y2) {
   return ttt->typeset (x1, y1, x2, y2);
 }
 
+box
+typeset_pages (typesetter ttt) {
+  ttt->env->style_init_env ();
+  ttt->env->update ();
+  return ttt->typeset_pages ();
+}
+
+bool
+only_page_layout_changed (hashmap<string,tree> screen_env,
+                          hashmap<string,tree> print_env) {
+  // When the screen is already typeset on paper with the same parameters
+  // as for printing, except for the margins, borders or headers and footers,
+  // then the lines of the screen can be assembled into pages once more.
+  // The printed flag must match, since links and canvases depend on it
+  iterator<string> it= iterate (screen_env);
+  while (it->busy ()) {
+    string var= it->next ();
+    if (var == PAGE_SHOW_HF || var == PAGE_SCREEN_MARGIN ||
+        var == PAGE_BORDER) continue;
+    if (print_env[var] != screen_env[var]) return false;
+  }
+  return print_env[PAGE_MEDIUM] == "paper";
+}
+
 box
 typeset_as_document (edit_env env, tree t, path ip) {
   env->style_init_env ();
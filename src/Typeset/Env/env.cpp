@@ -38,7 +38,8 @@ edit_env_rep::edit_env_rep (drd_info& drd2,
   local_ref (local_ref2), global_ref (global_ref2),
   local_aux (local_aux2), global_aux (global_aux2),
   local_att (local_att2), global_att (global_att2),
-  missing (UNINIT), redefined (), touched (false)
+  missing (UNINIT), redefined (), touched (false),
+  track_reads (false), read_vars (false), read_refs (false)
 {
   initialize_default_env ();
   initialize_default_var_type ();
@@ -46,6 +47,7 @@ edit_env_rep::edit_env_rep (drd_info& drd2,
   style_init_env ();
   update ();
   complete= false;
+  impure= 0;
   recover_env= tuple ();
   anim_start= anim_end= anim_portion= 0.0;
 }
@@ -49,6 +49,7 @@ edit_env_rep::rewrite (tree t) {
   case EXTERN:
     {
       int i, n= N(t);
+      impure++;
       if (n < 1) return tree (LABEL_ERROR, "invalid extern");
       string fun= tm_decode(exec_string (t[0]));
       tree r (TUPLE, n);
@@ -104,6 +105,7 @@ edit_env_rep::rewrite (tree t) {
     }
   case VAR_INCLUDE:
     {
+      impure++;
       if (N(t) == 0) return tree (LABEL_ERROR, "invalid include");
       url file_name= url_unix (exec_string (t[0]));
       url file_rel = relative (base_file_name, file_name);
@@ -114,6 +116,7 @@ edit_env_rep::rewrite (tree t) {
     }
   case WITH_PACKAGE:
     {
+      impure++;
       if (N(t) != 2) return tree (LABEL_ERROR, "invalid with-package");
       string file_name= exec_string (t[0]);
       return with_package_definitions (file_name, t[1]);
@@ -1607,6 +1610,7 @@ edit_env_rep::exec_number (tree t) {
 
 tree
 edit_env_rep::exec_date (tree t) {
+  impure++;
   if (N(t)>2) return tree (LABEL_ERROR, "bad date");
   string lan= get_string (LANGUAGE);
   if (N(t) == 2) {
@@ -1685,6 +1689,7 @@ edit_env_rep::exec_change_case (tree t) {
 tree
 edit_env_rep::exec_find_file (tree t) {
   int i, n=N(t);
+  impure++;
   array<tree> r (n);
   for (i=0; i<n; i++) {
     r[i]= exec (t[i]);
@@ -1714,6 +1719,7 @@ edit_env_rep::exec_find_file (tree t) {
 
 tree
 edit_env_rep::exec_find_file_upwards (tree t) {
+  impure++;
   if (N(t) < 1) return tree (LABEL_ERROR, "bad find file upwards");
   tree name= exec (t[0]);
   array<string> roots;
@@ -1995,6 +2001,7 @@ edit_env_rep::exec_set_binding (tree t) {
   }
   //cout << t << ": " << keys << " -> " << value << "\n";
 
+  impure++;
   for (int i=0; i<N(keys); i++) {
     string key= keys[i]->label;
     tree old_value= local_ref[key];
@@ -2028,6 +2035,7 @@ tree
 edit_env_rep::exec_get_binding (tree t) {
   if (N(t) != 1 && N(t) != 2) return tree (LABEL_ERROR, "bad get binding");
   string key= exec_string (t[0]);
+  if (track_reads) read_refs (key)= true;
   tree value= local_ref->contains (key)? local_ref [key]: global_ref [key];
   int type= (N(t) == 1? 0: as_int (exec_string (t[1])));
   if (type != 0 && type != 1) type= 0;
@@ -2046,6 +2054,7 @@ tree
 edit_env_rep::exec_has_binding (tree t) {
   if (N(t) != 1 && N(t) != 2) return tree (LABEL_ERROR, "bad get binding");
   string key= exec_string (t[0]);
+  if (track_reads) read_refs (key)= true;
   tree value= local_ref->contains (key)? local_ref [key]: global_ref [key];
   int type= (N(t) == 1? 0: as_int (exec_string (t[1])));
   if (type != 0 && type != 1) type= 0;
@@ -2058,6 +2067,7 @@ edit_env_rep::exec_has_binding (tree t) {
 tree
 edit_env_rep::exec_get_attachment (tree t) {
   if (N(t) != 1) return tree (LABEL_ERROR, "bad get attachment");
+  impure++;
   string key= exec_string (t[0]);
   tree value= local_att->contains (key)? local_att [key]: global_att [key];
   return value;
@@ -58,11 +58,15 @@ struct line_breaker_rep {
   SI  first_spc;
   SI  last_spc;
   int pass;
-  hashmap<path,lb_info> best;
+  array<lb_info>        item_best;  // best breaks before the items
+  hashmap<path,lb_info> best;       // best breaks inside hyphenated items
 
   line_breaker_rep (array<line_item> a, int start, int end,
 		    SI line_width, SI large_width, SI first_spc, SI last_spc);
 
+  lb_info get_best (path pos);
+  lb_info new_best (path pos);
+
   void empty_line_fix (line_item& first, path& pos, int& cur_nr);
   path next_ragged_break (path pos);
   array<path> compute_ragged_breaks ();
@@ -81,7 +85,25 @@ line_breaker_rep::line_breaker_rep (
     a (a2), start (start2), end (end2),
     line_width (line_width2), large_width (large_width2),
     first_spc (first_spc2), last_spc (last_spc2),
-    best (lb_info ()) {}
+    item_best (end2 - start2 + 1), best (lb_info ()) {}
+
+/******************************************************************************
+* The best breaks before the items are stored in a flat array,
+* only the breaks inside hyphenated items are stored in a hashmap
+******************************************************************************/
+
+lb_info
+line_breaker_rep::get_best (path pos) {
+  if (is_atom (pos)) return item_best[pos->item - start];
+  return best[pos];
+}
+
+lb_info
+line_breaker_rep::new_best (path pos) {
+  if (is_atom (pos)) return item_best[pos->item - start];
+  if (!best->contains (pos)) best (pos)= lb_info ();
+  return best[pos];
+}
 
 /******************************************************************************
 * Some subroutines
@@ -261,8 +283,7 @@ void
 line_breaker_rep::test_better (path new_pos, path old_pos,
 			       int pen, PEN pen_spc)
 {
-  if (!best->contains (new_pos)) best (new_pos)= lb_info ();
-  lb_info cur= best [new_pos];
+  lb_info cur= new_best (new_pos);
   //cout << "Test " << new_pos << " vs " << old_pos
   //     << ", " << pen << " vs " << cur->pen
   //     << ", " << pen_spc << " vs " << cur->pen_spc << "\n";
@@ -281,7 +302,7 @@ bool
 line_breaker_rep::propose_break (path new_pos, path old_pos,
 				 int pen, space spc)
 {
-  lb_info cur= best[old_pos];
+  lb_info cur= get_best (old_pos);
 
   if ((spc->min <= line_width) &&
       ((spc->max >= line_width) || (new_pos->item==end))) {
@@ -370,7 +391,7 @@ line_breaker_rep::process (path pos) {
     spc= space (first->b->w());
   }
 
-  if ((pass>1) || (best[pos]->pen < HYPH_INVALID)) {
+  if ((pass>1) || (get_best (pos)->pen < HYPH_INVALID)) {
     // cout << "Process " << pos << ": " << first << "\n";
     for (i=pos->item; i<end; i++) {
       line_item item= a[i];
@@ -413,7 +434,7 @@ line_breaker_rep::process (path pos) {
 void
 line_breaker_rep::get_breaks (array<path>& ap, path p) {
   if (is_nil (p)) return;
-  lb_info cur= best[p];
+  lb_info cur= get_best (p);
   get_breaks (ap, cur->prev);
   ap << p;
 }
@@ -428,7 +449,7 @@ line_breaker_rep::compute_breaks () {
     process (path (i));
 
   pass= 2;
-  if (best [path (end)]->pen == HYPH_INVALID)
+  if (get_best (path (end))->pen == HYPH_INVALID)
     for (i=start; i<end; i++)
       process (path (i));
 
@@ -447,6 +468,63 @@ line_breaker_rep::compute_breaks () {
   return ap;
 }
 
+/******************************************************************************
+* Cache for the line breaks of unchanged paragraphs
+*******************************************************************************
+* The breaks only depend on the widths, spaces and penalties of the items,
+* on the strings, fonts and languages of the hyphenatable items and on the
+* parameters of the paragraph. These are collected in a binary key, so that
+* paragraphs which are typeset again without changes are not broken again.
+******************************************************************************/
+
+#define LINE_BREAK_CACHE_MAX 1024
+
+static hashmap<string,array<path> > line_break_cache;
+
+static inline void
+lb_key (string& key, int x) {
+  key << ((char) (x & 255)) << ((char) ((x >> 8) & 255))
+      << ((char) ((x >> 16) & 255)) << ((char) ((x >> 24) & 255));
+}
+
+static inline void
+lb_key (string& key, string s) {
+  lb_key (key, N(s));
+  key << s;
+}
+
+static string
+line_breaks_key (array<line_item> a, int start, int end,
+                 SI line_width, SI large_width,
+                 SI first_spc, SI last_spc, bool ragged)
+{
+  string key;
+  lb_key (key, start);
+  lb_key (key, end);
+  lb_key (key, line_width);
+  lb_key (key, large_width);
+  lb_key (key, first_spc);
+  lb_key (key, last_spc);
+  lb_key (key, ragged? 1: 0);
+  for (int i=start; i<end; i++) {
+    line_item item= a[i];
+    lb_key (key, item->type);
+    lb_key (key, item->penalty);
+    lb_key (key, item->b->w());
+    lb_key (key, item->spc->min);
+    lb_key (key, item->spc->def);
+    lb_key (key, item->spc->max);
+    if (item->type == STRING_ITEM) {
+      lb_key (key, item->b->get_leaf_string ());
+      lb_key (key, item->b->get_leaf_font ()->res_name);
+      lb_key (key, item->lan->res_name);
+    }
+    else if (item->type == CONTROL_ITEM)
+      lb_key (key, item->t == LINE_BREAK? 1: 0);
+  }
+  return key;
+}
+
 /******************************************************************************
 * The exported line breaking routine
 *******************************************************************************
@@ -465,10 +543,16 @@ line_breaks (array<line_item> a, int start, int end,
 {
   int tol= 5;         // extra tolerance of 5tmpt avoid rounding errors when
   line_width += tol;  // the widths of the boxes sum up to precisely 1par
+  string key= line_breaks_key (a, start, end, line_width, large_width,
+                               first_spc, last_spc, ragged);
+  if (line_break_cache->contains (key)) return line_break_cache[key];
   line_breaker_rep* H=
     tm_new<line_breaker_rep> (a, start, end, line_width, large_width,
                               first_spc, last_spc);
   array<path> ap= ragged? H->compute_ragged_breaks (): H->compute_breaks ();
   tm_delete (H);
+  if (N(line_break_cache) >= LINE_BREAK_CACHE_MAX)
+    line_break_cache= hashmap<string,array<path> > ();
+  line_break_cache (key)= ap;
   return ap;
 }
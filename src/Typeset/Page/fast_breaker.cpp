@@ -0,0 +1,149 @@
+
+/******************************************************************************
+* MODULE     : fast_breaker.cpp
+* DESCRIPTION: Fast page breaking of a single flow on plain data
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "fast_breaker.hpp"
+#include "language.hpp"
+#include <QThreadPool>
+#include <QSemaphore>
+#include <atomic>
+int as_excentricity (SI diff);
+
+/******************************************************************************
+* Evaluation of the candidate pages
+******************************************************************************/
+
+fast_cost
+fast_flow::evaluate (int i1, int i2) const {
+  SI smin= 0, sdef= 0, smax= 0;
+  if (i1 == 0) {
+    if (i2 > 1) {
+      smin= tot_min[i2-2]; sdef= tot_def[i2-2]; smax= tot_max[i2-2]; }
+  }
+  else {
+    smin= tot_min[i2-2] - tot_min[i1-1];
+    sdef= tot_def[i2-2] - tot_def[i1-1];
+    smax= tot_max[i2-2] - tot_max[i1-1];
+  }
+  SI cor= cor_max[i1] + cor_def[i2-1] + cor_min[i2-1];
+  smin += cor; sdef += cor; smax += cor;
+
+  fast_cost c;
+  c.pen= (i2 >= n? 0: pens[i2-1]);
+  c.exc= 0;
+  c.valid= (c.pen < HYPH_INVALID);
+  c.short_page= (smax < h_min);
+  c.long_page = (smin > h_max);
+  if (!c.valid) return c;
+  if ((i2 < n) || (!last_page_flag))
+    c.exc += as_excentricity (sdef - h_def);
+  if (((i2 < n) || (!last_page_flag)) && (smax < h_def)) {
+    if (smax >= h_min) c.pen += EXTEND_PAGE_PENALTY;
+    else {
+      double factor=
+        ((double) std::max (sdef, 1))/((double) std::max (h_def, 1));
+      if (factor < 0.0 ) factor= 0.0;
+      if (factor > 0.99) factor= 0.99;
+      c.pen += (int) ((1.0 - factor) * TOO_SHORT_PENALTY);
+    }
+  }
+  else if (smin > h_def) {
+    if (smin <= h_max) c.pen += REDUCE_PAGE_PENALTY;
+    else {
+      double factor=
+        ((double) std::max (sdef, 1))/((double) std::max (h_def, 1));
+      if (factor < 1.0  ) factor= 1.0;
+      if (factor > 100.0) factor= 100.0;
+      c.pen += (int) (factor * TOO_LONG_PENALTY);
+    }
+  }
+  return c;
+}
+
+void
+fast_flow::candidates (int i1, std::vector<fast_cost>& v) const {
+  // All pages starting at i1 until the first necessarily overfull one
+  bool ok= false;
+  for (int i2= i1+1; true; i2++) {
+    fast_cost c= evaluate (i1, i2);
+    v.push_back (c);
+    if (c.valid) ok= true;
+    if ((i2 >= n) || (ok && c.long_page)) break;
+  }
+}
+
+void
+fast_flow::precompute (int start, int end,
+                       std::vector<std::vector<fast_cost> >& costs) const {
+  // Evaluate the candidate pages starting in [start, end) using the
+  // global thread pool. Jobs are only handed to idle threads and the
+  // calling thread takes part in the work, so we never wait for a pool
+  // which is busy with other tasks.
+  costs.assign (end - start, std::vector<fast_cost> ());
+  std::atomic<int> next (start);
+  auto work= [this, &next, &costs, start, end] () {
+    for (int i1= next++; i1 < end; i1= next++)
+      candidates (i1, costs[i1 - start]);
+  };
+  QThreadPool* pool= QThreadPool::globalInstance ();
+  QSemaphore done;
+  int started= 0;
+  for (int t=1; t<pool->maxThreadCount (); t++)
+    if (pool->tryStart ([&work, &done] () { work (); done.release (); }))
+      started++;
+    else break;
+  work ();
+  done.acquire (started);
+}
+
+/******************************************************************************
+* Dynamic programming
+******************************************************************************/
+
+void
+fast_flow::break_pages (std::vector<int>& prev, bool parallel) const {
+  // Compute the best previous break prev[i] for each break i, as in the
+  // original sequential algorithm. In parallel mode, the candidate pages
+  // are evaluated in advance for blocks of page starts.
+  int i;
+  std::vector<int> best_pen (n+1, HYPH_INVALID), best_exc (n+1, 0);
+  std::vector<std::vector<fast_cost> > costs;
+  prev.assign (n+1, -1);
+  prev[0]= -2;
+  best_pen[0]= 0;
+
+  int base= 0, first_end= 0;
+  for (i=0; i<n; i++) {
+    if (parallel && (i % FAST_BLOCK) == 0) {
+      base= i;
+      precompute (i, std::min (i + FAST_BLOCK, n), costs);
+    }
+    if (prev[i] == -1) continue;
+
+    first_end= std::max (i+1, first_end);
+    bool ok= false;
+    for (int i2= first_end; true; i2++) {
+      int k= i - base, j= i2 - i - 1;
+      fast_cost c= (parallel && j < (int) costs[k].size ()?
+                    costs[k][j]: evaluate (i, i2));
+      if (c.valid) {
+        ok= true;
+        if (c.short_page) first_end= i2;
+        int pen= best_pen[i] + c.pen, exc= best_exc[i] + c.exc;
+        if (pen < best_pen[i2] || (pen == best_pen[i2] && exc < best_exc[i2])) {
+          prev[i2]= i;
+          best_pen[i2]= pen;
+          best_exc[i2]= exc;
+        }
+      }
+      if ((i2 >= n) || (ok && c.long_page)) break;
+    }
+  }
+}
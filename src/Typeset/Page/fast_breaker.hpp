@@ -0,0 +1,47 @@
+
+/******************************************************************************
+* MODULE     : fast_breaker.hpp
+* DESCRIPTION: Fast page breaking of a single flow on plain data
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+*******************************************************************************
+* The fast page breaking routines only need the cumulated heights of the
+* main flow and the penalties of its lines. We copy them into plain arrays,
+* so that the candidate pages can be evaluated by several threads: the
+* reference counting of spaces and penalties is not thread safe.
+******************************************************************************/
+
+#ifndef FAST_BREAKER_H
+#define FAST_BREAKER_H
+#include "vpenalty.hpp"
+#include <vector>
+
+#define FAST_PARALLEL_MIN  8192  // minimal number of lines for threads
+#define FAST_BLOCK         1024  // number of page starts per block
+
+struct fast_cost {
+  int  pen, exc;   // penalty of the page, without the previous pages
+  bool valid;      // whether the page may end here
+  bool short_page; // whether the page cannot be filled up to here
+  bool long_page;  // whether the page is necessarily overfull here
+};
+
+struct fast_flow {
+  int  n;
+  bool last_page_flag;
+  SI   h_min, h_def, h_max;
+  std::vector<SI>  tot_min, tot_def, tot_max;
+  std::vector<SI>  cor_min, cor_def, cor_max;
+  std::vector<int> pens;
+
+  fast_cost evaluate (int i1, int i2) const;
+  void candidates (int i1, std::vector<fast_cost>& v) const;
+  void precompute (int start, int end,
+                   std::vector<std::vector<fast_cost> >& costs) const;
+  void break_pages (std::vector<int>& prev, bool parallel) const;
+};
+
+#endif // defined FAST_BREAKER_H
@@ -21,7 +21,7 @@ page_item access (array<page_item> l, path p);
 space as_space (tree t);
 skeleton break_pages (array<page_item> l, space ph, int qual,
 		      space fn_sep, space fnote_sep, space float_sep,
-                      font fn, int first_page);
+                      font fn, int first_page, break_cache cache);
 box page_box (path ip, box b, tree page, int page_nr, brush bgc,
               SI width, SI height, SI left, SI top,
 	      SI bot, box header, box footer, SI head_sep, SI foot_sep);
@@ -200,7 +200,7 @@ pager_rep::pages_make () {
   space ht (text_height- may_shrink, text_height, text_height+ may_extend);
   skeleton sk=
     break_pages (l, ht, quality, fn_sep, fnote_sep, float_sep,
-                 env->fn, env->first_page);
+                 env->fn, env->first_page, cache);
   int i, n= N(sk);
   for (i=0; i<n; i++)
     pages << pages_make_page (sk[i]);
@@ -211,7 +211,7 @@ pager_rep::papyrus_make () {
   space ht (MAX_SI >> 1);
   skeleton sk=
     break_pages (l, ht, quality, fn_sep, fnote_sep, float_sep,
-                 env->fn, env->first_page);
+                 env->fn, env->first_page, cache);
   if (N(sk) != 1) {
     failed_error << "Number of pages: " << N(sk) << "\n";
     TM_FAILED ("unexpected situation");
@@ -49,7 +49,7 @@ as_space (tree t) {
 new_breaker_rep::new_breaker_rep (
   array<page_item> l2, space ph, int quality2,
   space fn_sep2, space fnote_sep2, space float_sep2,
-  font fn2, int fp2):
+  font fn2, int fp2, break_cache cache2):
     l (l2), papyrus_mode (ph == (MAX_SI >> 1)), height (ph),
     fn_sep (fn_sep2), fnote_sep (fnote_sep2), float_sep (float_sep2),
     fn (fn2), first_page (fp2), quality (quality2), last_page_flag (true),
@@ -57,6 +57,9 @@ new_breaker_rep::new_breaker_rep (
     float_ht (), float_tot (), ins_list (),
     best_prev (path (-1)), best_pens (MAX_SI),
     todo_list (false), done_list (false),
+    wave (-1), start_pen (MAX_SI), reach (-1), cur_wave (0), max_reach (0),
+    cache (cache2), old_n (-1), first_mod (0), sync_mod (0),
+    replay (false),
     cache_uniform (array<path> ()),
     cache_colbreaks (array<path> ())
 {
@@ -263,13 +266,19 @@ new_breaker_rep::last_break (path b) {
 
 void
 new_breaker_rep::find_page_breaks (path b1) {
+  find_page_breaks (b1, best_pens [b1]);
+}
+
+void
+new_breaker_rep::find_page_breaks (path b1, vpenalty prev_pen) {
   path b1x= b1;
   if (must_break[b1x->item] && b1x->item < N(l))
     b1x= path (b1x->item + 1, b1x->next);
   //cout << "Find page breaks " << b1 << LF;
   bool ok= false, found_one= false;
-  vpenalty prev_pen= best_pens [b1];
-  int n= N(l);
+  wave (b1)= cur_wave;
+  start_pen (b1)= prev_pen;
+  int n= N(l), last= b1->item;
   int float_status= 0;
   path floats;
   path b2= b1;
@@ -309,6 +318,7 @@ new_breaker_rep::find_page_breaks (path b1) {
       b2= path (i+1, floats);
     }
     if (b2->item > n) break;
+    last= std::max (last, b2->item);
     bool break_page= must_break[b2->item];
     if (must_new[b2->item]) b2= path (b2->item);
     
@@ -368,6 +378,8 @@ new_breaker_rep::find_page_breaks (path b1) {
     if (ok && spc->min > height->max && is_nil (b2->next)) break;
     if (break_page && is_nil (b2->next)) break;
   }
+  reach (b1)= last;
+  max_reach= std::max (max_reach, last);
 }
 
 /******************************************************************************
@@ -381,14 +393,25 @@ new_breaker_rep::find_page_breaks () {
   //  cout << "  " << i << ": \t" << l[i]
   //       << ", " << body_ht[i]
   //       << ", " << body_cor[i] << ", " << body_tot[i] << LF;
-  todo_list (path (0))= true;  
-  while (N(todo_list) != 0) {
+  todo_list (path (0))= true;
+  if (quality>1 && !is_nil (cache) && same_parameters ()) reuse_breaks ();
+  cur_wave= 0;
+  while (N(todo_list) != 0 || cur_wave < N(replay_waves)) {
     hashmap<path,bool> temp_list= todo_list;
     todo_list= hashmap<path,bool> (false);
+    if (cur_wave < N(replay_waves))
+      for (int i=0; i<N(replay_waves[cur_wave]); i++)
+        temp_list (replay_waves[cur_wave][i])= true;
     done_list->join (temp_list);
     if (quality>1) {
-      for (iterator<path> it= iterate (temp_list); it->busy (); )
-        find_page_breaks (it->next ());
+      bool frontier= N(temp_list) == 1 && cur_wave+1 >= N(replay_waves);
+      for (iterator<path> it= iterate (temp_list); it->busy (); ) {
+        path b1= it->next ();
+        if (replay->contains (b1))
+          find_page_breaks (b1, cache->start_pen [b1]);
+        else if (!resync_breaks (b1, frontier))
+          find_page_breaks (b1);
+      }
     }
     else {
       path best_start;
@@ -403,10 +426,180 @@ new_breaker_rep::find_page_breaks () {
       if (best_start == path (N(l))) break;
       find_page_breaks (best_start);
     }
+    cur_wave++;
   }
   //cout << "Found page breaks" << LF;
 }
 
+/******************************************************************************
+* Incremental page breaking
+******************************************************************************/
+
+static bool
+same_item (page_item it1, break_cache cache, int i) {
+  page_item it2= cache->items[i];
+  if (it1->type != it2->type || it1->b != it2->b ||
+      it1->penalty != cache->pens[i] || it1->nr_cols != it2->nr_cols ||
+      it1->spc->min != cache->spc_min[i] ||
+      it1->spc->def != cache->spc_def[i] ||
+      it1->spc->max != cache->spc_max[i] ||
+      it1->t != it2->t || N(it1->fl) != N(it2->fl))
+    return false;
+  for (int i=0; i<N(it1->fl); i++)
+    if (!(it1->fl[i] == it2->fl[i])) return false;
+  return true;
+}
+
+static path
+shift_floats (path fl, int delta) {
+  if (is_nil (fl)) return fl;
+  path r= shift_floats (fl->next->next, delta);
+  return path (fl->item + delta, path (fl->next->item, r));
+}
+
+static path
+shift_break (path b, int delta) {
+  // The same break after inserting delta page items before it
+  if (is_nil (b) || b->item < 0) return b;
+  return path (b->item + delta, shift_floats (b->next, delta));
+}
+
+static vpenalty
+shift_penalty (vpenalty pen, vpenalty old_base, vpenalty new_base) {
+  return vpenalty (pen->pen - old_base->pen + new_base->pen,
+                   pen->exc - old_base->exc + new_base->exc);
+}
+
+bool
+new_breaker_rep::same_parameters () {
+  return cache->quality == quality && cache->height == height &&
+         cache->fn_name == fn->res_name && cache->fn_sep == fn_sep &&
+         cache->fnote_sep == fnote_sep && cache->float_sep == float_sep;
+}
+
+void
+new_breaker_rep::reuse_breaks () {
+  // Breaks before the first modified page item are those of the previous
+  // run. Those breaks which were expanded beyond that item are expanded
+  // again in the same wave and starting with the same penalty.
+  old_n= N(cache->items);
+  int n= N(l), m= std::min (n, old_n);
+  first_mod= 0;
+  while (first_mod < m && same_item (l[first_mod], cache, first_mod))
+    first_mod++;
+  int same= 0;
+  while (same < m - first_mod &&
+         same_item (l[n-1-same], cache, old_n-1-same))
+    same++;
+  sync_mod= n - same;
+
+  // The page items k such that no page of the previous run started before k
+  // and ended after k, and such that k was only expanded without floats
+  array<int> reach_before (old_n + 1);
+  old_cut= array<bool> (old_n + 1);
+  for (int k=0; k<=old_n; k++) { reach_before[k]= -1; old_cut[k]= true; }
+  for (iterator<path> it= iterate (cache->wave); it->busy (); ) {
+    path b= it->next ();
+    if (b->item >= old_n) continue;
+    reach_before[b->item]= std::max (reach_before[b->item], cache->reach [b]);
+    if (!is_nil (b->next)) old_cut[b->item]= false;
+  }
+  int r= -1;
+  for (int k=0; k<=old_n; k++) {
+    if (r > k) old_cut[k]= false;
+    r= std::max (r, reach_before[k]);
+  }
+  if (first_mod == 0) return;
+
+  todo_list= hashmap<path,bool> (false);
+  for (iterator<path> it= iterate (cache->best_prev); it->busy (); ) {
+    path b= it->next ();
+    if (b->item >= first_mod) continue;
+    best_prev (b)= cache->best_prev [b];
+    best_pens (b)= cache->best_pens [b];
+  }
+  for (iterator<path> it= iterate (cache->wave); it->busy (); ) {
+    path b= it->next ();
+    if (b->item >= first_mod) continue;
+    done_list (b)= true;
+    if (cache->reach [b] < first_mod) {
+      wave (b)     = cache->wave [b];
+      start_pen (b)= cache->start_pen [b];
+      reach (b)    = cache->reach [b];
+    }
+    else {
+      int w= cache->wave [b];
+      while (N(replay_waves) <= w) replay_waves << array<path> ();
+      replay_waves[w] << b;
+      replay (b)= true;
+    }
+  }
+}
+
+bool
+new_breaker_rep::resync_breaks (path b1, bool frontier) {
+  // Once no page crosses a page item in the unmodified part of the document,
+  // neither in the previous run, nor in the current one, all further breaks
+  // are those of the previous run, shifted by the number of inserted page
+  // items and by the difference of the penalties. This is the case after
+  // compulsory new pages, or when b1 is the only break left to be expanded.
+  if (old_n < 0 || !is_nil (b1->next)) return false;
+  int k= b1->item, delta= N(l) - old_n;
+  if (k < first_mod || k < sync_mod || k >= N(l)) return false;
+  if (!must_new[k] && !(frontier && max_reach <= k && old_cut[k - delta]))
+    return false;
+  path ob1 (k - delta);
+  if (!cache->wave->contains (ob1)) return false;
+  vpenalty old_base= cache->start_pen [ob1];
+  vpenalty new_base= best_pens [b1];
+  int dw= cur_wave - cache->wave [ob1];
+  for (iterator<path> it= iterate (cache->best_prev); it->busy (); ) {
+    path ob= it->next ();
+    if (ob->item <= ob1->item) continue;
+    path b= shift_break (ob, delta);
+    best_prev (b)= shift_break (cache->best_prev [ob], delta);
+    best_pens (b)= shift_penalty (cache->best_pens [ob], old_base, new_base);
+    done_list (b)= true;
+  }
+  for (iterator<path> it= iterate (cache->wave); it->busy (); ) {
+    path ob= it->next ();
+    if (ob->item < ob1->item) continue;
+    path b= shift_break (ob, delta);
+    wave (b)     = cache->wave [ob] + dw;
+    start_pen (b)= shift_penalty (cache->start_pen [ob], old_base, new_base);
+    reach (b)    = cache->reach [ob] + delta;
+  }
+  return true;
+}
+
+void
+new_breaker_rep::save_breaks () {
+  if (is_nil (cache)) return;
+  int n= N(l);
+  cache->items  = l;
+  cache->pens   = array<int> (n);
+  cache->spc_min= array<SI> (n);
+  cache->spc_def= array<SI> (n);
+  cache->spc_max= array<SI> (n);
+  for (int i=0; i<n; i++) {
+    cache->pens[i]   = l[i]->penalty;
+    cache->spc_min[i]= l[i]->spc->min;
+    cache->spc_def[i]= l[i]->spc->def;
+    cache->spc_max[i]= l[i]->spc->max;
+  }
+  cache->height   = height;
+  cache->quality  = quality;
+  cache->fn_name  = fn->res_name;
+  cache->fn_sep   = fn_sep;
+  cache->fnote_sep= fnote_sep;
+  cache->float_sep= float_sep;
+  cache->best_prev= best_prev;
+  cache->best_pens= best_pens;
+  cache->wave     = wave;
+  cache->start_pen= start_pen;
+  cache->reach    = reach;
+}
+
 /******************************************************************************
 * Formatting pagelets
 ******************************************************************************/
@@ -725,13 +918,14 @@ new_breaker_rep::assemble_skeleton (skeleton& sk, path end, int& offset) {
 skeleton
 new_break_pages (array<page_item> l, space ph, int qual,
                  space fn_sep, space fnote_sep, space float_sep,
-                 font fn, int first_page)
+                 font fn, int first_page, break_cache cache)
 {
   new_breaker_rep* H=
     tm_new<new_breaker_rep> (l, ph, qual, fn_sep, fnote_sep, float_sep,
-                             fn, first_page);
+                             fn, first_page, cache);
   //cout << HRULE << LF;
   H->find_page_breaks ();
+  H->save_breaks ();
   //cout << HRULE << LF;
   skeleton sk;
   int offset= first_page - 1;
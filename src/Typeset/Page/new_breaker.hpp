@@ -16,6 +16,45 @@
 #include "skeleton.hpp"
 #include "iterator.hpp"
 
+/******************************************************************************
+* The page breaks of a previous run, which are reused when the document is
+* page broken again. The breaker expands the possible breaks in waves; for
+* each expanded break we remember the wave, its penalty at that moment and
+* the last page item which was inspected. This allows us to replay the
+* expansion of the breaks before the first modified page item, and to
+* copy the breaks behind the last one, as soon as no page crosses a given
+* page item. The page items are shared with the typesetter, which may
+* adjust their penalties and spaces in place, so we keep the latter apart.
+******************************************************************************/
+
+struct break_cache_rep: concrete_struct {
+  array<page_item>       items;      // the page items
+  array<int>             pens;       // their penalties
+  array<SI>              spc_min;    // and their spaces
+  array<SI>              spc_def;
+  array<SI>              spc_max;
+  space                  height;     // the page height
+  int                    quality;    // quality of page breaking
+  string                 fn_name;    // name of the font
+  space                  fn_sep;     // footnote separations
+  space                  fnote_sep;  // separation between text and notes
+  space                  float_sep;  // float separations
+  hashmap<path,path>     best_prev;  // best previous break points
+  hashmap<path,vpenalty> best_pens;  // corresponding penalties
+  hashmap<path,int>      wave;       // wave in which a break was expanded
+  hashmap<path,vpenalty> start_pen;  // its penalty at that moment
+  hashmap<path,int>      reach;      // last page item inspected for it
+  inline break_cache_rep ():
+    quality (-1), best_prev (path (-1)), best_pens (MAX_SI),
+    wave (-1), start_pen (MAX_SI), reach (-1) {}
+};
+
+class break_cache {
+  CONCRETE_NULL(break_cache);
+  inline break_cache (bool): rep (tm_new<break_cache_rep> ()) {}
+};
+CONCRETE_NULL_CODE(break_cache);
+
 struct new_breaker_rep {
   array<page_item> l;
   int   papyrus_mode;
@@ -50,19 +89,37 @@ struct new_breaker_rep {
   hashmap<path,vpenalty>   best_pens;  // corresponding penalties
   hashmap<path, bool>      todo_list;
   hashmap<path, bool>      done_list;
+  hashmap<path,int>        wave;       // wave in which a break was expanded
+  hashmap<path,vpenalty>   start_pen;  // its penalty at that moment
+  hashmap<path,int>        reach;      // last page item inspected for it
+  int                      cur_wave;   // the current wave
+  int                      max_reach;  // maximal reach of expanded breaks
+
+  break_cache              cache;      // breaks of the previous run
+  int                      old_n;      // nr of page items of that run or -1
+  int                      first_mod;  // first modified page item
+  int                      sync_mod;   // unmodified page items from here on
+  array<bool>              old_cut;    // no page of that run crossed here
+  hashmap<path,bool>       replay;     // breaks whose expansion is replayed
+  array<array<path> >      replay_waves; // the same breaks, by wave
  
   hashmap<path,array<path> > cache_uniform;
   hashmap<path,array<path> > cache_colbreaks;
  
   new_breaker_rep (array<page_item> l, space ph, int quality,
                    space fn_sep, space fnote_sep, space float_sep,
-                   font fn, int fp);
+                   font fn, int fp, break_cache cache);
 
   insertion make_insertion (lazy_vstream lvs, path p);
   space compute_space (path b1, path b2, bool wide_part= false);
   bool last_break (path b);
   void find_page_breaks (path i1);
+  void find_page_breaks (path i1, vpenalty prev_pen);
   void find_page_breaks ();
+  bool same_parameters ();
+  void reuse_breaks ();
+  bool resync_breaks (path b1, bool frontier);
+  void save_breaks ();
   vpenalty format_insertion (insertion& ins, double stretch);
   vpenalty format_pagelet (pagelet& pg, double stretch);
   vpenalty format_pagelet (pagelet& pg, space ht, bool last_page);
@@ -11,8 +11,9 @@
 
 #include "Line/lazy_vstream.hpp"
 #include "vpenalty.hpp"
-#include "skeleton.hpp"
+#include "new_breaker.hpp"
 #include "boot.hpp"
+#include "fast_breaker.hpp"
 
 #include "merge_sort.hpp"
 void sort (pagelet& pg);
@@ -87,6 +88,8 @@ struct page_breaker_rep {
   array<vpenalty>     best_pens;  // corresponding penalties
   array<pagelet>      best_pgs;   // & pagelets
 
+  fast_flow           fast_fl;    // plain copy of the main flow
+
   page_breaker_rep (array<page_item> l, space ph, int quality,
                     space fn_sep, space fnote_sep, space float_sep,
                     font fn, int fp);
@@ -126,7 +129,7 @@ struct page_breaker_rep {
   int tc_propose_break (path flb);
   insertion make_two_column (int start, int end, path flb);
 
-  void fast_break_page (int i1, int& first_end);
+  void fast_init_flow ();
   void fast_assemble_skeleton (skeleton& sk, int end);
   void fast_assemble_skeleton (skeleton& sk);
 
@@ -1216,53 +1219,25 @@ page_breaker_rep::make_two_column (int start, int end, path flb) {
 ******************************************************************************/
 
 void
-page_breaker_rep::fast_break_page (int i1, int& first_end) {
-  first_end= std::max (i1+1, first_end);
-  bool ok= false;
-  int i2= first_end, n= N(flow[0]);
-  while (true) {
-    space spc;
-    if (i1 == 0) { if (i2 > 1) spc= copy (flow_tot[0][i2-2]); }
-    else spc= flow_tot[0][i2-2] - flow_tot[0][i1-1];
-    SI top_cor= flow_cor[0][i1]->max;
-    SI bot_cor= flow_cor[0][i2-1]->min;
-    spc += space (top_cor + flow_cor[0][i2-1]->def + bot_cor);
-    
-    int bpen= access (l, flow[0][i2-1])->penalty;
-    if (i2 >= n) bpen= 0;
-    if (bpen < HYPH_INVALID) {
-      ok= true;
-      if (spc->max < height->min) first_end= i2;
-      vpenalty pen= best_pens[i1] + vpenalty (bpen);
-      if ((i2 < n) || (!last_page_flag))
-	pen += as_vpenalty (spc->def - height->def);
-      if (((i2 < n) || (!last_page_flag)) && (spc->max < height->def)) {
-	if (spc->max >= height->min) pen += EXTEND_PAGE_PENALTY;
-	else {
-	  double factor=
-	    ((double) std::max (spc->def, 1))/((double) std::max (height->def, 1));
-	  if (factor < 0.0 ) factor= 0.0;
-	  if (factor > 0.99) factor= 0.99;
-	  pen += vpenalty ((int) ((1.0 - factor) * TOO_SHORT_PENALTY));
-	}
-      }
-      else if (spc->min > height->def) {
-	if (spc->min <= height->max) pen += REDUCE_PAGE_PENALTY;
-	else {
-	  double factor=
-	    ((double) std::max (spc->def, 1))/((double) std::max (height->def, 1));
-	  if (factor < 1.0  ) factor= 1.0;
-	  if (factor > 100.0) factor= 100.0;
-	  pen += vpenalty ((int) (factor * TOO_LONG_PENALTY));
-	}
-      }
-      if (pen < best_pens[i2]) {
-	best_prev[i2]= i1;
-	best_pens[i2]= pen;
-      }
-    }
-    if ((i2 >= n) || (ok && (spc->min > height->max))) break;
-    i2++;
+page_breaker_rep::fast_init_flow () {
+  int i, n= N(flow[0]);
+  fast_fl.n= n;
+  fast_fl.last_page_flag= last_page_flag;
+  fast_fl.h_min= height->min;
+  fast_fl.h_def= height->def;
+  fast_fl.h_max= height->max;
+  fast_fl.tot_min.resize (n); fast_fl.cor_min.resize (n);
+  fast_fl.tot_def.resize (n); fast_fl.cor_def.resize (n);
+  fast_fl.tot_max.resize (n); fast_fl.cor_max.resize (n);
+  fast_fl.pens.resize (n);
+  for (i=0; i<n; i++) {
+    fast_fl.tot_min[i]= flow_tot[0][i]->min;
+    fast_fl.tot_def[i]= flow_tot[0][i]->def;
+    fast_fl.tot_max[i]= flow_tot[0][i]->max;
+    fast_fl.cor_min[i]= flow_cor[0][i]->min;
+    fast_fl.cor_def[i]= flow_cor[0][i]->def;
+    fast_fl.cor_max[i]= flow_cor[0][i]->max;
+    fast_fl.pens[i]= access (l, flow[0][i])->penalty;
   }
 }
 
@@ -1282,19 +1257,13 @@ page_breaker_rep::fast_assemble_skeleton (skeleton& sk, int end) {
 void
 page_breaker_rep::fast_assemble_skeleton (skeleton& sk) {
   int i, n= N(flow[0]);
+  bool parallel= n >= FAST_PARALLEL_MIN &&
+    get_user_preference ("parallel page breaking", "on") != "off";
+  std::vector<int> prev;
+  fast_init_flow ();
+  fast_fl.break_pages (prev, parallel);
   best_prev= array<int> (n+1);
-  best_pens= array<vpenalty> (n+1);
-  for (i=0; i<=n; i++) {
-    best_prev [i]= -1;
-    best_pens [i]= HYPH_INVALID;
-  }
-  best_prev[0]= -2;
-  best_pens[0]= vpenalty (0, 0);
-  
-  int first_end= 0;
-  for (i=0; i<n; i++)
-    if (best_prev[i] != -1)
-      fast_break_page (i, first_end);
+  for (i=0; i<=n; i++) best_prev[i]= prev[i];
   fast_assemble_skeleton (sk, n);
 }
 
@@ -1500,16 +1469,16 @@ page_breaker_rep::make_skeleton () {
 
 skeleton new_break_pages (array<page_item> l, space ph, int qual,
                           space fn_sep, space fnote_sep, space float_sep,
-                          font fn, int first_page);
+                          font fn, int first_page, break_cache cache);
 
 skeleton
 break_pages (array<page_item> l, space ph, int qual,
 	     space fn_sep, space fnote_sep, space float_sep,
-             font fn, int first_page)
+             font fn, int first_page, break_cache cache)
 {
   if (get_user_preference ("new style page breaking") != "off")
     return new_break_pages (l, ph, qual, fn_sep, fnote_sep, float_sep,
-                            fn, first_page);
+                            fn, first_page, cache);
   else {
     page_breaker_rep* H=
       tm_new<page_breaker_rep> (l, ph, qual, fn_sep, fnote_sep, float_sep,
@@ -16,8 +16,9 @@
 * Routines for the pager class
 ******************************************************************************/
 
-pager_rep::pager_rep (path ip2, edit_env env2, array<page_item> l2):
-  ip (ip2), env (env2), style (UNINIT), l (l2)
+pager_rep::pager_rep (path ip2, edit_env env2, array<page_item> l2,
+                      break_cache cache2):
+  ip (ip2), env (env2), style (UNINIT), l (l2), cache (cache2)
 {
   style (PAGE_THE_PAGE)     = tree (MACRO, compound ("page-nr"));
   style (PAGE_ODD_HEADER)   = env->read (PAGE_ODD_HEADER);
@@ -16,6 +16,7 @@
 #include "Format/page_item.hpp"
 #include "Format/stack_border.hpp"
 #include "Page/skeleton.hpp"
+#include "Page/new_breaker.hpp"
 
 class pager_rep {
 public:
@@ -23,6 +24,7 @@ public:
   edit_env             env;
   hashmap<string,tree> style;
   array<page_item>     l;
+  break_cache          cache;
 
   bool         paper;
   int          quality;
@@ -72,7 +74,8 @@ protected: // making page boxes
   void papyrus_make ();
 
 public:
-  pager_rep (path ip, edit_env env, array<page_item> l);
+  pager_rep (path ip, edit_env env, array<page_item> l,
+             break_cache cache= break_cache ());
 
   //void start_page ();
   //void print (page_item item);
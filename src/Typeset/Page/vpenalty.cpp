@@ -16,12 +16,17 @@ operator << (tm_ostream& out, vpenalty pen) {
   return out << "[ " << pen->pen << ", " << pen->exc << " ]";
 }
 
+int
+as_excentricity (SI diff) {
+  if (diff < 0) diff= -diff;
+  if (diff < 0x1000) return (diff*diff) >> 16;
+  else if (diff < 0x100000) return (diff >> 8) * (diff >> 8);
+  else return 0x1000000;
+}
+
 vpenalty
 as_vpenalty (SI diff) {
-  if (diff < 0) diff= -diff;
-  if (diff < 0x1000) return vpenalty (0, (diff*diff) >> 16);
-  else if (diff < 0x100000) return vpenalty (0, (diff >> 8) * (diff >> 8));
-  else return vpenalty (0, 0x1000000);
+  return vpenalty (0, as_excentricity (diff));
 }
 
 SI
@@ -150,9 +150,13 @@ public:
   hashmap<string,tree>&        global_att;
   bool                         complete;    // typeset complete document ?
   bool                         read_only;   // write-protected ?
+  int                          impure;      // nr of impure evaluations
   hashmap<string,tree>         missing;     // missing refs
   array<tree>                  redefined;   // redefined labels
   hashmap<string,bool>         touched;     // touched refs
+  bool                         track_reads; // record the variables read ?
+  hashmap<string,bool>         read_vars;   // variables read while tracking
+  hashmap<string,bool>         read_refs;   // references read while tracking
   link_repository              link_env;    // current links
   array<array<int> >           size_cache;  // math font size cache
   array<rectangle>             white_zones; // text exclusion zones for curves
@@ -471,7 +475,9 @@ public:
     tree& val= env (s); t= exec(t); if (val != t) {
       back->write_back (s, env); val= t; update (s); } }
   inline bool provides (string s) { return env->contains (s); }
-  inline tree read (string s) { return env [s]; }
+  inline tree read (string s) {
+    if (track_reads) read_vars (s)= true;
+    return env [s]; }
   tree local_begin_extents (box b);
   void local_end_extents (tree t);
 
@@ -543,29 +549,29 @@ public:
 
   /* retrieving environment variables */
   inline bool get_bool (string var) {
-    tree t= env [var];
+    tree t= read (var);
     if (is_compound (t)) return false;
     return as_bool (t->label); }
   inline int get_int (string var) {
-    tree t= env [var];
+    tree t= read (var);
     if (is_compound (t)) return 0;
     return as_int (t->label); }
   inline double get_double (string var) {
-    tree t= env [var];
+    tree t= read (var);
     if (is_compound (t)) return 0.0;
     return as_double (t->label); }
   inline string get_string (string var) {
-    tree t= env [var];
+    tree t= read (var);
     if (is_compound (t)) return "";
     return t->label; }
   inline SI get_length (string var) {
-    tree t= env [var];
+    tree t= read (var);
     return as_length (t); }
   inline space get_vspace (string var) {
-    tree t= env [var];
+    tree t= read (var);
     return as_vspace (t); }
   inline color get_color (string var) {
-    tree t= env [var];
+    tree t= read (var);
     return named_color (as_string (t), alpha); }
 
   friend class edit_env;
@@ -32,6 +32,9 @@ void notify_insert_node (typesetter ttt, path p, tree t);
 void notify_remove_node (typesetter ttt, path p);
 void exec_until         (typesetter ttt, path p);
 box  typeset            (typesetter ttt, SI& x1, SI& y1, SI& x2, SI& y2);
+box  typeset_pages      (typesetter ttt);
+bool only_page_layout_changed (hashmap<string,tree> screen_env,
+                               hashmap<string,tree> print_env);
 
 box        typeset_as_concat (edit_env env, tree t, path ip);
 box        typeset_as_box (edit_env env, tree t, path ip);
@@ -7,86 +7,280 @@
 
 #include <mutex>
 #include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <utility>
 #include <condition_variable>
 
 namespace texmacs {
 
+    /**
+     * @brief A bounded multi-producer multi-consumer queue.
+     *
+     * Pushing and popping are lock-free as long as the queue is neither full nor empty: each cell carries
+     * a sequence number telling whether it is ready to be written or read for the current lap of the ring.
+     * A producer (resp. consumer) only blocks when the queue is full (resp. empty), and then sleeps on a
+     * condition variable until a consumer (resp. producer) notifies it. The mutex is only taken by the
+     * blocked threads and by the threads which have to wake them up.
+     *
+     * @tparam T The type of the elements, which must be default constructible and movable.
+     * @tparam C The minimal capacity of the queue, rounded up to a power of two.
+     */
     template <typename T, int C> class thread_safe_queue
     {
     public:
         thread_safe_queue() {
-            mSize = 0;
-            mPushIndex = 0;
-            mPopIndex = 0;
+            for (size_t i = 0; i < Capacity; i++) {
+                mCells[i].sequence.store(i, std::memory_order_relaxed);
+            }
         }
 
-        inline T *getPushElement() {
+        thread_safe_queue(const thread_safe_queue&) = delete;
+        thread_safe_queue& operator=(const thread_safe_queue&) = delete;
+
+        /**
+         * @brief Pushes an element, without blocking.
+         * @return false if the queue is full or destroyed.
+         */
+        inline bool tryPush(T element) {
             if (mIsDestroyed) {
-                return &mElements[mPushIndex];
+                return false;
             }
-            std::unique_lock<std::mutex> lock(mMutex);
-            while (mSize == C) {
-                mConditionVariable.wait_for(lock, std::chrono::milliseconds(10));
-                if (mIsDestroyed) {
-                    return &mElements[mPushIndex];
-                }
+            if (!enqueue(element)) {
+                return false;
             }
-            T *element = &mElements[mPushIndex];
-            return element;
+            notify(mPopWaiters, mNotEmpty);
+            return true;
         }
 
-        inline void notifyPush() {
-            mPushIndex = (mPushIndex + 1) % C;
-            mSize++;
-            mConditionVariable.notify_all();
+        /**
+         * @brief Pushes an element, blocking while the queue is full.
+         * @return false if the queue has been destroyed.
+         */
+        inline bool push(T element) {
+            if (mIsDestroyed) {
+                return false;
+            }
+            if (enqueue(element)) {
+                notify(mPopWaiters, mNotEmpty);
+                return true;
+            }
+            auto start = std::chrono::steady_clock::now();
+            std::unique_lock<std::mutex> lock(mMutex);
+            mPushWaiters++;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            while (!mIsDestroyed && !enqueue(element)) {
+                mNotFull.wait(lock);
+            }
+            mPushWaiters--;
+            lock.unlock();
+            addWaitTime(mPushWaits, mPushWaitTime, start);
+            if (mIsDestroyed) {
+                return false;
+            }
+            notify(mPopWaiters, mNotEmpty);
+            return true;
         }
 
-        inline T *getPopElement()
-        {
+        /**
+         * @brief Pops an element, without blocking.
+         * @return false if the queue is empty or destroyed.
+         */
+        inline bool tryPop(T &element) {
             if (mIsDestroyed) {
-                mElements[mPopIndex] = T();
-                return &mElements[mPopIndex];
+                return false;
             }
-            std::unique_lock<std::mutex> lock(mMutex);
-            while (mSize == 0) {
-                mConditionVariable.wait_for(lock, std::chrono::milliseconds(10));
-                if (mIsDestroyed) {
-                    mElements[mPopIndex] = T();
-                    return &mElements[mPopIndex];
-                }
+            if (!dequeue(element)) {
+                return false;
             }
-            T *element = &mElements[mPopIndex];
-            return element;
+            notify(mPushWaiters, mNotFull);
+            return true;
         }
 
-        inline void notifyPop() {
-            mPopIndex = (mPopIndex + 1) % C;
-            mSize--;
-            mConditionVariable.notify_all();
+        /**
+         * @brief Pops an element, blocking while the queue is empty.
+         * @return false if the queue has been destroyed.
+         */
+        inline bool pop(T &element) {
+            if (tryPop(element)) {
+                return true;
+            }
+            auto start = std::chrono::steady_clock::now();
+            std::unique_lock<std::mutex> lock(mMutex);
+            mPopWaiters++;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            while (!mIsDestroyed && !dequeue(element)) {
+                mNotEmpty.wait(lock);
+            }
+            mPopWaiters--;
+            lock.unlock();
+            addWaitTime(mPopWaits, mPopWaitTime, start);
+            if (mIsDestroyed) {
+                return false;
+            }
+            notify(mPushWaiters, mNotFull);
+            return true;
         }
 
+        /**
+         * @brief Wakes up all the blocked threads and makes all further operations fail.
+         */
         inline void destroy() {
+            std::lock_guard<std::mutex> lock(mMutex);
             mIsDestroyed = true;
-            mConditionVariable.notify_all();
+            mNotFull.notify_all();
+            mNotEmpty.notify_all();
         }
 
         inline bool isDestroyed() {
             return mIsDestroyed;
         }
 
+        /**
+         * @return The number of elements in the queue. This is only a snapshot when other threads are using the queue.
+         */
         inline int getCurrentSize() {
-            return mSize;
+            size_t pushed = mPushIndex.load(std::memory_order_relaxed);
+            size_t popped = mPopIndex.load(std::memory_order_relaxed);
+            return pushed > popped ? int(pushed - popped) : 0;
+        }
+
+        inline int getCapacity() {
+            return int(Capacity);
+        }
+
+        /**
+         * @return The largest number of elements which have been in the queue at the same time.
+         */
+        inline int getMaximalSize() {
+            return mMaximalSize.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @return The number of times a producer had to wait because the queue was full,
+         * and the total time (in microseconds) spent waiting.
+         */
+        inline long getPushWaits() {
+            return mPushWaits.load(std::memory_order_relaxed);
+        }
+
+        inline long getPushWaitTime() {
+            return mPushWaitTime.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @return The number of times a consumer had to wait because the queue was empty,
+         * and the total time (in microseconds) spent waiting.
+         */
+        inline long getPopWaits() {
+            return mPopWaits.load(std::memory_order_relaxed);
+        }
+
+        inline long getPopWaitTime() {
+            return mPopWaitTime.load(std::memory_order_relaxed);
         }
 
     private:
-        T mElements[C];
-        std::atomic<int> mSize;
-        int mPushIndex, mPopIndex;
+        static constexpr size_t roundCapacity(size_t n) {
+            size_t c = 1;
+            while (c < n) c <<= 1;
+            return c;
+        }
+
+        static constexpr size_t Capacity = roundCapacity(C > 0 ? C : 1);
+        static constexpr size_t Mask = Capacity - 1;
+
+        struct Cell {
+            std::atomic<size_t> sequence;
+            T element;
+        };
+
+        inline bool enqueue(T &element) {
+            size_t pos = mPushIndex.load(std::memory_order_relaxed);
+            Cell *cell;
+            while (true) {
+                cell = &mCells[pos & Mask];
+                size_t seq = cell->sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+                if (diff == 0) {
+                    if (mPushIndex.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false; // full
+                } else {
+                    pos = mPushIndex.load(std::memory_order_relaxed);
+                }
+            }
+            cell->element = std::move(element);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+
+            int size = getCurrentSize();
+            int maximal = mMaximalSize.load(std::memory_order_relaxed);
+            while (size > maximal && !mMaximalSize.compare_exchange_weak(maximal, size, std::memory_order_relaxed)) {}
+            return true;
+        }
+
+        inline bool dequeue(T &element) {
+            size_t pos = mPopIndex.load(std::memory_order_relaxed);
+            Cell *cell;
+            while (true) {
+                cell = &mCells[pos & Mask];
+                size_t seq = cell->sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos + 1);
+                if (diff == 0) {
+                    if (mPopIndex.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false; // empty
+                } else {
+                    pos = mPopIndex.load(std::memory_order_relaxed);
+                }
+            }
+            element = std::move(cell->element);
+            cell->element = T();
+            cell->sequence.store(pos + Capacity, std::memory_order_release);
+            return true;
+        }
+
+        /// Wakes up a thread blocked on cv, if any. The waiters register themselves under the
+        /// mutex before checking the queue again, so taking the mutex here avoids lost wake-ups.
+        inline void notify(std::atomic<int> &waiters, std::condition_variable &cv) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiters.load(std::memory_order_relaxed) == 0) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mMutex);
+            cv.notify_one();
+        }
+
+        static inline void addWaitTime(std::atomic<long> &waits, std::atomic<long> &time,
+                                       std::chrono::steady_clock::time_point start) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            waits.fetch_add(1, std::memory_order_relaxed);
+            time.fetch_add(long(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()),
+                           std::memory_order_relaxed);
+        }
+
+        Cell mCells[Capacity];
+        alignas(64) std::atomic<size_t> mPushIndex = 0;
+        alignas(64) std::atomic<size_t> mPopIndex = 0;
+
         std::mutex mMutex;
-        std::condition_variable mConditionVariable;
+        std::condition_variable mNotFull;
+        std::condition_variable mNotEmpty;
+        std::atomic<int> mPushWaiters = 0;
+        std::atomic<int> mPopWaiters = 0;
         std::atomic<bool> mIsDestroyed = false;
+
+        std::atomic<int> mMaximalSize = 0;
+        std::atomic<long> mPushWaits = 0;
+        std::atomic<long> mPushWaitTime = 0;
+        std::atomic<long> mPopWaits = 0;
+        std::atomic<long> mPopWaitTime = 0;
     };
 
 }
 
-#endif // TEXMACS_UTILS_THREADSAFEQUEUE_HPP
\ No newline at end of file
+#endif // TEXMACS_UTILS_THREADSAFEQUEUE_HPP
@@ -0,0 +1,81 @@
+
+/******************************************************************************
+* MODULE     : fromtm_test.cpp
+* DESCRIPTION: tests on the reader for the TeXmacs format
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include <QtTest/QtTest>
+#include "convert.hpp"
+#include "file.hpp"
+#include "drd_std.hpp"
+
+class TestFromtm: public QObject {
+  Q_OBJECT
+
+private slots:
+  void initTestCase ();
+  void test_atoms ();
+  void test_raw_data ();
+  void test_mapped ();
+};
+
+void
+TestFromtm::initTestCase () {
+  init_std_drd ();
+}
+
+/******************************************************************************
+* tests on the parsing of atoms
+******************************************************************************/
+
+static tree
+parse (string s) {
+  tree t= texmacs_to_tree (s);
+  if (is_func (t, DOCUMENT, 1)) return t[0];
+  return t;
+}
+
+void
+TestFromtm::test_atoms () {
+  QVERIFY (parse ("abc") == "abc");
+  QVERIFY (parse ("a b") == "a b");
+  QVERIFY (parse ("a\\<less\\>b") == "a<less>b");
+  QVERIFY (parse ("a\\|b\\\\c") == "a|b\\c");
+  // line continuations inside atoms
+  QVERIFY (parse ("abc\\\n   def") == "abcdef");
+  QVERIFY (parse ("<strong|x y>") == compound ("strong", "x y"));
+}
+
+void
+TestFromtm::test_raw_data () {
+  QVERIFY (parse ("<#414243>") == tree (RAW_DATA, "ABC"));
+  QVERIFY (parse ("<#>") == tree (RAW_DATA, ""));
+}
+
+/******************************************************************************
+* tests on documents read from memory mapped files
+******************************************************************************/
+
+void
+TestFromtm::test_mapped () {
+  string s= "<TeXmacs|2.1>\n\n<style|generic>\n\n<\\body>\n"
+            "  Hello <em|world>\n\n  <with|font|<#414243>|x>\n</body>\n";
+  url u= url_temp (".tm");
+  QVERIFY (!save_string (u, s));
+  tree t1= texmacs_document_to_tree (s);
+  tree t2= texmacs_document_to_tree (u);
+  remove (u);
+  QVERIFY (!is_func (t1, LABEL_ERROR));
+  QVERIFY (t1 == t2);
+  tree body= extract (t2, "body");
+  QVERIFY (body[0] == tree (CONCAT, "Hello ", compound ("em", "world")));
+  QVERIFY (body[1] == tree (WITH, "font", tree (RAW_DATA, "ABC"), "x"));
+}
+
+QTEST_MAIN(TestFromtm)
+#include "fromtm_test.moc"
@@ -0,0 +1,132 @@
+
+/******************************************************************************
+* MODULE     : tmbin_test.cpp
+* DESCRIPTION: tests on the binary format for TeXmacs documents
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include <QtTest/QtTest>
+#include "Texmacs/tmbin.hpp"
+
+class TestTmbin: public QObject {
+  Q_OBJECT
+
+private:
+  tree sample () {
+    tree body (DOCUMENT);
+    body << tree ("Hello world")
+         << tree (CONCAT, "x", tree (WITH, "font-series", "bold", "y"), "x")
+         << compound ("my-macro", "", tree (DOCUMENT, "nested", ""))
+         << tree ("")
+         << tree (CONCAT);
+    tree doc (DOCUMENT);
+    doc << compound ("TeXmacs", TEXMACS_VERSION)
+        << compound ("style", tree (TUPLE, "generic"))
+        << compound ("body", body);
+    return doc;
+  }
+
+private slots:
+  void initTestCase ();
+  void test_round_trip ();
+  void test_shared_atoms ();
+  void test_paragraphs ();
+  void test_version ();
+  void test_errors ();
+};
+
+void
+TestTmbin::initTestCase () {
+  make_tree_label (DOCUMENT, "document");
+  make_tree_label (CONCAT, "concat");
+  make_tree_label (WITH, "with");
+  make_tree_label (TUPLE, "tuple");
+}
+
+/******************************************************************************
+* tests on round trips
+******************************************************************************/
+void
+TestTmbin::test_round_trip () {
+  tree doc= sample ();
+  string s= tree_to_texmacs_binary (doc);
+  QVERIFY (is_texmacs_binary (s));
+  QVERIFY (!is_texmacs_binary ("<TeXmacs|2.1>"));
+  QCOMPARE (texmacs_binary_to_tree (s) == doc, true);
+  QCOMPARE (tree_to_texmacs_binary (texmacs_binary_to_tree (s)) == s, true);
+
+  tree big (DOCUMENT);
+  for (int i=0; i<1000; i++) big << tree (CONCAT, as_string (i), "text");
+  QCOMPARE (texmacs_binary_to_tree (tree_to_texmacs_binary (big)) == big, true);
+}
+
+/******************************************************************************
+* tests on the pool of atoms
+******************************************************************************/
+void
+TestTmbin::test_shared_atoms () {
+  tree t (DOCUMENT);
+  for (int i=0; i<100; i++) t << tree ("a rather long paragraph of text");
+  string one= tree_to_texmacs_binary (tree (DOCUMENT, t[0]));
+  string all= tree_to_texmacs_binary (t);
+  QVERIFY (N(all) < N(one) + 100 * 8);
+  tree r= texmacs_binary_to_tree (all);
+  QCOMPARE (r == t, true);
+  QCOMPARE (is_interned (r[0]->label), true);
+}
+
+/******************************************************************************
+* tests on the lazy access to the paragraphs
+******************************************************************************/
+void
+TestTmbin::test_paragraphs () {
+  tree doc= sample ();
+  texmacs_binary b (tree_to_texmacs_binary (doc));
+  QCOMPARE (b->is_error (), false);
+  QCOMPARE (b->nr_paragraphs (), 5);
+  QCOMPARE (b->get_paragraph (2) == doc[2][0][2], true);
+  QCOMPARE (b->get_paragraph (0) == doc[2][0][0], true);
+  QCOMPARE (b->get_document () == doc, true);
+
+  texmacs_binary flat (tree_to_texmacs_binary (tree (CONCAT, "a", "b")));
+  QCOMPARE (flat->is_error (), false);
+  QCOMPARE (flat->nr_paragraphs (), 0);
+}
+
+/******************************************************************************
+* tests on the version in the header
+******************************************************************************/
+void
+TestTmbin::test_version () {
+  texmacs_binary b (tree_to_texmacs_binary (sample ()));
+  QCOMPARE (b->get_version () == TEXMACS_VERSION, true);
+
+  tree old= sample ();
+  old[0][0]= "1.0.7";
+  texmacs_binary o (tree_to_texmacs_binary (old));
+  QCOMPARE (o->is_error (), false);
+  QCOMPARE (o->get_version () == "1.0.7", true);
+  QCOMPARE (o->get_document () == old, true);
+
+  texmacs_binary flat (tree_to_texmacs_binary (tree (CONCAT, "a", "b")));
+  QCOMPARE (flat->get_version () == TEXMACS_VERSION, true);
+}
+
+/******************************************************************************
+* tests on invalid data
+******************************************************************************/
+void
+TestTmbin::test_errors () {
+  string s= tree_to_texmacs_binary (sample ());
+  QCOMPARE (is_func (texmacs_binary_to_tree (string ("garbage")),
+                     LABEL_ERROR), true);
+  for (int i=0; i<N(s); i+=7)
+    QCOMPARE (is_func (texmacs_binary_to_tree (s (0, i)), LABEL_ERROR), true);
+}
+
+QTEST_MAIN(TestTmbin)
+#include "tmbin_test.moc"
@@ -0,0 +1,116 @@
+
+/******************************************************************************
+* MODULE     : totm_test.cpp
+* DESCRIPTION: tests on the writer for the TeXmacs format
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include <QtTest/QtTest>
+#include "convert.hpp"
+#include "file.hpp"
+#include "drd_std.hpp"
+
+class TestTotm: public QObject {
+  Q_OBJECT
+
+private slots:
+  void initTestCase ();
+  void test_streaming ();
+  void test_cancel ();
+  void test_background ();
+  void test_snapshot ();
+};
+
+void
+TestTotm::initTestCase () {
+  init_std_drd ();
+}
+
+static tree
+large_document (int n) {
+  // enough paragraphs to exceed the buffer of the writer several times
+  tree body (DOCUMENT);
+  for (int i=0; i<n; i++)
+    body << tree (CONCAT, "Paragraph " * as_string (i) * " with ",
+                  compound ("em", "some emphasis"), " and a|bar");
+  return tree (DOCUMENT,
+               compound ("TeXmacs", "2.1"),
+               compound ("style", "generic"),
+               compound ("body", body));
+}
+
+static string
+contents (url u) {
+  string s;
+  if (load_string (u, s, false)) return "* error *";
+  return s;
+}
+
+/******************************************************************************
+* tests on the writing of files
+******************************************************************************/
+
+void
+TestTotm::test_streaming () {
+  tree doc= large_document (5000);
+  string s= tree_to_texmacs (doc);
+  QVERIFY (N(s) > 4 * 65536);
+  url u= url_temp (".tm");
+  QVERIFY (!tree_to_texmacs (doc, u));
+  QVERIFY (contents (u) == s);
+  QVERIFY (texmacs_document_to_tree (u) == texmacs_document_to_tree (s));
+  remove (u);
+}
+
+void
+TestTotm::test_cancel () {
+  url u= url_temp (".tm");
+  QVERIFY (!save_string (u, "old"));
+  {
+    file_writer fw (u);
+    QVERIFY (!fw->error);
+    fw->write ("new", 3);
+    // the destination is left untouched without commit
+  }
+  QVERIFY (contents (u) == "old");
+  file_writer fw (u);
+  fw->write ("new", 3);
+  QVERIFY (!fw->commit ());
+  QVERIFY (contents (u) == "new");
+  remove (u);
+}
+
+void
+TestTotm::test_background () {
+  tree doc= large_document (2000);
+  string s= tree_to_texmacs (doc);
+  url u= url_temp (".tm");
+  save_string_in_background (u, s);
+  QTRY_VERIFY_WITH_TIMEOUT (contents (u) == s, 4000);
+  remove (u);
+}
+
+void
+TestTotm::test_snapshot () {
+  tree doc= large_document (2000);
+  doc[2][0] << tree (EXPAND, "unknown-macro", "x")
+            << tree (COLLECTION, tree (ASSOCIATE, "a", "b"));
+  string s= tree_to_texmacs (doc);
+  tree snapshot= texmacs_snapshot (doc);
+  // the snapshot shares no atoms with the document
+  QVERIFY (!strong_equal (snapshot[0][2][0][0][0], doc[2][0][0][0]));
+  QVERIFY (texmacs_snapshot_to_string (snapshot) == s);
+  url u= url_temp (".tm");
+  save_string_in_background (u, [snapshot= texmacs_snapshot (doc)] () {
+    return texmacs_snapshot_to_string (snapshot); });
+  finish_background_saves ();
+  QVERIFY (contents (u) == s);
+  remove (u);
+}
+
+QTEST_MAIN(TestTotm)
+#include "totm_test.moc"
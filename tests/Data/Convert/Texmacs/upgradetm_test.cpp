@@ -0,0 +1,157 @@
+
+/******************************************************************************
+* MODULE     : upgradetm_test.cpp
+* DESCRIPTION: test and benchmark on the fused upgrades of old documents
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include <QtTest/QtTest>
+#include "convert.hpp"
+#include "analyze.hpp"
+#include "file.hpp"
+#include "drd_std.hpp"
+
+tree rename_primitive (tree t, string which, string by);
+tree upgrade_qed (tree t);
+tree upgrade_copyright_dashes (tree t);
+tree upgrade_expand (tree t, tree_label WHICH_EXPAND);
+tree upgrade_xexpand (tree t);
+tree upgrade_expands (tree t);
+
+class TestUpgradetm: public QObject {
+  Q_OBJECT
+
+private slots:
+  void initTestCase ();
+  void test_fused ();
+  void test_sharing ();
+  void test_expands ();
+  void bench_corpus ();
+};
+
+void
+TestUpgradetm::initTestCase () {
+  init_std_drd ();
+}
+
+static tree
+source_document (tree body) {
+  // documents in the source style are not upgraded any further
+  return tree (DOCUMENT,
+               compound ("TeXmacs", "1.99.5"),
+               compound ("style", tuple ("source")),
+               compound ("body", body));
+}
+
+static tree
+separate_upgrades (tree t) {
+  // the upgrades from version 1.99.5 on, one traversal for each of them
+  t= upgrade_qed (t);
+  t= rename_primitive (t, "solution", "solution*");
+  t= rename_primitive (t, "answer", "answer*");
+  t= rename_primitive (t, "html-div", "html-div-class");
+  t= rename_primitive (t, "html-style", "html-div-style");
+  t= upgrade_copyright_dashes (t);
+  t= rename_primitive (t, "swell", "inflate");
+  t= rename_primitive (t, "swell-top", "inflate-top");
+  t= rename_primitive (t, "swell-bottom", "inflate-bottom");
+  return t;
+}
+
+/******************************************************************************
+* tests on the agreement with separate upgrades
+******************************************************************************/
+
+void
+TestUpgradetm::test_fused () {
+  tree body (DOCUMENT);
+  body << compound ("solution", tree (CONCAT, "x", tree (VALUE, "qed")))
+       << compound ("answer", compound ("swell", "y"))
+       << compound ("tmdoc-copyright", "1998--2026", "Joris")
+       << compound ("html-div", "z", compound ("swell-top", "a"));
+  tree doc= source_document (body);
+  tree r= upgrade (doc, "1.99.5");
+  QVERIFY (r == separate_upgrades (doc));
+  tree b= extract (r, "body");
+  QVERIFY (b[0] == compound ("solution*",
+                             tree (CONCAT, "x", compound ("qed"))));
+  QVERIFY (b[1] == compound ("answer*", compound ("inflate", "y")));
+  QVERIFY (b[2][0] == "1998\25" "2026");
+  QVERIFY (b[3] == compound ("html-div-class", "z",
+                             compound ("inflate-top", "a")));
+}
+
+void
+TestUpgradetm::test_sharing () {
+  tree untouched= tree (CONCAT, "some", tree (WITH, "font", "roman", "text"));
+  tree body (DOCUMENT, untouched, compound ("swell", "y"));
+  tree r= upgrade (source_document (body), "1.99.5");
+  tree b= extract (r, "body");
+  QVERIFY (strong_equal (b[0], untouched));
+  QVERIFY (!strong_equal (b, body));
+  tree same= source_document (tree (DOCUMENT, untouched));
+  QVERIFY (strong_equal (upgrade (same, "1.99.5"), same));
+}
+
+void
+TestUpgradetm::test_expands () {
+  tree macro (MACRO, "x", tree (EXPAND, "strong", tree (ARG, "x")));
+  tree body (DOCUMENT);
+  body << tree (EXPAND, "theorem", tree (HIDE_EXPAND, "foo", "a", "b"))
+       << tree (VAR_EXPAND, "quote", tree (EXPAND, "em", "c"))
+       << tree (ASSIGN, "quote", macro)
+       << tree (EXPAND, tree (CONCAT, "x", "y"), "d")
+       << tree (WITH, "font", "roman", tree (VAR_EXPAND, "bar"));
+  tree sep= body;
+  sep= upgrade_expand (sep, EXPAND);
+  sep= upgrade_expand (sep, HIDE_EXPAND);
+  sep= upgrade_expand (sep, VAR_EXPAND);
+  sep= upgrade_xexpand (sep);
+  tree r= upgrade_expands (body);
+  QVERIFY (r == sep);
+  QVERIFY (r[0] == compound ("theorem", compound ("foo", "a", "b")));
+  QVERIFY (r[1] == compound ("quote-env", compound ("em", "c")));
+  QVERIFY (r[2] == tree (ASSIGN, "quote-env",
+                         tree (MACRO, "x", compound ("strong",
+                                                     tree (ARG, "x")))));
+  QVERIFY (is_func (r[3], COMPOUND, 2));
+}
+
+/******************************************************************************
+* timings on the documentation
+******************************************************************************/
+
+void
+TestUpgradetm::bench_corpus () {
+  bool error= false;
+  url dir ("$TEXMACS_PATH/doc/main");
+  array<string> files= read_directory (dir, error);
+  QVERIFY (!error);
+  long long t1= 0, t2= 0;
+  int count= 0;
+  for (int i=0; i<N(files); i++) {
+    string s;
+    if (!ends (files[i], ".tm") || load_string (dir * files[i], s, false))
+      continue;
+    tree body= extract (texmacs_document_to_tree (s), "body");
+    tree doc = source_document (body);
+    QElapsedTimer timer;
+    timer.start ();
+    tree r1= separate_upgrades (doc);
+    t1 += timer.nsecsElapsed ();
+    timer.start ();
+    tree r2= upgrade (doc, "1.99.5");
+    t2 += timer.nsecsElapsed ();
+    QVERIFY (r1 == r2);
+    count++;
+  }
+  qDebug ("%d documents: separate %lld us, fused %lld us",
+          count, t1 / 1000, t2 / 1000);
+}
+
+QTEST_MAIN(TestUpgradetm)
+#include "upgradetm_test.moc"
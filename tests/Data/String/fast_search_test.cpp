@@ -0,0 +1,83 @@
+
+/******************************************************************************
+* MODULE     : fast_search_test.cpp
+* DESCRIPTION: tests on suffix arrays
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include <QtTest/QtTest>
+#include "fast_search.hpp"
+#include "analyze.hpp"
+
+class TestFastSearch: public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_small ();
+  void test_repetitive ();
+  void test_random ();
+};
+
+static array<int>
+naive_search_all (string s, string what) {
+  array<int> r;
+  for (int i=0; i+N(what)<=N(s); i++)
+    if (test (s, i, what)) r << i;
+  return r;
+}
+
+static bool
+same_search (suffix_array sa, string what) {
+  string s= sa->get_string ();
+  array<int> r= sa->search_all (what);
+  return r == naive_search_all (s, what) && sa->count (what) == N(r);
+}
+
+/******************************************************************************
+* tests on the agreement with naive searches
+******************************************************************************/
+
+void
+TestFastSearch::test_small () {
+  QVERIFY (N(suffix_array ("")->search_all ("a")) == 0);
+  suffix_array sa ("mississippi");
+  QVERIFY (same_search (sa, "ssi"));
+  QVERIFY (same_search (sa, "i"));
+  QVERIFY (same_search (sa, "mississippi"));
+  QVERIFY (same_search (sa, "mississippis"));
+  QVERIFY (same_search (sa, "x"));
+  QVERIFY (sa->search_all ("issi") == array<int> (1, 4));
+}
+
+void
+TestFastSearch::test_repetitive () {
+  string a, ab;
+  for (int i=0; i<1000; i++) { a << 'a'; ab << "ab"; }
+  QVERIFY (same_search (suffix_array (a), "aaa"));
+  QVERIFY (same_search (suffix_array (ab), "bab"));
+  QVERIFY (same_search (suffix_array (ab * "c" * ab), "bc"));
+}
+
+void
+TestFastSearch::test_random () {
+  unsigned int seed= 1;
+  string s;
+  for (int i=0; i<20000; i++) {
+    seed= seed * 1103515245 + 12345;
+    s << (char) ('a' + ((seed >> 16) % 4));
+  }
+  s << '\0' << (char) 255 << "abc";
+  suffix_array sa (s);
+  for (int i=0; i<200; i++) {
+    seed= seed * 1103515245 + 12345;
+    int pos= (seed >> 8) % N(s), len= 1 + (seed % 7);
+    QVERIFY (same_search (sa, s (pos, std::min (pos + len, N(s)))));
+  }
+}
+
+QTEST_MAIN(TestFastSearch)
+#include "fast_search_test.moc"
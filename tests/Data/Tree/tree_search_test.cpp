@@ -0,0 +1,75 @@
+
+/******************************************************************************
+* MODULE     : tree_search_test.cpp
+* DESCRIPTION: tests on the indexed search of strings in trees
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include <QtTest/QtTest>
+#include "tree_search.hpp"
+#include "new_document.hpp"
+#include "modification.hpp"
+#include "drd_std.hpp"
+
+extern tree the_et;
+
+class TestTreeSearch: public QObject {
+  Q_OBJECT
+
+private slots:
+  void initTestCase ();
+  void test_reuse ();
+};
+
+void
+TestTreeSearch::initTestCase () {
+  init_std_drd ();
+  the_et= tuple ();
+  the_et->obs= ip_observer (path ());
+}
+
+static tree
+sample_document (int n) {
+  tree doc (DOCUMENT);
+  for (int i=0; i<n; i++)
+    doc << tree ("paragraph " * as_string (i) * " with some words");
+  return doc;
+}
+
+static int
+hits (path rp, string what) {
+  return N(search (subtree (the_et, rp), what, rp)) / 2;
+}
+
+/******************************************************************************
+* tests on the reuse of the index
+******************************************************************************/
+
+void
+TestTreeSearch::test_reuse () {
+  path body = new_document ();
+  path field= new_document ();
+  set_document (body, sample_document (100));
+  set_document (field, tree (DOCUMENT, ""));
+  // the index is built when the same tree is searched a second time
+  QCOMPARE (hits (body, "some"), 100);
+  QCOMPARE (hits (body, "paragraph 7"), 11);
+  // typing in the search field does not invalidate the index of the body;
+  // this is checked by changing the body behind the back of its observers,
+  // which goes unnoticed as long as the index is reused
+  assign (field * 0, "qux");
+  subtree (the_et, body * 3)->label= "paragraph qux";
+  QCOMPARE (hits (body, "qux"), 0);
+  // modifications of the body itself invalidate the index
+  assign (body * 5, "paragraph qux again");
+  QCOMPARE (hits (body, "qux"), 2);
+  QCOMPARE (hits (body, "qux"), 2);
+  QCOMPARE (hits (body, "again"), 1);
+}
+
+QTEST_MAIN(TestTreeSearch)
+#include "tree_search_test.moc"
@@ -0,0 +1,126 @@
+
+/******************************************************************************
+* MODULE     : glyph_shrink_test.cpp
+* DESCRIPTION: test and benchmark on the shrinking of glyphs
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include <QtTest/QtTest>
+#include "bitmap_font.hpp"
+
+class TestGlyphShrink: public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_shrink ();
+  void test_thicken ();
+  void test_empty ();
+  void bench_shrink ();
+};
+
+static glyph
+test_glyph (int w, int h, unsigned int seed) {
+  // a ring with some noise, in order to get both strokes and isolated pixels
+  glyph gl (w, h, w/8, (3*h)/4);
+  int cx= w/2, cy= h/2, r= std::min (w, h)/2, t= std::max (1, r/4);
+  for (int y=0; y<h; y++)
+    for (int x=0; x<w; x++) {
+      seed= seed * 1103515245 + 12345;
+      int d= (x-cx)*(x-cx) + (y-cy)*(y-cy);
+      bool ring= d <= r*r && d >= (r-t)*(r-t);
+      bool noise= ((seed >> 16) & 15) == 0;
+      if (ring || noise) gl->set_1 (x, y, 1);
+    }
+  return gl;
+}
+
+static bool
+same_glyph (glyph g1, glyph g2) {
+  if (g1->width != g2->width || g1->height != g2->height) return false;
+  if (g1->xoff != g2->xoff || g1->yoff != g2->yoff) return false;
+  if (g1->depth != g2->depth) return false;
+  for (int y=0; y<g1->height; y++)
+    for (int x=0; x<g1->width; x++)
+      if (g1->get_x (x, y) != g2->get_x (x, y)) return false;
+  return true;
+}
+
+static bool
+same_shrink (glyph gl, int f, int dx, int dy, int tx, int ty) {
+  SI xo1, yo1, xo2, yo2;
+  glyph g1= shrink (gl, f, f, dx, dy, tx, ty, xo1, yo1);
+  glyph g2= shrink_reference (gl, f, f, dx, dy, tx, ty, xo2, yo2);
+  return same_glyph (g1, g2) && xo1 == xo2 && yo1 == yo2;
+}
+
+/******************************************************************************
+* tests on the agreement with the reference implementation
+******************************************************************************/
+
+void
+TestGlyphShrink::test_shrink () {
+  int sizes[]= { 1, 7, 13, 24, 50, 101 };
+  int factors[]= { 1, 2, 3, 4, 5, 7, 8, 9 };
+  for (int s: sizes)
+    for (int f: factors)
+      for (int dx=0; dx<f; dx+=2) {
+        glyph gl= test_glyph (s, s + s/3, s*f + dx);
+        QVERIFY (same_shrink (gl, f, dx, 0, 0, 0));
+      }
+}
+
+void
+TestGlyphShrink::test_thicken () {
+  int factors[]= { 2, 3, 4, 6, 8 };
+  for (int f: factors) {
+    glyph gl= test_glyph (40, 55, f);
+    for (int t=0; t<=f/2; t++) {
+      QVERIFY (same_shrink (gl, f, 1, 0, t, t));
+      QVERIFY (same_shrink (gl, f, 0, 1, t, 0));
+      QVERIFY (same_shrink (gl, f, 0, 0, 0, t));
+    }
+  }
+}
+
+void
+TestGlyphShrink::test_empty () {
+  glyph gl (12, 9, 0, 8);
+  SI xo, yo;
+  glyph sh= shrink (gl, 3, 3, 0, 0, 1, 1, xo, yo);
+  QVERIFY (same_shrink (gl, 3, 0, 0, 1, 1));
+  for (int y=0; y<sh->height; y++)
+    for (int x=0; x<sh->width; x++)
+      QCOMPARE (sh->get_x (x, y), 0);
+}
+
+/******************************************************************************
+* comparison of the timings of both implementations
+******************************************************************************/
+
+void
+TestGlyphShrink::bench_shrink () {
+  int sizes[]= { 16, 32, 64, 128 };
+  int factors[]= { 2, 3, 4, 6 };
+  for (int s: sizes)
+    for (int f: factors) {
+      glyph gl= test_glyph (s * f / 4, s * f / 3, s + f);
+      int n= 20000 / (s * f);
+      SI xo, yo;
+      QElapsedTimer timer;
+      timer.start ();
+      for (int i=0; i<n; i++) shrink_reference (gl, f, f, 0, 0, f/3, f/3, xo, yo);
+      long long t1= timer.nsecsElapsed ();
+      timer.start ();
+      for (int i=0; i<n; i++) shrink (gl, f, f, 0, 0, f/3, f/3, xo, yo);
+      long long t2= timer.nsecsElapsed ();
+      qDebug ("size %3d, factor %d: reference %8lld ns, vectorized %8lld ns",
+              s, f, t1 / n, t2 / n);
+    }
+}
+
+QTEST_MAIN(TestGlyphShrink)
+#include "glyph_shrink_test.moc"
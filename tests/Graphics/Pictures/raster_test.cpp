@@ -0,0 +1,171 @@
+
+/******************************************************************************
+* MODULE     : raster_test.cpp
+* DESCRIPTION: test and benchmark on convolutions and erosions of rasters
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include <QtTest/QtTest>
+#include "raster_picture.hpp"
+
+class TestRaster: public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_convolute ();
+  void test_factored ();
+  void test_thicken ();
+  void test_erode ();
+  void bench_convolute ();
+};
+
+static raster<true_color>
+test_raster (int w, int h, unsigned int seed) {
+  raster<true_color> ras (w, h, w/3, h/4);
+  for (int i=0; i<w*h; i++) {
+    double v[4];
+    for (int k=0; k<4; k++) {
+      seed= seed * 1103515245 + 12345;
+      v[k]= ((seed >> 16) & 255) / 255.0;
+    }
+    ras->a[i]= true_color (v[0], v[1], v[2], (i % 7 == 0? 0.0: v[3]));
+  }
+  return ras;
+}
+
+static raster<true_color>
+reference_convolute (raster<true_color> s1, raster<double> s2) {
+  int s1w= s1->w, s1h= s1->h, s2w= s2->w, s2h= s2->h;
+  int dw= s1w + s2w - 1, dh= s1h + s2h - 1;
+  raster<true_color> d (dw, dh, s1->ox + s2->ox, s1->oy + s2->oy);
+  clear (d);
+  raster<true_color> temp= mul_alpha (s1);
+  for (int y1=0; y1<s1h; y1++)
+    for (int y2=0; y2<s2h; y2++) {
+      int o1= y1 * s1w, o2= y2 * s2w, o= (y1 + y2) * dw;
+      for (int x1=0; x1<s1w; x1++)
+        for (int x2=0; x2<s2w; x2++)
+          d->a[o+x1+x2] += temp->a[o1+x1] * s2->a[o2+x2];
+    }
+  return div_alpha (d);
+}
+
+static double
+distance (raster<true_color> r1, raster<true_color> r2) {
+  if (r1->w != r2->w || r1->h != r2->h) return 1.0e10;
+  if (r1->ox != r2->ox || r1->oy != r2->oy) return 1.0e10;
+  double m= 0.0;
+  for (int i=0; i<r1->w * r1->h; i++) {
+    true_color c= r1->a[i] - r2->a[i];
+    m= std::max (m, std::max (std::max (fabs (c.r), fabs (c.g)),
+                              std::max (fabs (c.b), fabs (c.a))));
+  }
+  return m;
+}
+
+/******************************************************************************
+* tests on the agreement with the direct computations
+******************************************************************************/
+
+void
+TestRaster::test_convolute () {
+  // the larger pens are convolved using Fourier transforms
+  int sizes[]= { 1, 9, 40, 77 };
+  int radii[]= { 0, 2, 7, 15, 30 };
+  for (int s: sizes)
+    for (int r: radii) {
+      raster<true_color> ras= test_raster (s, s + 5, s + r);
+      raster<double> pen= gravitation<double> (r, 1.5, (s & 1) == 0);
+      if (r == 0) pen= rectangular_pen<double> (0.0, 0.0);
+      QVERIFY (distance (convolute (ras, pen),
+                         reference_convolute (ras, pen)) < 1.0e-9);
+    }
+}
+
+void
+TestRaster::test_factored () {
+  double radii[]= { 0.5, 2.0, 6.0 };
+  for (double r: radii) {
+    raster<true_color> ras= test_raster (50, 31, 17);
+    raster<double> pen= gaussian_pen<double> (r, r, 0.0);
+    pen= pen / sum (pen);
+    QVERIFY (can_be_factored (pen));
+    QVERIFY (distance (factored_convolute (ras, pen),
+                       reference_convolute (ras, pen)) < 1.0e-3);
+  }
+}
+
+void
+TestRaster::test_thicken () {
+  raster<true_color> ras= test_raster (60, 45, 3);
+  raster<double> pen= oval_pen<double> (3.0, 2.0, 0.3);
+  raster<true_color> d= thicken (ras, pen);
+  raster<double> temp= get_alpha (ras);
+  raster<true_color> e= reference_convolute (ras, pen);
+  clear_alpha (e);
+  for (int y1=0; y1<ras->h; y1++)
+    for (int y2=0; y2<pen->h; y2++)
+      for (int x1=0; x1<ras->w; x1++)
+        for (int x2=0; x2<pen->w; x2++)
+          src_over (get_alpha (e->a[(y1+y2)*e->w + x1+x2]),
+                    temp->a[y1*ras->w+x1] * pen->a[y2*pen->w+x2]);
+  QCOMPARE (distance (d, e), 0.0);
+}
+
+void
+TestRaster::test_erode () {
+  // rectangular pens are decomposed into runs, smooth pens are not
+  raster<double> pens[]= {
+    rectangular_pen<double> (2.0, 3.5),
+    rectangular_pen<double> (6.0, 1.0),
+    oval_pen<double> (4.0, 4.0, 0.0),
+    gaussian_pen<double> (2.0, 2.0, 0.0)
+  };
+  for (raster<double> pen: pens) {
+    raster<true_color> ras= test_raster (45, 38, pen->w);
+    raster<true_color> d= erode (ras, pen);
+    raster<true_color> e= copy (ras);
+    raster<double> temp= get_alpha (ras);
+    for (int y1=0; y1<ras->h; y1++)
+      for (int y2=0; y2<pen->h; y2++) {
+        int yd= y1 + y2 - pen->oy;
+        if (yd < 0 || yd >= ras->h) continue;
+        for (int x1=0; x1<ras->w; x1++)
+          for (int x2=0; x2<pen->w; x2++) {
+            int xd= x1 + x2 - pen->ox;
+            if (xd < 0 || xd >= ras->w) continue;
+            erode (get_alpha (e->a[yd*ras->w + xd]),
+                   temp->a[y1*ras->w+x1], pen->a[y2*pen->w+x2]);
+          }
+      }
+    QCOMPARE (distance (d, e), 0.0);
+  }
+}
+
+/******************************************************************************
+* comparison of the timings with the direct computations
+******************************************************************************/
+
+void
+TestRaster::bench_convolute () {
+  int radii[]= { 3, 8, 15, 30 };
+  for (int r: radii) {
+    raster<true_color> ras= test_raster (200, 150, r);
+    raster<double> pen= gravitation<double> (r, 1.5, false);
+    QElapsedTimer timer;
+    timer.start ();
+    reference_convolute (ras, pen);
+    long long t1= timer.nsecsElapsed ();
+    timer.start ();
+    convolute (ras, pen);
+    long long t2= timer.nsecsElapsed ();
+    qDebug ("radius %2d: direct %10lld ns, engine %10lld ns", r, t1, t2);
+  }
+}
+
+QTEST_MAIN(TestRaster)
+#include "raster_test.moc"
@@ -0,0 +1,288 @@
+
+/******************************************************************************
+* MODULE     : flat_hashmap_test.cpp
+* DESCRIPTION: test on flat_hashmap
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include <QtTest/QtTest>
+#include "flat_hashmap.hpp"
+#include "iterator.hpp"
+
+class TestFlatHashmap: public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_resize ();
+  void test_reset ();
+  void test_collisions ();
+  void test_iterate ();
+  void test_contains ();
+  void test_empty ();
+  void test_join ();
+  void test_write_back ();
+  void test_pre_patch ();
+  void test_post_patch ();
+  void test_copy ();
+  void test_equality ();
+  void test_changes ();
+  void test_invert ();
+  void test_size ();
+};
+
+/******************************************************************************
+* tests on resize
+******************************************************************************/
+void
+TestFlatHashmap::test_resize () {
+  auto hm = flat_hashmap<int, int>(0, 10);
+  hm(1) = 10;
+  hm(2) = 20;
+
+  hm->resize(1);
+  QCOMPARE (hm[1] == 10, true);
+  QCOMPARE (hm[2] == 20, true);
+
+  hm->resize(20);
+  QCOMPARE (hm[1] == 10, true);
+  QCOMPARE (hm[2] == 20, true);
+}
+
+/******************************************************************************
+* tests on reset
+******************************************************************************/
+void
+TestFlatHashmap::test_reset () {
+  auto hm = flat_hashmap<int, int>(0, 10);
+  hm(1) = 10;
+  hm(11) = 20;
+  hm->reset(1);
+
+  QCOMPARE (hm->contains(1), false);
+  QCOMPARE (hm->contains(11), true);
+  QCOMPARE (hm[11] == 20, true);
+}
+
+/******************************************************************************
+* tests on collisions (keys with the same ideal slot)
+******************************************************************************/
+void
+TestFlatHashmap::test_collisions () {
+  auto hm = flat_hashmap<int, int>(-1);
+  for (int i=0; i<1000; i++) hm(i * 1024) = i;
+  for (int i=0; i<1000; i+=2) hm->reset(i * 1024);
+  QCOMPARE (N(hm), 500);
+  for (int i=0; i<1000; i++)
+    QCOMPARE (hm[i * 1024], (i & 1) ? i : -1);
+}
+
+/******************************************************************************
+* tests on iterate
+******************************************************************************/
+void
+TestFlatHashmap::test_iterate () {
+  auto hm = flat_hashmap<int, int>();
+  for (int i=0; i<100; i++) hm(i) = i;
+  int count= 0, sum= 0;
+  iterator<int> it= iterate (hm);
+  while (it->busy ()) {
+    sum += it->next ();
+    count++;
+  }
+  QCOMPARE (count, 100);
+  QCOMPARE (sum, 4950);
+}
+
+/******************************************************************************
+* tests on contains
+******************************************************************************/
+void
+TestFlatHashmap::test_contains () {
+  auto hm = flat_hashmap<int, void*>(nullptr, 2, 2);
+  hm(1) = nullptr;
+  QCOMPARE (hm->contains(1), true);
+  QCOMPARE (hm->contains(3), false);
+}
+
+/******************************************************************************
+* tests on empty
+******************************************************************************/
+void
+TestFlatHashmap::test_empty () {
+  auto hm = flat_hashmap<int, int>();
+  QCOMPARE (hm->empty(), true);
+
+  hm(1);
+  QCOMPARE (hm->empty(), false);
+}
+
+/******************************************************************************
+* tests on join
+******************************************************************************/
+void
+TestFlatHashmap::test_join () {
+  auto hm1 = flat_hashmap<int, int>();
+  auto hm2 = flat_hashmap<int, int>();
+  hm1(1) = 10;
+  hm1(2) = 20;
+  hm2(2) = -20;
+  hm2(3) = -30;
+  hm1->join(hm2);
+
+  QCOMPARE (hm1[1] == 10, true);
+  QCOMPARE (hm1[2] == -20, true);
+  QCOMPARE (hm1[3] == -30, true);
+}
+
+/******************************************************************************
+* tests on write_back
+******************************************************************************/
+void
+TestFlatHashmap::test_write_back () {
+  auto hm1 = flat_hashmap<int, int>(0, 10);
+  auto hm2 = flat_hashmap<int, int>(0, 10);
+  hm1(1) = 10;
+  hm1(2) = 20;
+  hm2(2) = -20;
+
+  hm1->write_back(2, hm2);
+  QCOMPARE (hm1[2] == 20, true);
+
+  hm1->write_back(3, hm2);
+  QCOMPARE (hm1[3] == 0, true);
+
+  hm2(4) = -40;
+  hm1->write_back(4, hm2);
+  QCOMPARE (hm1[4] == -40, true);
+}
+
+/******************************************************************************
+* tests on pre_patch
+******************************************************************************/
+void
+TestFlatHashmap::test_pre_patch () {
+  auto hm = flat_hashmap<int, int>();
+  auto hm_patch = flat_hashmap<int, int>();
+  auto hm_base = flat_hashmap<int, int>();
+
+  hm(1) = 10;
+  hm_patch(1);
+  hm->pre_patch(hm_patch, hm_base);
+  QCOMPARE (hm[1] == 10, true);
+
+  hm(2) = 20;
+  hm_patch(2) = -20;
+  hm_base(2) = 20;
+  hm->pre_patch(hm_patch, hm_base);
+  QCOMPARE (hm[2] == 0, true);
+
+  hm_patch(3) = -30;
+  hm->pre_patch(hm_patch, hm_base);
+  QCOMPARE (hm[3] == -30, true);
+}
+
+/******************************************************************************
+* tests on post_patch
+******************************************************************************/
+void
+TestFlatHashmap::test_post_patch () {
+  auto hm = flat_hashmap<int, int>();
+  auto hm_patch = flat_hashmap<int, int>();
+  auto hm_base = flat_hashmap<int, int>();
+
+  hm(1) = 10;
+  hm_patch(1);
+  hm->post_patch(hm_patch, hm_base);
+  QCOMPARE (hm[1] == 0, true);
+
+  hm_patch(2) = -20;
+  hm->post_patch(hm_patch, hm_base);
+  QCOMPARE (hm[2] == -20, true);
+}
+
+/******************************************************************************
+* tests on copy
+******************************************************************************/
+void
+TestFlatHashmap::test_copy () {
+  auto hm_c = flat_hashmap<int, int>(0, 10, 2);
+  hm_c(1) = 10;
+  hm_c(11) = 110;
+  hm_c(2) = 20;
+
+  auto res_hm = copy(hm_c);
+  res_hm(1) = 0;
+  QCOMPARE (res_hm[1] == 0, true);
+  QCOMPARE (hm_c[1] == 10, true);
+  QCOMPARE (res_hm[11] == 110, true);
+  QCOMPARE (res_hm[2] == 20, true);
+}
+
+/******************************************************************************
+* tests on equality
+******************************************************************************/
+void
+TestFlatHashmap::test_equality () {
+  auto hm1 = flat_hashmap<int, int>(0, 10, 3);
+  auto hm2 = flat_hashmap<int, int>(0, 100, 30);
+  hm1(1) = 10;
+  hm2(1) = 10;
+  QCOMPARE (hm1 == hm2, true);
+
+  hm2(2) = 20;
+  QCOMPARE (hm1 != hm2, true);
+}
+
+/******************************************************************************
+* tests on changes
+******************************************************************************/
+void
+TestFlatHashmap::test_changes() {
+  auto base_m = flat_hashmap<int, int>();
+  auto patch_m = flat_hashmap<int, int>();
+  base_m(1) = 10;
+  base_m(2) = 20;
+  patch_m(2) = -20;
+  patch_m(3) = -30;
+  auto res = changes(patch_m, base_m);
+  QCOMPARE (N(res) == 2, true);
+  QCOMPARE (res[2] == -20, true);
+  QCOMPARE (res[3] == -30, true);
+}
+
+/******************************************************************************
+* tests on invert
+******************************************************************************/
+void
+TestFlatHashmap::test_invert() {
+  auto base_m= flat_hashmap<int, int>();
+  auto patch_m= flat_hashmap<int, int>();
+  base_m(1) = 10;
+  base_m(2) = 20;
+  patch_m(2) = -20;
+  patch_m(3) = -30;
+  auto res= invert(patch_m, base_m);
+  QCOMPARE (N(res) == 2, true);
+  QCOMPARE (res[2] == 20, true);
+  QCOMPARE (res[3] == 0, true);
+}
+
+/******************************************************************************
+* tests on N
+******************************************************************************/
+void
+TestFlatHashmap::test_size () {
+  auto empty_hm = flat_hashmap<int, void*>();
+  QCOMPARE (N(empty_hm) == 0, true);
+
+  auto non_empty_hm = flat_hashmap<int, void*>();
+  non_empty_hm(1) = nullptr;
+  QCOMPARE (N(non_empty_hm) == 1, true);
+}
+
+QTEST_MAIN(TestFlatHashmap)
+#include "flat_hashmap_test.moc"
@@ -22,6 +22,9 @@ private slots:
   void slice ();
   void concat ();
   void append ();
+  void resize ();
+  void intern ();
+  void release_interned ();
 
   void test_as_bool ();
   void test_as_string_bool ();
@@ -96,6 +99,61 @@ TestString::append () {
   QVERIFY (str == string("xyz"));
 }
 
+void
+TestString::resize () {
+  string s;
+  for (int i=0; i<100; i++) s << (char) ('a' + (i % 26));
+  QCOMPARE (N(s), 100);
+  QCOMPARE (s (0, 3) == "abc", true);
+  QCOMPARE (s (26, 29) == "abc", true);
+  QCOMPARE (s (96, 100) == "stuv", true);
+  string t= s (90, 100);
+  QCOMPARE (N(t), 10);
+  t << s;
+  QCOMPARE (N(t), 110);
+  QCOMPARE (t (0, 10) == s (90, 100), true);
+}
+
+void
+TestString::intern () {
+  string a= ::intern (string ("abc"));
+  string b= ::intern (string ("ab") * string ("c"));
+  QCOMPARE (is_interned (a), true);
+  QCOMPARE (is_interned (string ("abc")), false);
+  QCOMPARE (a == b, true);
+  QCOMPARE (a != b, false);
+  QCOMPARE (a == ::intern (string ("abd")), false);
+  QCOMPARE (a == string ("abc"), true);
+  QCOMPARE (hash (a), hash (string ("abc")));
+  string c= a;
+  c << "def";
+  QCOMPARE (c == "abcdef", true);
+  QCOMPARE (b == "abc", true);
+  QCOMPARE (is_interned (c), false);
+  QCOMPARE (a[1], 'b');
+  QCOMPARE (is_interned (a), true);
+  string d= ::intern (string ("abc"));
+  d.detach ();
+  d[0]= 'x';
+  QCOMPARE (d == "xbc", true);
+  QCOMPARE (is_interned (d), false);
+  QCOMPARE (a == "abc", true);
+  QCOMPARE (::intern (string ("abc")) == a, true);
+  QVERIFY (sizeof (string_rep) <= 32);
+}
+
+void
+TestString::release_interned () {
+  string a= ::intern (string ("xyz"));
+  release_interned_strings ();
+  QCOMPARE (is_interned (a), false);
+  QCOMPARE (a == "xyz", true);
+  string b= ::intern (string ("xyz"));
+  QCOMPARE (is_interned (b), true);
+  QCOMPARE (a == b, true);
+  QCOMPARE (a != b, false);
+}
+
 /******************************************************************************
 * Conversions
 ******************************************************************************/
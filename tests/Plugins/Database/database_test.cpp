@@ -0,0 +1,264 @@
+
+/******************************************************************************
+* MODULE     : database_test.cpp
+* DESCRIPTION: tests on queries in TeXmacs databases
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include <QtTest/QtTest>
+#include "Database/database.hpp"
+#include "analyze.hpp"
+#include "file.hpp"
+#include <algorithm>
+#include <string.h>
+
+class TestDatabase: public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_query ();
+  void test_history ();
+  void test_random ();
+  void test_checkpoint ();
+  void test_completions ();
+};
+
+static unsigned int seed= 1;
+
+static int
+random_int (int n) {
+  seed= seed * 1103515245 + 12345;
+  return (int) ((seed >> 16) % n);
+}
+
+static tree
+constraint (string attr, string val) {
+  return tree (TUPLE, scm_quote (attr), scm_quote (val));
+}
+
+static db_atoms
+single (db_atom a) {
+  db_atoms r;
+  r << a;
+  return r;
+}
+
+static db_atoms
+sorted (db_atoms a) {
+  db_atoms r= copy (a);
+  std::sort (A(r), A(r) + N(r));
+  return r;
+}
+
+static db_atoms
+naive_query (database db, db_atoms ids, tree q, db_time t) {
+  // the ids with a value of each constraint in the corresponding field
+  db_atoms r;
+  for (int i=0; i<N(ids); i++) {
+    bool ok= true;
+    for (int j=0; j<N(q) && ok; j++) {
+      db_atom attr= db->as_atom (scm_unquote (q[j][0]->label));
+      db_atoms vals= db->get_field (ids[i], attr, t);
+      bool found= false;
+      for (int k=1; k<N(q[j]); k++)
+        found= found || contains (db->as_atom (scm_unquote (q[j][k]->label)),
+                                  vals);
+      ok= found;
+    }
+    if (ok) r << ids[i];
+  }
+  return r;
+}
+
+/******************************************************************************
+* tests on the agreement with naive queries
+******************************************************************************/
+
+void
+TestDatabase::test_query () {
+  database db (url_none ());
+  db_atom type= db->as_atom ("type"), year= db->as_atom ("year");
+  for (int i=0; i<100; i++) {
+    db_atom id= db->as_atom ("id" * as_string (i));
+    string kind= (i % 3 == 0? string ("book"): string ("article"));
+    db->set_field (id, type, single (db->as_atom (kind)), 1);
+    string y= as_string (2000 + i%10);
+    db->set_field (id, year, single (db->as_atom (y)), 1);
+  }
+  tree q (TUPLE, constraint ("type", "book"), constraint ("year", "2003"));
+  strings r= db->from_atoms (db->query (q, 0, 1000));
+  strings expected;
+  expected << string ("id3") << string ("id33")
+           << string ("id63") << string ("id93");
+  QVERIFY (r == expected);
+  QVERIFY (N(db->query (q, 0, 2)) == 2);
+  q << constraint ("type", "unknown");
+  QVERIFY (N(db->query (q, 0, 1000)) == 0);
+}
+
+void
+TestDatabase::test_history () {
+  database db (url_none ());
+  db_atom id= db->as_atom ("id"), year= db->as_atom ("year");
+  db->set_field (id, year, single (db->as_atom ("2001")), 10);
+  db->set_field (id, year, single (db->as_atom ("2002")), 20);
+  tree q1 (TUPLE, constraint ("year", "2001"));
+  tree q2 (TUPLE, constraint ("year", "2002"));
+  QVERIFY (N(db->query (q1, 15, 1000)) == 1);
+  QVERIFY (N(db->query (q2, 15, 1000)) == 0);
+  QVERIFY (N(db->query (q1, 25, 1000)) == 0);
+  QVERIFY (N(db->query (q2, 25, 1000)) == 1);
+}
+
+void
+TestDatabase::test_random () {
+  database db (url_none ());
+  db_atoms ids;
+  for (int i=0; i<2000; i++) ids << db->as_atom ("id" * as_string (i));
+  for (int step=1; step<=6000; step++) {
+    db_atom id= ids[random_int (N(ids))];
+    db_atom attr= db->as_atom ("a" * as_string (random_int (4)));
+    // a few frequent values and many rare ones
+    int v= random_int (3) == 0? random_int (400): random_int (4);
+    db_atoms vals= single (db->as_atom ("v" * as_string (v)));
+    if (random_int (8) == 0) db->remove_field (id, attr, step);
+    else db->set_field (id, attr, vals, step);
+  }
+  for (int i=0; i<300; i++) {
+    tree q (TUPLE);
+    int nc= 1 + random_int (3);
+    for (int j=0; j<nc; j++) {
+      int v= random_int (2) == 0? random_int (400): random_int (4);
+      tree c= constraint ("a" * as_string (random_int (4)), "v" * as_string (v));
+      if (random_int (3) == 0) c << scm_quote ("v" * as_string (random_int (4)));
+      q << c;
+    }
+    db_time t= (random_int (2) == 0? 0: 1 + random_int (6000));
+    db_atoms r= db->query (q, t, 1000000);
+    QVERIFY (sorted (r) == naive_query (db, ids, q, t));
+    db_atoms first= db->query (q, t, 5);
+    QVERIFY (first == range (r, 0, std::min (N(r), 5)));
+  }
+}
+
+/******************************************************************************
+* tests on reopening databases from checkpoints
+******************************************************************************/
+
+static bool
+same_database (database db1, database db2, int n) {
+  for (int i=0; i<n; i++) {
+    string id= "id" * as_string (i);
+    tree e1= db1->entry_from_atoms (db1->get_entry (db1->as_atom (id), 0));
+    tree e2= db2->entry_from_atoms (db2->get_entry (db2->as_atom (id), 0));
+    if (e1 != e2) return false;
+  }
+  for (int i=0; i<50; i++) {
+    tree q (TUPLE, tree (TUPLE, "contains", scm_quote ("word" * as_string (i))));
+    q << tree (TUPLE, "completes", scm_quote ("tit"));
+    strings r1= db1->from_atoms (db1->query (q, 0, 1000000));
+    strings r2= db2->from_atoms (db2->query (q, 0, 1000000));
+    if (r1 != r2 || N(r1) == 0) return false;
+  }
+  return true;
+}
+
+static bool
+checkpoint_covers (url u, url cp) {
+  // the checkpoint records the length and hash code of the whole journal
+  string journal, s;
+  if (load_string (u, journal, false) || load_string (cp, s, false))
+    return false;
+  int pos= strlen ("%-%-tm-db-checkpoint-1-%-%\n"), h[3];
+  if (N(s) < pos + (int) sizeof (h)) return false;
+  memcpy (h, s.data () + pos, sizeof (h));
+  return h[1] == N(journal) && h[2] == hash (journal);
+}
+
+void
+TestDatabase::test_checkpoint () {
+  url u= url_temp (".tmdb");
+  url cp= glue (u, ".checkpoint");
+  int n= 8000;
+  for (int i=0; i<n; i++) {
+    string id= "id" * as_string (i);
+    strings title, name;
+    title << ("title" * as_string (i) * " word" * as_string (i % 50));
+    name << ("author" * as_string (i % 300));
+    set_field (u, id, "title", title, 1000 + i);
+    set_field (u, id, "name", name, 1000 + i);
+  }
+  sync_databases ();
+  QVERIFY (exists (cp));
+  QVERIFY (checkpoint_covers (u, cp));
+  // the tail of the journal after the checkpoint is replayed
+  strings title;
+  title << string ("new title word7");
+  set_field (u, "id7", "title", title, 9000);
+  remove_field (u, "id8", "name", 9000);
+  sync_databases ();
+  database db1 (u);
+  QVERIFY (db1->from_atoms (db1->get_field (db1->as_atom ("id7"),
+                                            db1->as_atom ("title"), 10000))
+           == title);
+  remove (cp);
+  database db2 (u);
+  QVERIFY (same_database (db1, db2, n));
+  remove (u);
+  remove (cp);
+}
+
+/******************************************************************************
+* tests on completions
+******************************************************************************/
+
+static strings
+make_strings (string s1, string s2= "", string s3= "") {
+  strings r;
+  r << s1;
+  if (s2 != "") r << s2;
+  if (s3 != "") r << s3;
+  return r;
+}
+
+void
+TestDatabase::test_completions () {
+  url u= url_temp (".tmdb");
+  const char* names[]= { "Smith", "Smithson", "Smith", "Smyth",
+                         "Smithson", "Smith", "Jones" };
+  const char* titles[]= { "Quantum field theory", "Quaternions",
+                          "Quantum groups", "Groups", "Fields",
+                          "Theory of quanta", "Rings" };
+  for (int i=0; i<7; i++) {
+    string id= "id" * as_string (i);
+    set_field (u, id, "name", make_strings (names[i]), 1);
+    set_field (u, id, "title", make_strings (titles[i]), 1);
+  }
+  // ranked by the number of occurrences, then by creation
+  QVERIFY (get_name_completions (u, "Sm") ==
+           make_strings ("Smith", "Smithson", "Smyth"));
+  QVERIFY (get_name_completions (u, "Smi") ==
+           make_strings ("Smith", "Smithson"));
+  QVERIFY (N(get_name_completions (u, "Smx")) == 0);
+  QVERIFY (N(get_name_completions (u, "")) == 0);
+  QVERIFY (get_completions (u, "qua") ==
+           make_strings ("quantum", "quaternions", "quanta"));
+  // at most one edit in the typed prefix
+  QVERIFY (get_fuzzy_name_completions (u, "Smyt") ==
+           make_strings ("Smith", "Smithson", "Smyth"));
+  QVERIFY (get_fuzzy_name_completions (u, "Jnes") == make_strings ("Jones"));
+  QVERIFY (get_fuzzy_completions (u, "qunt") ==
+           make_strings ("quantum", "quaternions", "quanta"));
+  QVERIFY (N(get_fuzzy_completions (u, "xyz")) == 0);
+  // completions of keywords in queries
+  tree q (TUPLE, tree (TUPLE, "completes", scm_quote ("quant")));
+  QVERIFY (query (u, q, 0, 100) == make_strings ("id0", "id2", "id5"));
+  remove (u);
+}
+
+QTEST_MAIN(TestDatabase)
+#include "database_test.moc"
@@ -0,0 +1,99 @@
+
+/******************************************************************************
+* MODULE     : qt_glyph_atlas_test.cpp
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QPainter>
+#include <QPicture>
+#include "Qt/qt_glyph_atlas.hpp"
+
+class TestQtGlyphAtlas: public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_colour ();
+  void test_recording ();
+};
+
+static font_glyphs
+test_glyphs () {
+  // a filled rectangle and a diagonal
+  glyph* gls= tm_new_array<glyph> (2);
+  gls[0]= glyph (5, 3, 0, 2);
+  gls[1]= glyph (7, 7, 0, 6);
+  for (int y=0; y<3; y++)
+    for (int x=0; x<5; x++) gls[0]->set_1 (x, y, 1);
+  for (int i=0; i<7; i++) gls[1]->set_1 (i, i, 1);
+  return std_font_glyphs ("glyph-atlas-test", gls, 0, 1);
+}
+
+static const QRgb*
+test_colors () {
+  static QRgb lut[256];
+  for (int col=0; col<256; col++)
+    lut[col]= qPremultiply (qRgba (255, 0, 0, col == 0? 0: 255));
+  return lut;
+}
+
+void
+TestQtGlyphAtlas::test_colour () {
+  qt_glyph_atlas_rep atlas (1 << 20);
+  font_glyphs fng= test_glyphs ();
+  atlas_glyph ag= atlas.get (1, fng, 1);
+  QVERIFY (!is_nil (ag));
+  QCOMPARE (ag->w, 7);
+  QCOMPARE (ag->h, 7);
+  QImage im= atlas.image (ag, test_colors ());
+  QCOMPARE (im.size (), QSize (7, 7));
+  for (int y=0; y<7; y++)
+    for (int x=0; x<7; x++)
+      QCOMPARE (qAlpha (im.pixel (x, y)), x == y? 255: 0);
+
+  QImage buffer (16, 16, QImage::Format_ARGB32_Premultiplied);
+  buffer.fill (0);
+  atlas.colour (ag, test_colors (), buffer);
+  QCOMPARE (buffer.copy (0, 0, 7, 7), im);
+  QCOMPARE (qAlpha (buffer.pixel (8, 8)), 0);
+}
+
+void
+TestQtGlyphAtlas::test_recording () {
+  // Images which are recorded into a picture are not written to anymore
+  qt_glyph_atlas_rep atlas (1 << 20);
+  font_glyphs fng= test_glyphs ();
+  atlas_glyph ag0= atlas.get (0, fng, 1);
+  atlas_glyph ag1= atlas.get (1, fng, 1);
+  QImage im0= atlas.image (ag0, test_colors ());
+  QImage expected= im0.copy ();
+  qint64 key= im0.cacheKey ();
+
+  QPicture pic;
+  QPainter rec (&pic);
+  rec.drawImage (0, 0, im0);
+  QImage im1= atlas.image (ag1, test_colors ());
+  rec.drawImage (0, 0, im1);
+  rec.end ();
+  QCOMPARE (im0.cacheKey (), key);
+  QCOMPARE (im0, expected);
+  QVERIFY (im0.constBits () != im1.constBits ());
+
+  QImage out (7, 7, QImage::Format_ARGB32_Premultiplied);
+  out.fill (0);
+  QPainter play (&out);
+  play.drawPicture (0, 0, pic);
+  play.end ();
+  for (int y=0; y<7; y++)
+    for (int x=0; x<7; x++) {
+      bool on= (x < 5 && y < 3) || x == y;
+      QCOMPARE (qAlpha (out.pixel (x, y)), on? 255: 0);
+    }
+}
+
+QTEST_MAIN(TestQtGlyphAtlas)
+#include "qt_glyph_atlas_test.moc"
@@ -0,0 +1,150 @@
+
+/******************************************************************************
+* MODULE     : memo_store_test.cpp
+* DESCRIPTION: tests on the persistent memorization of style evaluations
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include <QtTest/QtTest>
+#include "memo_store.hpp"
+#include "file.hpp"
+#include "sys_utils.hpp"
+#include "drd_std.hpp"
+
+class TestMemoStore: public QObject {
+  Q_OBJECT
+
+private slots:
+  void initTestCase ();
+  void test_sessions ();
+  void test_dependencies ();
+  void test_state ();
+  void test_eviction ();
+};
+
+static hashmap<string,tree> no_refs (UNINIT);
+
+static tree
+remember (tree style, tree t, tree r, hashmap<string,tree> H,
+          hashmap<string,tree> refs, string var, string ref,
+          string state= "", string local_ref= "") {
+  hashmap<string,bool> vars (false), used (false), local (false);
+  if (var != "") vars (var)= true;
+  if (ref != "") used (ref)= true;
+  if (local_ref != "") local (local_ref)= true;
+  tree deps= memo_dependencies (vars, used, local, H, refs, no_refs);
+  memo_remember (style, memo_key (style, t, state), r, deps);
+  return deps;
+}
+
+static bool
+lookup (tree style, tree t, hashmap<string,tree> H,
+        hashmap<string,tree> refs, tree& r, string state= "",
+        hashmap<string,tree> grefs= no_refs) {
+  return memo_lookup (style, memo_key (style, t, state), H, refs, grefs, r);
+}
+
+void
+TestMemoStore::initTestCase () {
+  init_std_drd ();
+  url home= url_temp_dir () * "home";
+  set_env ("TEXMACS_HOME_PATH", as_string (home));
+  mkdir (home);
+  memo_invalidate ();
+}
+
+/******************************************************************************
+* tests on keeping the results from one session to another
+******************************************************************************/
+
+void
+TestMemoStore::test_sessions () {
+  tree style (TUPLE, "article");
+  tree t (CONCAT, "a", tree (VALUE, "x"));
+  hashmap<string,tree> H (UNINIT);
+  H ("x")= "1";
+  remember (style, t, "a1", H, no_refs, "x", "");
+  // the results are only written to disk in one batch
+  url file ("$TEXMACS_HOME_PATH/system/cache/memo",
+            memo_digest (style) * ".scm");
+  QVERIFY (!exists (file));
+  memo_flush ();
+  QVERIFY (exists (file));
+  // a new session finds back the result
+  memo_unload ();
+  tree r;
+  QVERIFY (lookup (style, t, H, no_refs, r));
+  QVERIFY (r == tree ("a1"));
+  QVERIFY (!lookup (tree (TUPLE, "book"), t, H, no_refs, r));
+}
+
+void
+TestMemoStore::test_dependencies () {
+  tree style (TUPLE, "article");
+  tree t (CONCAT, "b", tree (VALUE, "x"), tree (GET_BINDING, "lab"));
+  hashmap<string,tree> H (UNINIT), refs (UNINIT);
+  H ("x")= "1";
+  H ("y")= "1";
+  refs ("lab")= tuple ("2", "3");
+  remember (style, t, "b12", H, refs, "x", "lab");
+  memo_unload ();
+  tree r;
+  // variables and references which were not read do not matter
+  H ("y")= "2";
+  refs ("other")= tuple ("4", "5");
+  QVERIFY (lookup (style, t, H, refs, r));
+  QVERIFY (r == tree ("b12"));
+  // the result is no longer valid if the values which were read changed
+  refs ("lab")= tuple ("3", "3");
+  QVERIFY (!lookup (style, t, H, refs, r));
+  refs ("lab")= tuple ("2", "3");
+  H ("x")= "2";
+  QVERIFY (!lookup (style, t, H, refs, r));
+}
+
+void
+TestMemoStore::test_state () {
+  tree style (TUPLE, "article");
+  tree t (CONCAT, "c", tree (REFERENCE, "lab"));
+  hashmap<string,tree> H (UNINIT), refs (UNINIT), grefs (UNINIT);
+  remember (style, t, "c1", H, refs, "", "", "roman|1", "lab");
+  tree r;
+  QVERIFY (lookup (style, t, H, refs, r, "roman|1"));
+  // the font and magnification are not read through the variables
+  QVERIFY (!lookup (style, t, H, refs, r, "roman|2"));
+  // references which are expanded afterwards are only looked up locally
+  grefs ("lab")= tuple ("4", "5");
+  QVERIFY (lookup (style, t, H, refs, r, "roman|1", grefs));
+  refs ("lab")= tuple ("4", "5");
+  QVERIFY (!lookup (style, t, H, refs, r, "roman|1", grefs));
+}
+
+void
+TestMemoStore::test_eviction () {
+  tree style (TUPLE, "letter");
+  hashmap<string,tree> H (UNINIT);
+  int n= 4096;
+  for (int i=0; i<n; i++)
+    remember (style, as_string (i), as_string (i), H, no_refs, "", "");
+  // using the oldest entry keeps it when the store is full
+  tree r;
+  QVERIFY (lookup (style, "0", H, no_refs, r));
+  remember (style, "new", "new", H, no_refs, "", "");
+  QVERIFY (lookup (style, "new", H, no_refs, r));
+  QVERIFY (lookup (style, "0", H, no_refs, r));
+  QVERIFY (!lookup (style, "1", H, no_refs, r));
+  QVERIFY (lookup (style, as_string (n-1), H, no_refs, r));
+  // and this survives from one session to another
+  memo_unload ();
+  QVERIFY (lookup (style, "0", H, no_refs, r));
+  QVERIFY (!lookup (style, "1", H, no_refs, r));
+  memo_invalidate ();
+  QVERIFY (!lookup (style, "0", H, no_refs, r));
+}
+
+QTEST_MAIN(TestMemoStore)
+#include "memo_store_test.moc"
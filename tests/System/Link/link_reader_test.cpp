@@ -0,0 +1,112 @@
+
+/******************************************************************************
+* MODULE     : link_reader_test.cpp
+* DESCRIPTION: tests on the reading of data from pipes
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include <QtTest/QtTest>
+#include "link_reader.hpp"
+#include <unistd.h>
+#include <sys/wait.h>
+
+class TestLinkReader: public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_chunks ();
+  void test_poller ();
+  void test_pending ();
+};
+
+static string
+sample (int n) {
+  string s (n);
+  for (int i=0; i<n; i++) s[i]= (char) ((i * 7) % 251);
+  return s;
+}
+
+static int
+spawn_writer (int fd[2], string s) {
+  // a child process which writes s to the pipe and exits
+  int pid= fork ();
+  if (pid == 0) {
+    close (fd[0]);
+    int done= 0;
+    while (done < N(s)) {
+      int r= ::write (fd[1], &s[done], N(s) - done);
+      if (r <= 0) _exit (1);
+      done += r;
+    }
+    _exit (0);
+  }
+  close (fd[1]);
+  return pid;
+}
+
+/******************************************************************************
+* tests on reading until the end of the data
+******************************************************************************/
+
+void
+TestLinkReader::test_chunks () {
+  int fd[2];
+  QVERIFY (pipe (fd) == 0);
+  string s= sample (5 * LINK_CHUNK_SIZE + 123);
+  int pid= spawn_writer (fd, s);
+  QVERIFY (link_set_nonblocking (fd[0]));
+  link_poller poller;
+  poller->add (fd[0]);
+  string buf;
+  int r= LINK_READ_AGAIN;
+  while (r == LINK_READ_AGAIN)
+    if (poller->wait (2000) > 0)
+      r= link_read_available (fd[0], buf);
+  QVERIFY (r == LINK_READ_EOF);
+  QVERIFY (buf == s);
+  close (fd[0]);
+  waitpid (pid, NULL, 0);
+}
+
+void
+TestLinkReader::test_poller () {
+  int fd1[2], fd2[2];
+  QVERIFY (pipe (fd1) == 0 && pipe (fd2) == 0);
+  link_poller poller;
+  poller->add (fd1[0]);
+  poller->add (fd2[0]);
+  QVERIFY (poller->wait (0) == 0);
+  QVERIFY (::write (fd2[1], "x", 1) == 1);
+  QVERIFY (poller->wait (1000) == 1);
+  QVERIFY (poller->ready[0] == fd2[0]);
+  poller->remove (fd2[0]);
+  QVERIFY (poller->wait (0) == 0);
+  close (fd1[0]); close (fd1[1]);
+  close (fd2[0]); close (fd2[1]);
+}
+
+void
+TestLinkReader::test_pending () {
+  int fd[2];
+  QVERIFY (pipe (fd) == 0);
+  QVERIFY (link_set_nonblocking (fd[0]));
+  QVERIFY (::write (fd[1], "abc", 3) == 3);
+  // nothing is read as long as too much output is pending
+  string buf (LINK_MAX_PENDING);
+  QVERIFY (link_read_available (fd[0], buf) == LINK_READ_FULL);
+  QVERIFY (N(buf) == LINK_MAX_PENDING);
+  buf= "";
+  QVERIFY (link_read_available (fd[0], buf) == LINK_READ_AGAIN);
+  QVERIFY (buf == "abc");
+  QVERIFY (link_read_available (fd[0], buf) == LINK_READ_AGAIN);
+  close (fd[1]);
+  QVERIFY (link_read_available (fd[0], buf) == LINK_READ_EOF);
+  close (fd[0]);
+}
+
+QTEST_MAIN(TestLinkReader)
+#include "link_reader_test.moc"
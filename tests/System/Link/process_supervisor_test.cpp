@@ -0,0 +1,141 @@
+
+/******************************************************************************
+* MODULE     : process_supervisor_test.cpp
+* DESCRIPTION: tests on the termination of plugin processes
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include <QtTest/QtTest>
+#include "process_supervisor.hpp"
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+
+class TestProcessSupervisor: public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_terminate ();
+  void test_grace ();
+  void test_finish ();
+  void test_group ();
+};
+
+static int
+spawn (bool stubborn) {
+  // a child in its own process group which waits until it is killed
+  int pid= fork ();
+  if (pid == 0) {
+    setpgid (0, 0);
+    if (stubborn) signal (SIGTERM, SIG_IGN);
+    while (true) pause ();
+  }
+  setpgid (pid, pid);
+  // give the child the time to install its signal handler
+  usleep (20000);
+  return pid;
+}
+
+static int
+spawn_group (int& alive) {
+  // a leader which exits on SIGTERM and a member of its group which waits
+  // until it is killed; the pipe alive reaches its end when the member died
+  int fd[2];
+  if (pipe (fd) != 0) return -1;
+  int pid= fork ();
+  if (pid == 0) {
+    setpgid (0, 0);
+    if (fork () == 0) {
+      signal (SIGTERM, SIG_IGN);
+      while (true) pause ();
+    }
+    close (fd[1]);
+    while (true) pause ();
+  }
+  setpgid (pid, pid);
+  close (fd[1]);
+  alive= fd[0];
+  usleep (20000);
+  return pid;
+}
+
+static bool
+died (int alive) {
+  struct pollfd pfd;
+  pfd.fd= alive;
+  pfd.events= POLLIN;
+  pfd.revents= 0;
+  return poll (&pfd, 1, 0) > 0;
+}
+
+static bool
+finished (int pid) {
+  process_stats st;
+  return get_process_stats (pid, st) && !st.running;
+}
+
+/******************************************************************************
+* tests on terminating processes without waiting for them
+******************************************************************************/
+
+void
+TestProcessSupervisor::test_terminate () {
+  int pid= spawn (false);
+  process_stats st;
+  QVERIFY (get_process_stats (pid, st) && st.running && st.memory > 0);
+  QElapsedTimer timer;
+  timer.start ();
+  terminate_process (pid, true, 10000);
+  QVERIFY (timer.elapsed () < 100);
+  QTRY_VERIFY_WITH_TIMEOUT (finished (pid), 1000);
+  QVERIFY (timer.elapsed () < 1000);
+}
+
+void
+TestProcessSupervisor::test_grace () {
+  int pid= spawn (true);
+  QElapsedTimer timer;
+  timer.start ();
+  terminate_process (pid, true, 300);
+  QVERIFY (timer.elapsed () < 100);
+  QTRY_VERIFY_WITH_TIMEOUT (finished (pid), 1500);
+  QVERIFY (timer.elapsed () >= 250);
+}
+
+void
+TestProcessSupervisor::test_finish () {
+  int pid1= spawn (true), pid2= spawn (true);
+  QElapsedTimer timer;
+  timer.start ();
+  terminate_process (pid1, true, 10000);
+  terminate_process (pid2, true, 10000);
+  // both processes ignore SIGTERM, so they are killed after 200 ms
+  finish_processes (200);
+  QVERIFY (timer.elapsed () < 1000);
+  QTRY_VERIFY_WITH_TIMEOUT (finished (pid1) && finished (pid2), 1000);
+}
+
+void
+TestProcessSupervisor::test_group () {
+  int alive;
+  int pid= spawn_group (alive);
+  QVERIFY (pid > 0);
+  terminate_process (pid, true, 300);
+  // the leader exits at once, but the group is killed after 300 ms
+  QTRY_VERIFY_WITH_TIMEOUT (finished (pid), 1000);
+  QVERIFY (!died (alive));
+  QTRY_VERIFY_WITH_TIMEOUT (died (alive), 1500);
+  close (alive);
+  // the empty group is no longer supervised
+  QElapsedTimer timer;
+  timer.start ();
+  finish_processes (1000);
+  QVERIFY (timer.elapsed () < 500);
+}
+
+QTEST_MAIN(TestProcessSupervisor)
+#include "process_supervisor_test.moc"
@@ -0,0 +1,127 @@
+
+/******************************************************************************
+* MODULE     : data_cache_test.cpp
+* DESCRIPTION: tests on the binary cache files
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include <QtTest/QtTest>
+#include "data_cache.hpp"
+#include "file.hpp"
+#include "sys_utils.hpp"
+#include "drd_std.hpp"
+
+class TestDataCache: public QObject {
+  Q_OBJECT
+
+private slots:
+  void initTestCase ();
+  void test_reload ();
+  void test_append ();
+  void test_text_format ();
+  void test_rewrite ();
+};
+
+static url
+cache_file (string buffer) {
+  return url_system ("$TEXMACS_HOME_PATH/system/cache") * buffer;
+}
+
+void
+TestDataCache::initTestCase () {
+  init_std_drd ();
+  url home= url_temp_dir () * "home";
+  set_env ("TEXMACS_HOME_PATH", as_string (home));
+  mkdir (home);
+  mkdir (home * "system");
+  mkdir (home * "system/cache");
+  cache_initialize ();
+  cache_refresh ();
+}
+
+/******************************************************************************
+* tests on saving and reloading caches
+******************************************************************************/
+
+void
+TestDataCache::test_reload () {
+  tree val= tuple ("a", tree (CONCAT, "b", "c"));
+  cache_set ("stat_cache.scm", "key", val);
+  cache_set ("stat_cache.scm", tuple ("x", "y"), "atom");
+  cache_set ("file_cache", "name", "line 1\nline 2\n");
+  cache_save ("stat_cache.scm");
+  cache_save ("file_cache");
+  cache_refresh ();
+  QVERIFY (is_cached ("stat_cache.scm", "key"));
+  QVERIFY (cache_get ("stat_cache.scm", "key") == val);
+  QVERIFY (cache_get ("stat_cache.scm", tuple ("x", "y")) == "atom");
+  QVERIFY (cache_get ("file_cache", "name") == "line 1\nline 2\n");
+  QVERIFY (!is_cached ("stat_cache.scm", "other"));
+}
+
+void
+TestDataCache::test_append () {
+  for (int i=0; i<100; i++)
+    cache_set ("dir_cache.scm", as_string (i), as_string (i*i));
+  cache_save ("dir_cache.scm");
+  cache_refresh ();
+  int size= file_size (cache_file ("dir_cache.scm"));
+  cache_set ("dir_cache.scm", "7", "seven");
+  cache_reset ("dir_cache.scm", "8");
+  cache_save ("dir_cache.scm");
+  cache_refresh ();
+  // only the changes were written at the end of the file
+  int grown= file_size (cache_file ("dir_cache.scm"));
+  QVERIFY (size < grown && grown < size + 64);
+  QVERIFY (cache_get ("dir_cache.scm", "7") == "seven");
+  QVERIFY (!is_cached ("dir_cache.scm", "8"));
+  QVERIFY (cache_get ("dir_cache.scm", "99") == "9801");
+}
+
+void
+TestDataCache::test_text_format () {
+  // caches written by former versions are read and converted
+  url u= cache_file ("font_cache.scm");
+  QVERIFY (!save_string (u, "(tuple \"k\" (tuple \"v\" \"w\"))"));
+  cache_refresh ();
+  QVERIFY (cache_get ("font_cache.scm", "k") == tuple ("v", "w"));
+  cache_save ("font_cache.scm");
+  string s;
+  QVERIFY (!load_string (u, s, false));
+  QVERIFY (starts (s, "%-%-tm-cache-binary"));
+  cache_refresh ();
+  QVERIFY (cache_get ("font_cache.scm", "k") == tuple ("v", "w"));
+}
+
+void
+TestDataCache::test_rewrite () {
+  for (int i=0; i<2000; i++)
+    cache_set ("validate_cache.scm", as_string (i), as_string (i));
+  cache_save ("validate_cache.scm");
+  cache_refresh ();
+  int size= file_size (cache_file ("validate_cache.scm"));
+  for (int i=1; i<2000; i++)
+    cache_reset ("validate_cache.scm", as_string (i));
+  // too many obsolete records: the mapped file is replaced
+  cache_save ("validate_cache.scm");
+  int shrunk= file_size (cache_file ("validate_cache.scm"));
+  QVERIFY (shrunk < size / 100);
+  QVERIFY (cache_get ("validate_cache.scm", "0") == "0");
+  QVERIFY (!is_cached ("validate_cache.scm", "1"));
+  // later changes are appended again
+  cache_set ("validate_cache.scm", "new", "value");
+  cache_save ("validate_cache.scm");
+  int grown= file_size (cache_file ("validate_cache.scm"));
+  QVERIFY (shrunk < grown && grown < shrunk + 64);
+  cache_refresh ();
+  QVERIFY (cache_get ("validate_cache.scm", "0") == "0");
+  QVERIFY (cache_get ("validate_cache.scm", "new") == "value");
+  QVERIFY (!is_cached ("validate_cache.scm", "1999"));
+}
+
+QTEST_MAIN(TestDataCache)
+#include "data_cache_test.moc"
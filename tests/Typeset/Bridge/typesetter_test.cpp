@@ -0,0 +1,71 @@
+
+/******************************************************************************
+* MODULE     : typesetter_test.cpp
+* DESCRIPTION: tests on the reuse of the screen typesetting for printing
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include <QtTest/QtTest>
+#include "typesetter.hpp"
+#include "vars.hpp"
+
+class TestTypesetter: public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_page_layout ();
+};
+
+static hashmap<string,tree>
+screen_env () {
+  hashmap<string,tree> H (UNINIT);
+  H (DPI)               = "600";
+  H (PAGE_SHOW_HF)      = "false";
+  H (PAGE_SCREEN_MARGIN)= "true";
+  H (PAGE_BORDER)       = "attached";
+  H (BG_COLOR)          = "white";
+  H (PAGE_MEDIUM)       = "paper";
+  H (PAGE_PRINTED)      = "false";
+  return H;
+}
+
+static hashmap<string,tree>
+print_env () {
+  // the changes made by print_doc for non conform printing
+  hashmap<string,tree> H= copy (screen_env ());
+  H (PAGE_SHOW_HF)      = "true";
+  H (PAGE_SCREEN_MARGIN)= "false";
+  H (PAGE_BORDER)       = "none";
+  H (PAGE_MEDIUM)       = "paper";
+  H (PAGE_PRINTED)      = "true";
+  return H;
+}
+
+/******************************************************************************
+* tests on the decision to reuse the lines of the screen
+******************************************************************************/
+
+void
+TestTypesetter::test_page_layout () {
+  QVERIFY (only_page_layout_changed (screen_env (), screen_env ()));
+  hashmap<string,tree> S= screen_env (), P= print_env ();
+  QVERIFY (!only_page_layout_changed (S, P));
+  S (PAGE_PRINTED)= "true";
+  QVERIFY (only_page_layout_changed (S, P));
+  S (PAGE_MEDIUM)= "papyrus";
+  QVERIFY (!only_page_layout_changed (S, P));
+  S= screen_env ();
+  S (PAGE_PRINTED)= "true";
+  P (DPI)= "1200";
+  QVERIFY (!only_page_layout_changed (S, P));
+  P= print_env ();
+  P (BG_COLOR)= "black";
+  QVERIFY (!only_page_layout_changed (S, P));
+}
+
+QTEST_MAIN(TestTypesetter)
+#include "typesetter_test.moc"
@@ -0,0 +1,105 @@
+
+/******************************************************************************
+* MODULE     : line_breaker_test.cpp
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "Boxes/construct.hpp"
+#include "Format/line_item.hpp"
+#include <QtTest/QtTest>
+
+array<path>
+line_breaks (array<line_item> a, int start, int end,
+	     SI line_width, SI large_width,
+             SI first_spc, SI last_spc, bool ragged);
+
+static array<line_item>
+test_items (int n, SI w) {
+  // n items of width w, separated by a space of 10 which may shrink to 5
+  array<line_item> a;
+  for (int i=0; i<n; i++) {
+    box b= empty_box (path (), 0, 0, w * PIXEL, 10 * PIXEL);
+    line_item item (STD_ITEM, 0, b, 0);
+    item->spc= space (5 * PIXEL, 10 * PIXEL, 15 * PIXEL);
+    a << item;
+  }
+  return a;
+}
+
+static array<path>
+test_breaks (array<line_item> a, SI w) {
+  return line_breaks (a, 0, N(a), w * PIXEL, 2 * w * PIXEL, 0, 0, false);
+}
+
+static array<path>
+as_breaks (array<int> a) {
+  array<path> r;
+  for (int i=0; i<N(a); i++) r << path (a[i]);
+  return r;
+}
+
+class TestLineBreaker: public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_two_per_line ();
+  void test_fill ();
+  void test_forced_break ();
+  void test_cache ();
+};
+
+void
+TestLineBreaker::test_two_per_line () {
+  // one item is too short, three are too long
+  array<int> expected;
+  for (int i=0; i<=10; i+=2) expected << i;
+  QCOMPARE (test_breaks (test_items (10, 45), 100), as_breaks (expected));
+}
+
+void
+TestLineBreaker::test_fill () {
+  // three items are too short, four fit when the spaces shrink
+  array<int> expected;
+  expected << 0 << 4 << 8 << 10;
+  QCOMPARE (test_breaks (test_items (10, 20), 100), as_breaks (expected));
+}
+
+void
+TestLineBreaker::test_forced_break () {
+  array<line_item> a= test_items (10, 20);
+  box b= empty_box (path ());
+  line_item br (CONTROL_ITEM, 0, b, HYPH_INVALID, tree (LINE_BREAK));
+  br->spc= space (0);
+  array<line_item> c;
+  for (int i=0; i<N(a); i++) {
+    c << a[i];
+    if (i == 1) c << br;
+  }
+  array<path> ap= test_breaks (c, 100);
+  QCOMPARE (ap[0], path (0));
+  QCOMPARE (ap[1], path (3));
+  QCOMPARE (ap[N(ap)-1], path (11));
+}
+
+void
+TestLineBreaker::test_cache () {
+  // unchanged paragraphs get the same breaks, changed ones are broken again
+  array<line_item> a= test_items (10, 20);
+  array<path> ap1= test_breaks (a, 100);
+  array<path> ap2= test_breaks (test_items (10, 20), 100);
+  QCOMPARE (ap1, ap2);
+  array<int> pairs;
+  for (int i=0; i<=10; i+=2) pairs << i;
+  QCOMPARE (test_breaks (test_items (10, 45), 100), as_breaks (pairs));
+  array<int> single;
+  single << 0 << 10;
+  QCOMPARE (test_breaks (test_items (10, 20), 1000), as_breaks (single));
+  QCOMPARE (test_breaks (a, 100), ap1);
+}
+
+QTEST_MAIN(TestLineBreaker)
+#include "line_breaker_test.moc"
@@ -0,0 +1,77 @@
+
+/******************************************************************************
+* MODULE     : fast_breaker_test.cpp
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "fast_breaker.hpp"
+#include "language.hpp"
+#include <QtTest/QtTest>
+
+static fast_flow
+synthetic_flow (int n, unsigned seed) {
+  // Lines of varying heights with a mixture of penalties
+  static const int pens[]= { 0, 1, 1, 1, 10, 100, HYPH_INVALID };
+  fast_flow fl;
+  fl.n= n;
+  fl.last_page_flag= true;
+  fl.h_min= 480; fl.h_def= 500; fl.h_max= 520;
+  fl.tot_min.resize (n); fl.tot_def.resize (n); fl.tot_max.resize (n);
+  fl.cor_min.assign (n, 0); fl.cor_def.assign (n, 0); fl.cor_max.assign (n, 0);
+  fl.pens.resize (n);
+  SI tot= 0;
+  for (int i=0; i<n; i++) {
+    seed= seed * 1103515245 + 12345;
+    tot += 8 + ((seed >> 16) % 5);
+    fl.tot_min[i]= tot - 2 * (i+1);
+    fl.tot_def[i]= tot;
+    fl.tot_max[i]= tot + 2 * (i+1);
+    fl.pens[i]= pens[(seed >> 8) % 7];
+  }
+  return fl;
+}
+
+class TestFastBreaker: public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_break_pages ();
+  void test_parallel ();
+};
+
+void
+TestFastBreaker::test_break_pages () {
+  fast_flow fl= synthetic_flow (500, 1);
+  std::vector<int> prev;
+  fl.break_pages (prev, false);
+  QCOMPARE ((int) prev.size (), 501);
+  QCOMPARE (prev[0], -2);
+  int pages= 0;
+  for (int i= 500; i > 0; i= prev[i]) {
+    QVERIFY (prev[i] >= 0 && prev[i] < i);
+    QVERIFY (i == 500 || fl.pens[i-1] < HYPH_INVALID);
+    pages++;
+  }
+  QVERIFY (pages >= 9 && pages <= 12);
+}
+
+void
+TestFastBreaker::test_parallel () {
+  // The precomputation in blocks must not change the result
+  int n= 3 * FAST_BLOCK + 17;
+  for (unsigned seed= 1; seed <= 3; seed++) {
+    fast_flow fl= synthetic_flow (n, seed);
+    std::vector<int> seq, par;
+    fl.break_pages (seq, false);
+    fl.break_pages (par, true);
+    QVERIFY (seq == par);
+    QVERIFY (seq[n] >= 0);
+  }
+}
+
+QTEST_MAIN(TestFastBreaker)
+#include "fast_breaker_test.moc"
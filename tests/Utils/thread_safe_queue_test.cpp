@@ -0,0 +1,128 @@
+
+/******************************************************************************
+* MODULE     : thread_safe_queue_test.cpp
+* DESCRIPTION: test on the bounded multi-producer multi-consumer queue
+* COPYRIGHT  : (C) 2026  The TeXmacs team
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include <QtTest/QtTest>
+#include <thread>
+#include <vector>
+#include "Utils/ThreadSafeQueue.hpp"
+
+using texmacs::thread_safe_queue;
+
+class TestThreadSafeQueue: public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_fifo ();
+  void test_full ();
+  void test_destroy ();
+  void test_concurrent ();
+};
+
+/******************************************************************************
+* tests on the order of the elements
+******************************************************************************/
+void
+TestThreadSafeQueue::test_fifo () {
+  thread_safe_queue<int, 10> q;
+  QCOMPARE (q.getCapacity (), 16);
+  for (int k=0; k<5; k++) {
+    for (int i=0; i<10; i++) QCOMPARE (q.push (i), true);
+    QCOMPARE (q.getCurrentSize (), 10);
+    for (int i=0; i<10; i++) {
+      int x;
+      QCOMPARE (q.pop (x), true);
+      QCOMPARE (x, i);
+    }
+  }
+  int x;
+  QCOMPARE (q.tryPop (x), false);
+  QCOMPARE (q.getMaximalSize (), 10);
+}
+
+/******************************************************************************
+* tests on a full queue
+******************************************************************************/
+void
+TestThreadSafeQueue::test_full () {
+  thread_safe_queue<int, 4> q;
+  for (int i=0; i<4; i++) QCOMPARE (q.tryPush (i), true);
+  QCOMPARE (q.tryPush (4), false);
+  QCOMPARE (q.getCurrentSize (), 4);
+  QCOMPARE (q.getMaximalSize (), 4);
+
+  std::thread consumer ([&q] () {
+    std::this_thread::sleep_for (std::chrono::milliseconds (20));
+    int x;
+    q.pop (x);
+  });
+  QCOMPARE (q.push (4), true); // blocks until the consumer pops
+  consumer.join ();
+  QCOMPARE (q.getPushWaits (), 1L);
+  QVERIFY (q.getPushWaitTime () > 0);
+
+  int x;
+  for (int i=1; i<5; i++) {
+    QCOMPARE (q.pop (x), true);
+    QCOMPARE (x, i);
+  }
+}
+
+/******************************************************************************
+* tests on destroy
+******************************************************************************/
+void
+TestThreadSafeQueue::test_destroy () {
+  thread_safe_queue<int, 4> q;
+  bool result= true;
+  std::thread consumer ([&q, &result] () {
+    int x;
+    result= q.pop (x);
+  });
+  std::this_thread::sleep_for (std::chrono::milliseconds (20));
+  q.destroy ();
+  consumer.join ();
+  QCOMPARE (result, false);
+  QCOMPARE (q.isDestroyed (), true);
+  QCOMPARE (q.push (1), false);
+}
+
+/******************************************************************************
+* tests with several producers and consumers
+******************************************************************************/
+void
+TestThreadSafeQueue::test_concurrent () {
+  const int producers= 4, consumers= 4, count= 20000;
+  thread_safe_queue<int, 8> q;
+  std::atomic<long> sum (0);
+  std::atomic<int> received (0);
+  std::vector<std::thread> threads;
+  for (int p=0; p<producers; p++)
+    threads.emplace_back ([&q] () {
+      for (int i=1; i<=count; i++) q.push (i);
+    });
+  for (int c=0; c<consumers; c++)
+    threads.emplace_back ([&q, &sum, &received] () {
+      int x;
+      for (int i=0; i<count; i++) {
+        q.pop (x);
+        sum += x;
+        received++;
+      }
+    });
+  for (auto& t: threads) t.join ();
+  QCOMPARE (received.load (), producers * count);
+  QCOMPARE (sum.load (), ((long) producers) * count * (count + 1) / 2);
+  QCOMPARE (q.getCurrentSize (), 0);
+  QVERIFY (q.getMaximalSize () <= q.getCapacity ());
+}
+
+QTEST_MAIN(TestThreadSafeQueue)
+#include "thread_safe_queue_test.moc"